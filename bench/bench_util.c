@@ -0,0 +1,265 @@
+#define _GNU_SOURCE
+
+#include "bench_util.h"
+#include "zeromesh_protocol.h"
+#include "zeromesh_capture.h"
+
+#include <storage/storage.h>
+
+#include <ftw.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+BenchFrames bench_frames;
+
+/* Every malloc/calloc/realloc in the process lands here. The per-thread
+ * count is reset by rx_frame_hook so the RX thread's share is attributed
+ * to the frame that caused it. */
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+volatile bool bench_counting;
+uint64_t bench_allocs;
+uint64_t bench_alloc_bytes;
+__thread uint32_t bench_thread_allocs;
+
+static void bench_note_alloc(size_t size) {
+    if(!bench_counting) return;
+    bench_thread_allocs++;
+    __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&bench_alloc_bytes, size, __ATOMIC_RELAXED);
+}
+
+void* malloc(size_t size) {
+    bench_note_alloc(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+    bench_note_alloc(n * size);
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    bench_note_alloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void bench_frames_alloc(void) {
+    memset(&bench_frames, 0, sizeof(bench_frames));
+    bench_frames.cap = BENCH_SAMPLES_MAX;
+    bench_frames.cycles = malloc(sizeof(uint32_t) * bench_frames.cap);
+    bench_frames.allocs = malloc(sizeof(uint32_t) * bench_frames.cap);
+}
+
+void bench_frames_free(void) {
+    free(bench_frames.cycles);
+    free(bench_frames.allocs);
+    memset(&bench_frames, 0, sizeof(bench_frames));
+}
+
+void rx_frame_hook(ZeroMeshApp* app, size_t len, uint32_t cycles) {
+    UNUSED(app);
+    uint32_t idx = bench_frames.frames;
+    if(idx < bench_frames.cap) {
+        bench_frames.cycles[idx] = cycles;
+        bench_frames.allocs[idx] = bench_thread_allocs;
+    }
+    bench_thread_allocs = 0;
+    bench_frames.frame_bytes += len;
+    bench_frames.last_ns = bench_now_ns();
+    if(idx == 0) bench_frames.first_ns = bench_frames.last_ns;
+    __atomic_store_n(&bench_frames.frames, idx + 1, __ATOMIC_RELEASE);
+}
+
+static int cmp_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+void bench_sort(uint32_t* samples, uint32_t n) {
+    qsort(samples, n, sizeof(uint32_t), cmp_u32);
+}
+
+double bench_pct(const uint32_t* sorted, uint32_t n, uint32_t pct, double scale) {
+    if(n == 0) return 0.0;
+    uint32_t idx = (uint32_t)(((uint64_t)n * pct + 99) / 100);
+    if(idx > 0) idx--;
+    return (double)sorted[idx] / scale;
+}
+
+bool bench_sd_create(char* root, size_t size) {
+    snprintf(root, size, "/tmp/zeromesh_bench.XXXXXX");
+    if(!mkdtemp(root)) return false;
+    furi_shim_storage_root(root);
+    storage_common_mkdir(NULL, "/ext/zeromesh");
+    return true;
+}
+
+static int bench_unlink(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+    UNUSED(st);
+    UNUSED(flag);
+    UNUSED(ftw);
+    return remove(path);
+}
+
+void bench_sd_remove(const char* root) {
+    nftw(root, bench_unlink, 8, FTW_DEPTH | FTW_PHYS);
+}
+
+static void syn_varint(SynBuf* b, uint64_t v) {
+    do {
+        uint8_t byte = v & 0x7F;
+        v >>= 7;
+        if(v) byte |= 0x80;
+        if(b->len < sizeof(b->buf)) b->buf[b->len++] = byte;
+    } while(v);
+}
+
+static void syn_tag(SynBuf* b, uint32_t field, uint8_t wire_type) {
+    syn_varint(b, ((uint64_t)field << 3) | wire_type);
+}
+
+static void syn_uint(SynBuf* b, uint32_t field, uint64_t v) {
+    syn_tag(b, field, PB_WT_VARINT);
+    syn_varint(b, v);
+}
+
+static void syn_fixed32(SynBuf* b, uint32_t field, uint32_t v) {
+    syn_tag(b, field, PB_WT_32BIT);
+    for(int i = 0; i < 4; i++) {
+        if(b->len < sizeof(b->buf)) b->buf[b->len++] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static void syn_float(SynBuf* b, uint32_t field, float f) {
+    uint32_t v;
+    memcpy(&v, &f, sizeof(v));
+    syn_fixed32(b, field, v);
+}
+
+static void syn_bytes(SynBuf* b, uint32_t field, const void* data, size_t len) {
+    syn_tag(b, field, PB_WT_STRING);
+    syn_varint(b, len);
+    if(b->len + len > sizeof(b->buf)) len = sizeof(b->buf) - b->len;
+    memcpy(b->buf + b->len, data, len);
+    b->len += len;
+}
+
+void syn_packet(SynBuf* out, uint32_t i, uint32_t from) {
+    SynBuf payload = {0};
+    uint32_t port;
+    char text[64];
+
+    if(i % 10 == 0) {
+        char id[12];
+        char long_name[24];
+        char short_name[5];
+        snprintf(id, sizeof(id), "!%08lx", (unsigned long)from);
+        snprintf(long_name, sizeof(long_name), "Bench Node %lu", (unsigned long)(from & 0xFFFF));
+        snprintf(short_name, sizeof(short_name), "B%03lu", (unsigned long)((from & 0xFFFF) % 1000));
+        syn_bytes(&payload, meshtastic_User_id_tag, id, strlen(id));
+        syn_bytes(&payload, meshtastic_User_long_name_tag, long_name, strlen(long_name));
+        syn_bytes(&payload, meshtastic_User_short_name_tag, short_name, strlen(short_name));
+        port = meshtastic_PortNum_NODEINFO_APP;
+    } else if(i % 7 == 0) {
+        SynBuf metrics = {0};
+        syn_uint(&metrics, meshtastic_DeviceMetrics_battery_level_tag, 50 + i % 50);
+        syn_float(&metrics, meshtastic_DeviceMetrics_voltage_tag, 3.7f + (float)(i % 5) / 10.0f);
+        syn_bytes(&payload, meshtastic_Telemetry_device_metrics_tag, metrics.buf, metrics.len);
+        port = meshtastic_PortNum_TELEMETRY_APP;
+    } else {
+        snprintf(text, sizeof(text), "bench message %lu", (unsigned long)i);
+        memcpy(payload.buf, text, strlen(text));
+        payload.len = strlen(text);
+        port = meshtastic_PortNum_TEXT_MESSAGE_APP;
+    }
+
+    SynBuf data = {0};
+    syn_uint(&data, meshtastic_Data_portnum_tag, port);
+    syn_bytes(&data, meshtastic_Data_payload_tag, payload.buf, payload.len);
+
+    SynBuf pkt = {0};
+    syn_fixed32(&pkt, meshtastic_MeshPacket_from_tag, from);
+    syn_fixed32(&pkt, meshtastic_MeshPacket_to_tag, 0xFFFFFFFF);
+    syn_bytes(&pkt, meshtastic_MeshPacket_decoded_tag, data.buf, data.len);
+    syn_fixed32(&pkt, meshtastic_MeshPacket_id_tag, i + 1);
+    syn_float(&pkt, meshtastic_MeshPacket_rx_snr_tag, (float)(i % 20) - 5.0f);
+    syn_uint(&pkt, meshtastic_MeshPacket_hop_limit_tag, 3);
+    syn_uint(&pkt, meshtastic_MeshPacket_rx_rssi_tag, (uint64_t)(int64_t)(-40 - (int32_t)(i % 80)));
+
+    out->len = 0;
+    syn_uint(out, meshtastic_FromRadio_id_tag, i + 1);
+    syn_bytes(out, meshtastic_FromRadio_packet_tag, pkt.buf, pkt.len);
+}
+
+void syn_my_info(SynBuf* out, uint32_t node_num) {
+    SynBuf info = {0};
+    syn_uint(&info, meshtastic_MyNodeInfo_my_node_num_tag, node_num);
+    out->len = 0;
+    syn_bytes(out, meshtastic_FromRadio_my_info_tag, info.buf, info.len);
+}
+
+void syn_config_done(SynBuf* out, uint32_t nonce) {
+    out->len = 0;
+    syn_uint(out, meshtastic_FromRadio_config_complete_id_tag, nonce);
+}
+
+void syn_queue_status(SynBuf* out, int32_t res, uint32_t free, uint32_t maxlen, uint32_t packet_id) {
+    SynBuf qs = {0};
+    syn_uint(&qs, meshtastic_QueueStatus_res_tag, (uint64_t)(int64_t)res);
+    syn_uint(&qs, meshtastic_QueueStatus_free_tag, free);
+    syn_uint(&qs, meshtastic_QueueStatus_maxlen_tag, maxlen);
+    syn_uint(&qs, meshtastic_QueueStatus_mesh_packet_id_tag, packet_id);
+    out->len = 0;
+    syn_bytes(out, meshtastic_FromRadio_queueStatus_tag, qs.buf, qs.len);
+}
+
+size_t syn_frame(const SynBuf* body, uint8_t* out) {
+    out[0] = ZEROMESH_MAGIC0;
+    out[1] = ZEROMESH_MAGIC1;
+    out[2] = (uint8_t)(body->len >> 8);
+    out[3] = (uint8_t)body->len;
+    memcpy(out + 4, body->buf, body->len);
+    return body->len + 4;
+}
+
+static bool syn_write_frame(FILE* fp, const SynBuf* body, uint32_t ms) {
+    uint8_t frame[MAX_FRAME_SIZE + 4];
+    size_t total = syn_frame(body, frame);
+    for(size_t off = 0; off < total; off += RX_CHUNK_SIZE) {
+        size_t n = total - off > RX_CHUNK_SIZE ? RX_CHUNK_SIZE : total - off;
+        CaptureRecord rec = {.ms = ms, .len = (uint16_t)n};
+        if(fwrite(&rec, sizeof(rec), 1, fp) != 1 || fwrite(frame + off, 1, n, fp) != n) return false;
+    }
+    return true;
+}
+
+bool syn_capture(const char* path, uint32_t count) {
+    FILE* fp = fopen(path, "wb");
+    if(!fp) return false;
+    CaptureHeader hdr = {.magic = CAPTURE_MAGIC, .baud = 115200};
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+
+    SynBuf body;
+    syn_my_info(&body, 0x0BE4C400);
+    ok = ok && syn_write_frame(fp, &body, 0);
+    syn_config_done(&body, CONFIG_NONCE);
+    ok = ok && syn_write_frame(fp, &body, 0);
+
+    for(uint32_t i = 0; ok && i < count; i++) {
+        syn_packet(&body, i, 0x10000000 + i % BENCH_NODES);
+        ok = syn_write_frame(fp, &body, (i + 1) * BENCH_GAP_MS);
+    }
+    return fclose(fp) == 0 && ok;
+}
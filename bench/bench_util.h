@@ -0,0 +1,58 @@
+#pragma once
+
+/* Shared helpers for the host benchmarks: timing, percentiles, heap
+ * accounting, a private SD card root and a synthetic capture writer */
+
+#include "zeromesh_serial.h"
+
+#include <stdio.h>
+
+#define BENCH_SAMPLES_MAX 1000000
+#define BENCH_GAP_MS      20
+#define BENCH_NODES       40
+
+typedef struct {
+    uint32_t* cycles;
+    uint32_t* allocs;
+    uint32_t cap;
+    volatile uint32_t frames;
+    uint64_t frame_bytes;
+    uint64_t first_ns;
+    uint64_t last_ns;
+} BenchFrames;
+
+/* Filled by rx_frame_hook once bench_frames_alloc() has been called */
+extern BenchFrames bench_frames;
+
+/* Heap calls made while bench_counting is set */
+extern volatile bool bench_counting;
+extern uint64_t bench_allocs;
+extern uint64_t bench_alloc_bytes;
+extern __thread uint32_t bench_thread_allocs;
+
+uint64_t bench_now_ns(void);
+void bench_frames_alloc(void);
+void bench_frames_free(void);
+
+void bench_sort(uint32_t* samples, uint32_t n);
+/* pct percentile of sorted samples, divided by scale */
+double bench_pct(const uint32_t* sorted, uint32_t n, uint32_t pct, double scale);
+
+/* Creates a temporary directory and maps /ext onto it */
+bool bench_sd_create(char* root, size_t size);
+void bench_sd_remove(const char* root);
+
+typedef struct {
+    uint8_t buf[MAX_FRAME_SIZE];
+    size_t len;
+} SynBuf;
+
+/* FromRadio body for packet i of the synthetic mix: every 10th is a
+ * nodeinfo, every 7th telemetry, the rest text messages */
+void syn_packet(SynBuf* out, uint32_t i, uint32_t from);
+void syn_my_info(SynBuf* out, uint32_t node_num);
+void syn_config_done(SynBuf* out, uint32_t nonce);
+void syn_queue_status(SynBuf* out, int32_t res, uint32_t free, uint32_t maxlen, uint32_t packet_id);
+/* Frames body with the serial header into out, returns the frame length */
+size_t syn_frame(const SynBuf* body, uint8_t* out);
+bool syn_capture(const char* path, uint32_t count);
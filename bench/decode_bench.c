@@ -0,0 +1,315 @@
+/* Host benchmark: cuts the FromRadio frames out of a .bin serial capture and
+ * decodes the corpus two ways, through the zeromesh_wire.c walkers the RX
+ * thread uses and through the pb_decode-then-rewalk decoder they replaced.
+ * Checks both extract the same packet fields, then reports cycles per frame.
+ * Linked against the full generated meshtastic tables, which the old decoder
+ * needs for meshtastic_FromRadio. */
+
+#define _GNU_SOURCE
+
+#include "bench_util.h"
+#include "zeromesh_capture.h"
+#include "zeromesh_wire.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PAYLOAD_CAPTURE_MAX 256
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_UNIT "cycles"
+static inline uint64_t bench_cycles(void) {
+    return __builtin_ia32_rdtsc();
+}
+#else
+#define BENCH_UNIT "ns"
+static inline uint64_t bench_cycles(void) {
+    return bench_now_ns();
+}
+#endif
+
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    uint32_t* off;
+    uint16_t* frame_len;
+    uint32_t frames;
+    uint32_t cap;
+} Corpus;
+
+/* What decode_fromradio hands on for a packet */
+typedef struct {
+    pb_size_t variant;
+    uint32_t from;
+    uint32_t to;
+    uint32_t id;
+    float rx_snr;
+    int32_t rx_rssi;
+    meshtastic_PortNum portnum;
+    uint8_t payload[PAYLOAD_CAPTURE_MAX];
+    size_t payload_len;
+} Decoded;
+
+typedef struct {
+    uint8_t buf[PAYLOAD_CAPTURE_MAX];
+    size_t len;
+} PayloadCapture;
+
+static bool corpus_add(Corpus* c, const uint8_t* frame, size_t len) {
+    if(c->frames == c->cap) {
+        c->cap = c->cap ? c->cap * 2 : 1024;
+        c->off = realloc(c->off, c->cap * sizeof(uint32_t));
+        c->frame_len = realloc(c->frame_len, c->cap * sizeof(uint16_t));
+        c->data = realloc(c->data, (size_t)c->cap * MAX_FRAME_SIZE);
+    }
+    c->off[c->frames] = (uint32_t)c->len;
+    c->frame_len[c->frames] = (uint16_t)len;
+    memcpy(c->data + c->len, frame, len);
+    c->len += len;
+    c->frames++;
+    return true;
+}
+
+/* Runs the capture's bytes through framing_scan, as rx_thread_fn does */
+static bool corpus_load(Corpus* c, const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if(!fp) return false;
+    CaptureHeader hdr;
+    CaptureRecord rec;
+    uint8_t buf[RX_SPAN_SIZE];
+    FrameState fs;
+    framing_init(&fs);
+
+    bool ok = fread(&hdr, sizeof(hdr), 1, fp) == 1 && hdr.magic == CAPTURE_MAGIC;
+    while(ok && fread(&rec, sizeof(rec), 1, fp) == 1) {
+        if(rec.len > sizeof(buf) || fread(buf, 1, rec.len, fp) != rec.len) break;
+        size_t off = 0;
+        while(off < rec.len || fs.replay_len > 0) {
+            const uint8_t* frame;
+            off += framing_scan(&fs, buf + off, rec.len - off, &frame);
+            if(frame) {
+                corpus_add(c, frame, fs.frame_len);
+                framing_reset(&fs);
+            }
+        }
+    }
+    fclose(fp);
+    return ok;
+}
+
+static void corpus_free(Corpus* c) {
+    free(c->data);
+    free(c->off);
+    free(c->frame_len);
+}
+
+static bool wants_payload(void* ctx, meshtastic_PortNum port) {
+    (void)ctx;
+    return port == meshtastic_PortNum_TEXT_MESSAGE_APP || port == meshtastic_PortNum_TELEMETRY_APP;
+}
+
+/* The single pass: walk_fromradio, walk_packet and walk_data */
+static bool decode_walk(const uint8_t* frame, size_t len, Decoded* out) {
+    FromRadioView view;
+    if(!walk_fromradio(frame, len, &view)) return false;
+    out->variant = view.variant;
+    if(view.variant != meshtastic_FromRadio_packet_tag) return true;
+
+    PacketView pkt = {0};
+    const uint8_t* data = NULL;
+    size_t data_len = 0;
+    if(!walk_packet(view.body, view.body_len, &pkt, &data, &data_len)) return false;
+    if(pkt.has_decoded && !walk_data(data, data_len, &pkt, wants_payload, NULL)) return false;
+
+    out->from = pkt.from;
+    out->to = pkt.to;
+    out->id = pkt.id;
+    out->rx_snr = pkt.rx_snr;
+    out->rx_rssi = pkt.rx_rssi;
+    out->portnum = pkt.portnum;
+    out->payload_len = pkt.payload_len > PAYLOAD_CAPTURE_MAX ? PAYLOAD_CAPTURE_MAX : pkt.payload_len;
+    if(out->payload_len) memcpy(out->payload, pkt.payload, out->payload_len);
+    return true;
+}
+
+static bool payload_decode_cb(pb_istream_t* stream, const pb_field_t* field, void** arg) {
+    (void)field;
+    PayloadCapture* cap = (PayloadCapture*)(*arg);
+    size_t n = stream->bytes_left;
+    if(n > PAYLOAD_CAPTURE_MAX) n = PAYLOAD_CAPTURE_MAX;
+    cap->len = n;
+    if(n > 0 && !pb_read(stream, cap->buf, n)) return false;
+    return pb_read(stream, NULL, stream->bytes_left);
+}
+
+/* The old two passes: pb_decode of the whole FromRadio, then a re-walk of
+ * the same frame down to Data to capture the payload through a callback */
+static bool decode_two_pass(const uint8_t* frame, size_t len, Decoded* out) {
+    meshtastic_FromRadio from = meshtastic_FromRadio_init_default;
+    pb_istream_t is = pb_istream_from_buffer(frame, len);
+    if(!pb_decode(&is, meshtastic_FromRadio_fields, &from)) return false;
+    out->variant = from.which_payload_variant;
+    if(from.which_payload_variant != meshtastic_FromRadio_packet_tag) return true;
+
+    const meshtastic_MeshPacket* p = &from.payload_variant.packet;
+    out->from = p->from;
+    out->to = p->to;
+    out->id = p->id;
+    out->rx_snr = p->rx_snr;
+    out->rx_rssi = p->rx_rssi;
+    if(p->which_payload_variant != meshtastic_MeshPacket_decoded_tag) return true;
+    out->portnum = p->payload_variant.decoded.portnum;
+    if(!wants_payload(NULL, out->portnum)) return true;
+
+    PayloadCapture cap = {0};
+    pb_istream_t walk = pb_istream_from_buffer(frame, len);
+    while(walk.bytes_left > 0) {
+        pb_wire_type_t wt;
+        uint32_t tag;
+        bool eof;
+        if(!pb_decode_tag(&walk, &wt, &tag, &eof) || eof) break;
+        if(tag != meshtastic_FromRadio_packet_tag || wt != PB_WT_STRING) {
+            if(!pb_skip_field(&walk, wt)) break;
+            continue;
+        }
+        pb_istream_t pkt;
+        if(!pb_make_string_substream(&walk, &pkt)) break;
+        while(pkt.bytes_left > 0) {
+            if(!pb_decode_tag(&pkt, &wt, &tag, &eof) || eof) break;
+            if(tag != meshtastic_MeshPacket_decoded_tag || wt != PB_WT_STRING) {
+                if(!pb_skip_field(&pkt, wt)) break;
+                continue;
+            }
+            meshtastic_Data data = meshtastic_Data_init_default;
+            data.payload.funcs.decode = payload_decode_cb;
+            data.payload.arg = &cap;
+            pb_istream_t ds;
+            if(pb_make_string_substream(&pkt, &ds)) pb_decode(&ds, meshtastic_Data_fields, &data);
+            break;
+        }
+        break;
+    }
+    out->payload_len = cap.len;
+    memcpy(out->payload, cap.buf, cap.len);
+    return true;
+}
+
+static bool decoded_equal(const Decoded* a, const Decoded* b) {
+    return a->variant == b->variant && a->from == b->from && a->to == b->to && a->id == b->id &&
+           memcmp(&a->rx_snr, &b->rx_snr, sizeof(float)) == 0 && a->rx_rssi == b->rx_rssi &&
+           a->portnum == b->portnum && a->payload_len == b->payload_len &&
+           memcmp(a->payload, b->payload, a->payload_len) == 0;
+}
+
+typedef bool (*DecodeFn)(const uint8_t* frame, size_t len, Decoded* out);
+
+/* Per-frame samples from the first round, mean over all of them */
+static double run_decoder(const Corpus* c, DecodeFn fn, uint32_t rounds, uint32_t* samples, uint32_t* failed) {
+    Decoded out;
+    uint64_t total = 0;
+    *failed = 0;
+    for(uint32_t r = 0; r < rounds; r++) {
+        for(uint32_t i = 0; i < c->frames; i++) {
+            memset(&out, 0, offsetof(Decoded, payload));
+            uint64_t t0 = bench_cycles();
+            bool ok = fn(c->data + c->off[i], c->frame_len[i], &out);
+            uint64_t dt = bench_cycles() - t0;
+            total += dt;
+            if(r == 0) {
+                samples[i] = (uint32_t)dt;
+                if(!ok) (*failed)++;
+            }
+        }
+    }
+    return (double)total / ((double)c->frames * rounds);
+}
+
+static void usage(const char* argv0) {
+    fprintf(
+        stderr,
+        "usage: %s [-r rounds] [-g frames] capture.bin\n"
+        "  -r rounds  passes over the corpus per decoder (default 20)\n"
+        "  -g frames  first write a synthetic capture with this many packets to capture.bin\n",
+        argv0);
+}
+
+int main(int argc, char** argv) {
+    uint32_t rounds = 20;
+    long synth = -1;
+    int opt;
+    while((opt = getopt(argc, argv, "r:g:h")) != -1) {
+        switch(opt) {
+        case 'r':
+            rounds = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'g':
+            synth = strtol(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if(optind != argc - 1 || rounds == 0 || synth == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char* capture = argv[optind];
+
+    if(synth > 0 && !syn_capture(capture, (uint32_t)synth)) {
+        fprintf(stderr, "cannot write %s\n", capture);
+        return 1;
+    }
+    Corpus c = {0};
+    if(!corpus_load(&c, capture) || c.frames == 0 || c.frames > BENCH_SAMPLES_MAX) {
+        fprintf(stderr, "no frames in %s\n", capture);
+        corpus_free(&c);
+        return 1;
+    }
+
+    uint32_t packets = 0;
+    uint32_t mismatched = 0;
+    for(uint32_t i = 0; i < c.frames; i++) {
+        Decoded a = {0};
+        Decoded b = {0};
+        bool ok_a = decode_walk(c.data + c.off[i], c.frame_len[i], &a);
+        bool ok_b = decode_two_pass(c.data + c.off[i], c.frame_len[i], &b);
+        if(ok_a != ok_b || (ok_a && !decoded_equal(&a, &b))) mismatched++;
+        if(a.variant == meshtastic_FromRadio_packet_tag) packets++;
+    }
+    printf("corpus     %s: %lu frames, %lu packets, %.1f B/frame, %lu decoded differently\n",
+           capture,
+           (unsigned long)c.frames,
+           (unsigned long)packets,
+           (double)c.len / c.frames,
+           (unsigned long)mismatched);
+
+    uint32_t* samples = malloc(c.frames * sizeof(uint32_t));
+    uint32_t failed;
+    double walk_mean = run_decoder(&c, decode_walk, rounds, samples, &failed);
+    bench_sort(samples, c.frames);
+    printf("walk       %.0f %s/frame  p50 %.0f  p99 %.0f  max %.0f, %lu failed\n",
+           walk_mean,
+           BENCH_UNIT,
+           bench_pct(samples, c.frames, 50, 1.0),
+           bench_pct(samples, c.frames, 99, 1.0),
+           bench_pct(samples, c.frames, 100, 1.0),
+           (unsigned long)failed);
+
+    double two_mean = run_decoder(&c, decode_two_pass, rounds, samples, &failed);
+    bench_sort(samples, c.frames);
+    printf("two-pass   %.0f %s/frame  p50 %.0f  p99 %.0f  max %.0f, %lu failed\n",
+           two_mean,
+           BENCH_UNIT,
+           bench_pct(samples, c.frames, 50, 1.0),
+           bench_pct(samples, c.frames, 99, 1.0),
+           bench_pct(samples, c.frames, 100, 1.0),
+           (unsigned long)failed);
+    printf("speedup    %.2fx\n", walk_mean > 0 ? two_mean / walk_mean : 0.0);
+
+    free(samples);
+    corpus_free(&c);
+    return mismatched ? 1 : 0;
+}
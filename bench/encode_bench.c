@@ -0,0 +1,254 @@
+/* Host benchmark: encodes and frames each kind of outbound ToRadio message,
+ * once through tx_encode into a pooled TX slot and once the way send_frame
+ * did before it (a MAX_FRAME_SIZE stack buffer and separate header and body
+ * writes), and reports how long the caller is held, serial writes and stack
+ * use per message. Serial writes block for the bytes' time on the wire at
+ * the given baud, as furi_hal_serial_tx does on the device. The TX worker
+ * runs; the serial shim answers each packet with a QueueStatus so it hands
+ * its slot straight back. */
+
+#define _GNU_SOURCE
+
+#include "bench_util.h"
+#include "zeromesh_app.h"
+#include "zeromesh_tx.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_STACK_SIZE  (64 * 1024)
+#define BENCH_STACK_PAINT 0xA5
+
+typedef enum {
+    KindTextShort,
+    KindTextLong,
+    KindWantConfig,
+    KindHeartbeat,
+    KindCount,
+} Kind;
+
+static const char* const kind_names[KindCount] = {"text 2 B", "text 127 B", "want_config", "heartbeat"};
+
+typedef struct {
+    const uint8_t* buf;
+    size_t len;
+} PayloadSend;
+
+typedef uint32_t (*EncodeFn)(ZeroMeshApp* app, Kind kind);
+
+typedef struct {
+    EncodeFn fn;
+    ZeroMeshApp* app;
+    Kind kind;
+} StackRun;
+
+static char long_text[MSG_TEXT_LEN];
+static volatile uint32_t serial_writes;
+static uint32_t wire_baud = 115200;
+
+static bool payload_encode_cb(pb_ostream_t* stream, const pb_field_t* field, void* const* arg) {
+    const PayloadSend* ps = (const PayloadSend*)(*arg);
+    if(!pb_encode_tag_for_field(stream, field)) return false;
+    return pb_encode_string(stream, ps->buf, ps->len);
+}
+
+/* Fills to the way send_text_message, request_info and send_heartbeat do,
+ * returns the packet id or 0 */
+static uint32_t build(meshtastic_ToRadio* to, PayloadSend* ps, Kind kind) {
+    *to = (meshtastic_ToRadio)meshtastic_ToRadio_init_default;
+    if(kind == KindWantConfig) {
+        to->which_payload_variant = meshtastic_ToRadio_want_config_id_tag;
+        to->payload_variant.want_config_id = CONFIG_NONCE;
+        return 0;
+    }
+    if(kind == KindHeartbeat) {
+        to->which_payload_variant = meshtastic_ToRadio_heartbeat_tag;
+        return 0;
+    }
+
+    const char* text = kind == KindTextLong ? long_text : "ok";
+    to->which_payload_variant = meshtastic_ToRadio_packet_tag;
+    meshtastic_MeshPacket* p = &to->payload_variant.packet;
+    p->to = 0xFFFFFFFF;
+    p->id = (uint32_t)furi_hal_random_get() | 1;
+    p->hop_limit = 3;
+    p->want_ack = true;
+    p->which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    meshtastic_Data* d = &p->payload_variant.decoded;
+    d->portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+    ps->buf = (const uint8_t*)text;
+    ps->len = strlen(text);
+    d->payload.funcs.encode = payload_encode_cb;
+    d->payload.arg = ps;
+    return p->id;
+}
+
+static __attribute__((noinline)) uint32_t encode_pooled(ZeroMeshApp* app, Kind kind) {
+    meshtastic_ToRadio to;
+    PayloadSend ps;
+    uint32_t id = build(&to, &ps, kind);
+    return tx_encode(app, meshtastic_ToRadio_fields, &to, id) == TxOk;
+}
+
+/* send_frame and the stack buffer it was handed, before tx_encode */
+static __attribute__((noinline)) uint32_t encode_old(ZeroMeshApp* app, Kind kind) {
+    meshtastic_ToRadio to;
+    PayloadSend ps;
+    build(&to, &ps, kind);
+    uint8_t buf[MAX_FRAME_SIZE];
+    pb_ostream_t os = pb_ostream_from_buffer(buf, sizeof(buf));
+    if(!pb_encode(&os, meshtastic_ToRadio_fields, &to)) return 0;
+    size_t len = os.bytes_written;
+    uint8_t hdr[4] = {ZEROMESH_MAGIC0, ZEROMESH_MAGIC1, (uint8_t)((len >> 8) & 0xFF), (uint8_t)(len & 0xFF)};
+    furi_hal_serial_tx(app->serial, hdr, sizeof(hdr));
+    furi_hal_serial_tx(app->serial, buf, len);
+    return 1;
+}
+
+static __attribute__((noinline)) uint32_t encode_none(ZeroMeshApp* app, Kind kind) {
+    UNUSED(app);
+    return kind;
+}
+
+/* Stands in for the UART and the radio: holds the writer for the bytes'
+ * wire time, asleep so a held worker leaves the CPU to the caller, and
+ * acknowledges every packet as it is written */
+static void on_tx(const uint8_t* data, size_t len, void* ctx) {
+    ZeroMeshApp* app = ctx;
+    serial_writes++;
+    if(wire_baud) {
+        uint64_t ns = (uint64_t)len * 10ULL * 1000000000ULL / wire_baud;
+        struct timespec ts = {.tv_sec = (time_t)(ns / 1000000000ULL), .tv_nsec = (long)(ns % 1000000000ULL)};
+        nanosleep(&ts, NULL);
+    }
+    for(uint8_t slot = 0; slot < TX_QUEUE_SIZE; slot++) {
+        TxFrame* f = &app->tx_pool[slot];
+        if(data == f->frame && f->packet_id) tx_queue_status(app, 0, TX_QUEUE_SIZE, TX_QUEUE_SIZE, f->packet_id);
+    }
+}
+
+static void tx_idle(ZeroMeshApp* app) {
+    while(furi_message_queue_get_count(app->tx_free) != TX_QUEUE_SIZE) sched_yield();
+}
+
+static void* stack_run_fn(void* ctx) {
+    StackRun* run = ctx;
+    run->fn(run->app, run->kind);
+    return NULL;
+}
+
+/* Deepest point one call reaches on a painted thread stack */
+static size_t stack_depth(EncodeFn fn, ZeroMeshApp* app, Kind kind) {
+    uint8_t* stack = malloc(BENCH_STACK_SIZE);
+    memset(stack, BENCH_STACK_PAINT, BENCH_STACK_SIZE);
+    StackRun run = {.fn = fn, .app = app, .kind = kind};
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, BENCH_STACK_SIZE);
+    pthread_create(&thread, &attr, stack_run_fn, &run);
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+
+    size_t untouched = 0;
+    while(untouched < BENCH_STACK_SIZE && stack[untouched] == BENCH_STACK_PAINT) untouched++;
+    free(stack);
+    return BENCH_STACK_SIZE - untouched;
+}
+
+static void usage(const char* argv0) {
+    fprintf(
+        stderr,
+        "usage: %s [-n messages] [-u baud]\n"
+        "  -n messages  encodes timed per kind and path (default 2000)\n"
+        "  -u baud      wire time serial writes block for, 0 = none (default 115200)\n",
+        argv0);
+}
+
+int main(int argc, char** argv) {
+    uint32_t count = 2000;
+    int opt;
+    while((opt = getopt(argc, argv, "n:u:h")) != -1) {
+        switch(opt) {
+        case 'n':
+            count = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'u':
+            wire_baud = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if(optind != argc || count == 0 || count > BENCH_SAMPLES_MAX) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    char root[64];
+    if(!bench_sd_create(root, sizeof(root))) {
+        perror("mkdtemp");
+        return 1;
+    }
+    memset(long_text, 'x', sizeof(long_text) - 1);
+    ZeroMeshApp* app = app_alloc();
+    app_start(app);
+    furi_shim_serial_on_tx(on_tx, app);
+    tx_idle(app);
+
+    static const EncodeFn paths[] = {encode_pooled, encode_old};
+    static const char* const path_names[] = {"pooled", "old"};
+    uint32_t* samples = malloc(count * sizeof(uint32_t));
+    size_t base = stack_depth(encode_none, app, KindCount);
+    uint32_t failed = 0;
+
+    for(size_t p = 0; p < COUNT_OF(paths); p++) {
+        for(Kind kind = KindTextShort; kind < KindCount; kind++) {
+            uint32_t writes = 0;
+            for(uint32_t i = 0; i < count; i++) {
+                tx_idle(app);
+                uint32_t before = serial_writes;
+                uint64_t t0 = bench_now_ns();
+                if(!paths[p](app, kind)) failed++;
+                samples[i] = (uint32_t)(bench_now_ns() - t0);
+                tx_idle(app);
+                writes += serial_writes - before;
+            }
+            /* The old path writes on the caller's thread; keep the shim's
+             * callback out of its stack */
+            tx_idle(app);
+            if(paths[p] == encode_old) furi_shim_serial_on_tx(NULL, NULL);
+            size_t stack = stack_depth(paths[p], app, kind) - base;
+            furi_shim_serial_on_tx(on_tx, app);
+            tx_idle(app);
+
+            bench_sort(samples, count);
+            printf("%-6s     %-11s caller p50 %.2f us  p99 %.2f us, %.1f writes/msg, %u B stack\n",
+                   path_names[p],
+                   kind_names[kind],
+                   bench_pct(samples, count, 50, 1000.0),
+                   bench_pct(samples, count, 99, 1000.0),
+                   (double)writes / count,
+                   (unsigned)stack);
+        }
+    }
+    printf("pool       %u slots of %u B, %lu frames written, %lu encode failures, wire %lu baud\n",
+           TX_QUEUE_SIZE,
+           (unsigned)sizeof(TxFrame),
+           (unsigned long)app->tx_frames,
+           (unsigned long)(app->tx_encode_fail + failed),
+           (unsigned long)wire_baud);
+
+    furi_shim_serial_on_tx(NULL, NULL);
+    app_stop(app);
+    free(samples);
+    app_free(app);
+    bench_sd_remove(root);
+    return 0;
+}
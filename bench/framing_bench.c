@@ -0,0 +1,313 @@
+/* Host benchmark: runs framing_scan and the byte-at-a-time framing_feed it
+ * replaced over the same synthetic serial stream, in which FromRadio frames
+ * are interleaved with line noise, stray magic bytes, impossible lengths and
+ * truncated frames. Checks both recover the same frames where the old parser
+ * could, then reports throughput and how many frames each one lost. */
+
+#define _GNU_SOURCE
+
+#include "bench_util.h"
+#include "zeromesh_wire.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef enum {
+    NoiseNone,
+    NoiseGarbage,
+    NoiseStrayMagic,
+    NoiseBadLen,
+    NoiseTruncated,
+    NoiseKindCount,
+} NoiseKind;
+
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t cap;
+    /* Offset and length of every intact frame body, in stream order */
+    uint32_t* body_off;
+    uint16_t* body_len;
+    uint32_t frames;
+    uint32_t noise[NoiseKindCount];
+} Stream;
+
+typedef struct {
+    uint32_t matched;
+    uint32_t garbled;
+    uint32_t cursor;
+} Tally;
+
+/* The per-byte parser as it stood before framing_scan, minus logging */
+typedef struct {
+    uint8_t hdr[4];
+    uint8_t hdr_pos;
+    uint16_t frame_len;
+    uint16_t frame_pos;
+    uint32_t bad_magic;
+    uint32_t bad_len;
+    uint8_t frame_buf[MAX_FRAME_SIZE];
+} LegacyFraming;
+
+static void legacy_reset(LegacyFraming* lf) {
+    lf->hdr_pos = 0;
+    lf->frame_len = 0;
+    lf->frame_pos = 0;
+}
+
+static bool legacy_feed(LegacyFraming* lf, uint8_t b) {
+    if(lf->hdr_pos < 4) {
+        lf->hdr[lf->hdr_pos++] = b;
+        if(lf->hdr_pos == 1 && lf->hdr[0] != ZEROMESH_MAGIC0) {
+            lf->bad_magic++;
+            lf->hdr_pos = 0;
+        } else if(lf->hdr_pos == 2 && lf->hdr[1] != ZEROMESH_MAGIC1) {
+            lf->bad_magic++;
+            lf->hdr_pos = 0;
+        } else if(lf->hdr_pos == 4) {
+            lf->frame_len = ((uint16_t)lf->hdr[2] << 8) | (uint16_t)lf->hdr[3];
+            lf->frame_pos = 0;
+            if(lf->frame_len == 0 || lf->frame_len > MAX_FRAME_SIZE) {
+                lf->bad_len++;
+                legacy_reset(lf);
+            }
+        }
+        return false;
+    }
+    if(lf->frame_pos < lf->frame_len) {
+        lf->frame_buf[lf->frame_pos++] = b;
+        if(lf->frame_pos == lf->frame_len) return true;
+    } else {
+        lf->bad_len++;
+        legacy_reset(lf);
+    }
+    return false;
+}
+
+static uint32_t lcg_next(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static void stream_put(Stream* s, const uint8_t* data, size_t len) {
+    if(s->len + len > s->cap) {
+        s->cap = (s->len + len) * 2;
+        s->data = realloc(s->data, s->cap);
+    }
+    memcpy(s->data + s->len, data, len);
+    s->len += len;
+}
+
+/* Noise before each frame is drawn from kinds, NoiseNone always included */
+static void stream_build(Stream* s, uint32_t frames, uint32_t kinds) {
+    uint32_t seed = 7;
+    uint8_t frame[MAX_FRAME_SIZE + 4];
+    uint8_t noise[64];
+    SynBuf body;
+
+    memset(s, 0, sizeof(*s));
+    s->body_off = malloc(frames * sizeof(uint32_t));
+    s->body_len = malloc(frames * sizeof(uint16_t));
+
+    for(uint32_t i = 0; i < frames; i++) {
+        syn_packet(&body, i, 0x10000000 + i % BENCH_NODES);
+        size_t total = syn_frame(&body, frame);
+
+        NoiseKind kind = (NoiseKind)(lcg_next(&seed) % NoiseKindCount);
+        if(!(kinds & (1u << kind))) kind = NoiseNone;
+        s->noise[kind]++;
+        switch(kind) {
+        case NoiseGarbage: {
+            size_t n = 1 + lcg_next(&seed) % sizeof(noise);
+            for(size_t j = 0; j < n; j++) {
+                noise[j] = (uint8_t)lcg_next(&seed);
+                if(noise[j] == ZEROMESH_MAGIC0) noise[j] = 0;
+            }
+            stream_put(s, noise, n);
+            break;
+        }
+        case NoiseStrayMagic:
+            noise[0] = ZEROMESH_MAGIC0;
+            noise[1] = (uint8_t)(lcg_next(&seed) % ZEROMESH_MAGIC0);
+            stream_put(s, noise, 2);
+            break;
+        case NoiseBadLen:
+            noise[0] = ZEROMESH_MAGIC0;
+            noise[1] = ZEROMESH_MAGIC1;
+            noise[2] = 0xFF;
+            noise[3] = (uint8_t)lcg_next(&seed);
+            stream_put(s, noise, 4);
+            break;
+        case NoiseTruncated:
+            /* The header and part of the body of a frame cut off mid-line */
+            stream_put(s, frame, 4 + 1 + lcg_next(&seed) % (body.len - 1));
+            break;
+        default:
+            break;
+        }
+
+        s->body_off[s->frames] = (uint32_t)(s->len + 4);
+        s->body_len[s->frames] = (uint16_t)body.len;
+        s->frames++;
+        stream_put(s, frame, total);
+    }
+}
+
+static void stream_free(Stream* s) {
+    free(s->data);
+    free(s->body_off);
+    free(s->body_len);
+}
+
+/* Matches a recovered frame against the intact frames the parser has got
+ * past by stream offset consumed, skipping the ones it lost */
+static void tally_frame(Tally* t, const Stream* s, const uint8_t* frame, size_t len, size_t consumed) {
+    for(uint32_t j = t->cursor; j < s->frames && s->body_off[j] < consumed; j++) {
+        if(s->body_len[j] == len && memcmp(s->data + s->body_off[j], frame, len) == 0) {
+            t->matched++;
+            t->cursor = j + 1;
+            return;
+        }
+    }
+    t->garbled++;
+}
+
+/* Fed in RX_SPAN_SIZE reads, as rx_thread_fn does */
+static uint64_t run_scan(const Stream* s, FrameState* fs, Tally* t) {
+    uint64_t t0 = bench_now_ns();
+    for(size_t pos = 0; pos < s->len; pos += RX_SPAN_SIZE) {
+        size_t n = s->len - pos < RX_SPAN_SIZE ? s->len - pos : RX_SPAN_SIZE;
+        size_t off = 0;
+        while(off < n || fs->replay_len > 0) {
+            const uint8_t* frame;
+            off += framing_scan(fs, s->data + pos + off, n - off, &frame);
+            if(frame) {
+                if(t) tally_frame(t, s, frame, fs->frame_len, pos + off);
+                framing_reset(fs);
+            }
+        }
+    }
+    return bench_now_ns() - t0;
+}
+
+static uint64_t run_legacy(const Stream* s, LegacyFraming* lf, Tally* t) {
+    uint64_t t0 = bench_now_ns();
+    for(size_t pos = 0; pos < s->len; pos++) {
+        if(legacy_feed(lf, s->data[pos])) {
+            if(t) tally_frame(t, s, lf->frame_buf, lf->frame_len, pos + 1);
+            legacy_reset(lf);
+        }
+    }
+    return bench_now_ns() - t0;
+}
+
+static void usage(const char* argv0) {
+    fprintf(
+        stderr,
+        "usage: %s [-n frames] [-r rounds]\n"
+        "  -n frames  frames in the synthetic stream (default 20000)\n"
+        "  -r rounds  timed passes over the stream per parser (default 20)\n",
+        argv0);
+}
+
+int main(int argc, char** argv) {
+    uint32_t frames = 20000;
+    uint32_t rounds = 20;
+    int opt;
+    while((opt = getopt(argc, argv, "n:r:h")) != -1) {
+        switch(opt) {
+        case 'n':
+            frames = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            rounds = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if(optind != argc || frames == 0 || rounds == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    uint32_t failures = 0;
+    Stream s;
+    FrameState fs = {0};
+    LegacyFraming lf = {0};
+    Tally scan_t = {0};
+    Tally legacy_t = {0};
+
+    /* Noise the old parser also survives: both must recover every frame */
+    stream_build(&s, frames, (1u << NoiseGarbage) | (1u << NoiseStrayMagic) | (1u << NoiseBadLen));
+    framing_init(&fs);
+    run_scan(&s, &fs, &scan_t);
+    run_legacy(&s, &lf, &legacy_t);
+    if(scan_t.matched != s.frames || scan_t.garbled || legacy_t.matched != s.frames || legacy_t.garbled) failures++;
+    printf("agree      %lu frames: scan %lu found %lu garbled, per-byte %lu found %lu garbled%s\n",
+           (unsigned long)s.frames,
+           (unsigned long)scan_t.matched,
+           (unsigned long)scan_t.garbled,
+           (unsigned long)legacy_t.matched,
+           (unsigned long)legacy_t.garbled,
+           failures ? " (FAIL)" : "");
+    stream_free(&s);
+
+    /* Every kind of noise, truncated frames included */
+    stream_build(&s, frames, ~0u);
+    printf("stream     %lu B, %lu frames, noise: %lu garbage, %lu stray magic, %lu bad len, %lu truncated\n",
+           (unsigned long)s.len,
+           (unsigned long)s.frames,
+           (unsigned long)s.noise[NoiseGarbage],
+           (unsigned long)s.noise[NoiseStrayMagic],
+           (unsigned long)s.noise[NoiseBadLen],
+           (unsigned long)s.noise[NoiseTruncated]);
+
+    memset(&scan_t, 0, sizeof(scan_t));
+    memset(&legacy_t, 0, sizeof(legacy_t));
+    memset(&fs, 0, sizeof(fs));
+    memset(&lf, 0, sizeof(lf));
+    framing_init(&fs);
+    run_scan(&s, &fs, &scan_t);
+    run_legacy(&s, &lf, &legacy_t);
+    /* A truncated frame spliced onto the next one can still pass
+     * frame_check when its cut falls inside the packet field, so garbled
+     * frames are reported rather than failed on; decode rejects them */
+    if(scan_t.matched < legacy_t.matched) failures++;
+
+    uint64_t scan_ns = 0;
+    uint64_t legacy_ns = 0;
+    for(uint32_t r = 0; r < rounds; r++) {
+        FrameState fs_r;
+        LegacyFraming lf_r = {0};
+        framing_init(&fs_r);
+        scan_ns += run_scan(&s, &fs_r, NULL);
+        legacy_ns += run_legacy(&s, &lf_r, NULL);
+    }
+    double mb = (double)s.len * rounds / 1e6;
+
+    printf("scan       %.1f MB/s, %lu found, %lu lost, %lu garbled, %lu bad magic, %lu bad len, %lu rejected, "
+           "%lu resyncs\n",
+           scan_ns ? mb / ((double)scan_ns / 1e9) : 0.0,
+           (unsigned long)scan_t.matched,
+           (unsigned long)(s.frames - scan_t.matched),
+           (unsigned long)scan_t.garbled,
+           (unsigned long)fs.bad_magic,
+           (unsigned long)fs.bad_len,
+           (unsigned long)fs.rejected,
+           (unsigned long)fs.resyncs);
+    printf("per-byte   %.1f MB/s, %lu found, %lu lost, %lu garbled, %lu bad magic, %lu bad len\n",
+           legacy_ns ? mb / ((double)legacy_ns / 1e9) : 0.0,
+           (unsigned long)legacy_t.matched,
+           (unsigned long)(s.frames - legacy_t.matched),
+           (unsigned long)legacy_t.garbled,
+           (unsigned long)lf.bad_magic,
+           (unsigned long)lf.bad_len);
+    printf("speedup    %.2fx%s\n", scan_ns ? (double)legacy_ns / scan_ns : 0.0, failures ? " (FAIL)" : "");
+
+    stream_free(&s);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,206 @@
+/* Host benchmark: renders the messages page in wrap mode over a history of
+ * short and long messages and counts the width queries each frame makes
+ * through the gui shim, with the layout cache, with it invalidated before
+ * every frame, and for the per-prefix wrap it replaced. */
+
+#define _GNU_SOURCE
+
+#include "bench_util.h"
+#include "zeromesh_app.h"
+#include "zeromesh_gui.h"
+#include "zeromesh_history.h"
+
+#include <gui/canvas.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_PEER(i) (0x10000000UL + (i))
+
+static const char* const texts[] = {
+    "ok",
+    "on my way, ten minutes",
+    "relay on the ridge is back up after the battery swap, signal looks good from the valley",
+    "anyone near the trailhead? need a hand carrying the solar panel and the spare antenna mast up",
+    "copy",
+};
+
+typedef enum {
+    ModeCached,
+    ModeUncached,
+    ModePerPrefix,
+    ModeCount,
+} Mode;
+
+static const char* const mode_names[ModeCount] = {"cached", "uncached", "per-prefix"};
+
+/* calculate_wrapped_lines as it stood before the layout cache: one
+ * canvas_string_width per growing prefix of each line */
+static int legacy_wrapped_lines(Canvas* canvas, const char* text, int max_w) {
+    if(!text || !text[0]) return 1;
+
+    char line_buf[64];
+    size_t text_len = strlen(text);
+    size_t pos = 0;
+    int lines = 0;
+
+    while(pos < text_len) {
+        size_t line_len = 0;
+        size_t last_space = 0;
+
+        while(pos + line_len < text_len) {
+            line_buf[line_len] = text[pos + line_len];
+            line_buf[line_len + 1] = '\0';
+            if(text[pos + line_len] == ' ') last_space = line_len;
+
+            if(canvas_string_width(canvas, line_buf) > max_w) {
+                if(last_space > 0) {
+                    line_len = last_space;
+                } else if(line_len > 0) {
+                    line_len--;
+                }
+                break;
+            }
+            line_len++;
+            if(line_len >= sizeof(line_buf) - 1) break;
+        }
+        if(line_len == 0) line_len = 1;
+
+        pos += line_len;
+        while(pos < text_len && text[pos] == ' ') pos++;
+        lines++;
+    }
+    return lines > 0 ? lines : 1;
+}
+
+/* The old page made, per visible message: a text width to size it, then
+ * sender and text widths in the bubble. A message that wraps took a line
+ * count for its height, another for the bubble and a third walk to draw */
+static uint32_t legacy_frame(Canvas* canvas, ZeroMeshApp* app, uint64_t* ns) {
+    uint32_t conv = HISTORY_CONV_CHANNEL(app->current_channel);
+    uint16_t offset = app->msg_scroll_offset;
+    MessageWindow win;
+    message_window(canvas, app, conv, &offset, 16, 8, &win);
+
+    /* Only the old walk is counted and timed, not the window above */
+    uint64_t before = furi_shim_string_width_calls;
+    uint64_t t0 = bench_now_ns();
+    for(uint8_t i = 0; i < win.visible; i++) {
+        const char* text = win.msgs[i]->text;
+        uint16_t text_w = canvas_string_width(canvas, text);
+        canvas_string_width(canvas, "!1000000");
+        canvas_string_width(canvas, text);
+        if(text_w > 116) {
+            for(uint8_t pass = 0; pass < 3; pass++) legacy_wrapped_lines(canvas, text, 116);
+        }
+    }
+    *ns += bench_now_ns() - t0;
+    return (uint32_t)(furi_shim_string_width_calls - before);
+}
+
+static void usage(const char* argv0) {
+    fprintf(
+        stderr,
+        "usage: %s [-f frames] [-m messages] [-s every]\n"
+        "  -f frames    frames rendered per mode (default 1000)\n"
+        "  -m messages  messages in the channel (default %d)\n"
+        "  -s every     scroll one message every this many frames, 0 = never (default 8)\n",
+        argv0,
+        MSG_HISTORY);
+}
+
+int main(int argc, char** argv) {
+    uint32_t frames = 1000;
+    uint32_t messages = MSG_HISTORY;
+    uint32_t scroll_every = 8;
+    int opt;
+    while((opt = getopt(argc, argv, "f:m:s:h")) != -1) {
+        switch(opt) {
+        case 'f':
+            frames = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'm':
+            messages = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            scroll_every = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if(optind != argc || frames == 0 || messages == 0 || messages > MSG_HISTORY) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    char root[64];
+    if(!bench_sd_create(root, sizeof(root))) {
+        perror("mkdtemp");
+        return 1;
+    }
+    ZeroMeshApp* app = app_alloc();
+    for(uint32_t i = 0; i < messages; i++) {
+        history_add(app, texts[i % COUNT_OF(texts)], BENCH_PEER(i % 3), HISTORY_CONV_BROADCAST, 0, i % 4 == 0);
+    }
+    app->ui_mode = PAGE_MESSAGES;
+    app->lmh_mode = LMH_Wrap;
+    printf("page       %lu messages, wrap mode, %lu frames per mode, scroll every %lu\n",
+           (unsigned long)messages,
+           (unsigned long)frames,
+           (unsigned long)scroll_every);
+
+    for(Mode mode = ModeCached; mode < ModeCount; mode++) {
+        app->msg_scroll_offset = 0;
+        memset(app->layout_cache, 0, sizeof(app->layout_cache));
+        uint32_t hits = app->layout_hits;
+        uint32_t misses = app->layout_misses;
+        uint64_t strings = furi_shim_string_width_calls;
+        uint64_t glyphs = furi_shim_glyph_width_calls;
+        uint64_t legacy_strings = 0;
+        uint64_t elapsed = 0;
+
+        uint64_t t0 = bench_now_ns();
+        for(uint32_t f = 0; f < frames; f++) {
+            if(scroll_every && f % scroll_every == scroll_every - 1) {
+                app->msg_scroll_offset = (uint16_t)((app->msg_scroll_offset + 1) % messages);
+            }
+            if(mode == ModeUncached) memset(app->layout_cache, 0, sizeof(app->layout_cache));
+            if(mode == ModePerPrefix) {
+                legacy_strings += legacy_frame(NULL, app, &elapsed);
+            } else {
+                render_cb(NULL, app);
+            }
+        }
+        if(mode == ModePerPrefix) {
+            strings = legacy_strings;
+            glyphs = 0;
+        } else {
+            elapsed = bench_now_ns() - t0;
+            strings = furi_shim_string_width_calls - strings;
+            glyphs = furi_shim_glyph_width_calls - glyphs;
+        }
+        hits = app->layout_hits - hits;
+        misses = app->layout_misses - misses;
+        printf("%-10s %.1f string + %.1f glyph widths/frame, %.2f us/frame",
+               mode_names[mode],
+               (double)strings / frames,
+               (double)glyphs / frames,
+               (double)elapsed / frames / 1000.0);
+        if(mode == ModePerPrefix) {
+            printf("\n");
+        } else {
+            printf(", layout %lu hit / %lu miss (%.1f%% hits)\n",
+                   (unsigned long)hits,
+                   (unsigned long)misses,
+                   hits + misses ? 100.0 * hits / (hits + misses) : 0.0);
+        }
+    }
+
+    app_free(app);
+    bench_sd_remove(root);
+    return 0;
+}
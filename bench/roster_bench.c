@@ -0,0 +1,105 @@
+/* Host benchmark: drives the roster with a synthetic packet trace in which
+ * most traffic comes from a hot set of nodes and the rest from a larger
+ * population, then reports lookup rate and eviction churn. */
+
+#define _GNU_SOURCE
+
+#include "bench_util.h"
+#include "zeromesh_app.h"
+#include "zeromesh_roster.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define BENCH_HOT_SHARE 80
+
+static uint32_t lcg_next(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static void usage(const char* argv0) {
+    fprintf(
+        stderr,
+        "usage: %s [-n packets] [-p nodes] [-t hot]\n"
+        "  -n packets  trace length (default 10000)\n"
+        "  -p nodes    distinct senders in the trace (default 600)\n"
+        "  -t hot      senders carrying %d%% of the traffic (default 150)\n",
+        argv0,
+        BENCH_HOT_SHARE);
+}
+
+int main(int argc, char** argv) {
+    uint32_t packets = 10000;
+    uint32_t population = 600;
+    uint32_t hot = 150;
+    int opt;
+    while((opt = getopt(argc, argv, "n:p:t:h")) != -1) {
+        switch(opt) {
+        case 'n':
+            packets = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            population = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            hot = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if(optind != argc || packets == 0 || population == 0 || hot == 0 || hot > population) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    char root[64];
+    if(!bench_sd_create(root, sizeof(root))) {
+        perror("mkdtemp");
+        return 1;
+    }
+    ZeroMeshApp* app = app_alloc();
+
+    uint32_t* trace = malloc(packets * sizeof(uint32_t));
+    uint32_t seed = 1;
+    for(uint32_t i = 0; i < packets; i++) {
+        uint32_t r = lcg_next(&seed);
+        bool is_hot = (r % 100) < BENCH_HOT_SHARE || hot == population;
+        uint32_t n = is_hot ? lcg_next(&seed) % hot : hot + lcg_next(&seed) % (population - hot);
+        trace[i] = 0x10000000UL + n;
+    }
+
+    /* Per packet: the signal update from handle_packet, a telemetry update
+     * every 7th packet and the DM lookup the message path does */
+    uint32_t misses = 0;
+    uint64_t t0 = bench_now_ns();
+    for(uint32_t i = 0; i < packets; i++) {
+        roster_add_node(app, trace[i], (int8_t)(i % 40), -80);
+        if(i % 7 == 0) roster_update_telemetry(app, trace[i], 90, 4.1f);
+        if(roster_lookup(app, trace[(i * 31) % packets]) == ROSTER_SLOT_NONE) misses++;
+    }
+    uint64_t elapsed = bench_now_ns() - t0;
+
+    printf("roster     %u slots, %u in use after %lu packets from %lu nodes (%lu hot)\n",
+           app->roster.capacity,
+           app->roster.count,
+           (unsigned long)packets,
+           (unsigned long)population,
+           (unsigned long)hot);
+    printf("lookups    %lu, %.2f M/s, %.1f ns/packet, %lu lookup misses\n",
+           (unsigned long)app->roster.lookups,
+           elapsed ? (double)app->roster.lookups / ((double)elapsed / 1e9) / 1e6 : 0.0,
+           (double)elapsed / packets,
+           (unsigned long)misses);
+    printf("churn      %lu evictions, %.1f%% of packets\n",
+           (unsigned long)app->roster.evictions,
+           100.0 * app->roster.evictions / packets);
+
+    free(trace);
+    app_free(app);
+    bench_sd_remove(root);
+    return 0;
+}
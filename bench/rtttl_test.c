@@ -0,0 +1,155 @@
+/* Host test: compiles every bundled ringtone and checks its note table,
+ * then feeds the compiler malformed and oversized sources. */
+
+#include "zeromesh_serial.h"
+#include "zeromesh_rtttl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char* file;
+    const char* name;
+    uint16_t notes;
+    uint32_t ms;
+} RingtoneCase;
+
+/* Note counts include the RTTTL_GAP_MS rest split off each note long
+ * enough to take one */
+static const RingtoneCase ringtones[] = {
+    {"short.rtttl", "Short", 2, 187},
+    {"double.rtttl", "Double", 5, 561},
+    {"triple.rtttl", "Triple", 8, 375},
+    {"long.rtttl", "Long", 2, 1000},
+    {"sos.rtttl", "SOS", 26, 3160},
+    {"chirp.rtttl", "Chirp", 17, 527},
+    {"nokia.rtttl", "Nokia", 26, 3660},
+    {"descend.rtttl", "Descend", 18, 1350},
+    {"bounce.rtttl", "Bounce", 12, 1122},
+    {"alert.rtttl", "Alert", 12, 1440},
+    {"pulse.rtttl", "Pulse", 11, 1498},
+    {"siren.rtttl", "Siren", 40, 1660},
+    {"beep3.rtttl", "Beep3", 8, 935},
+    {"trill.rtttl", "Trill", 14, 750},
+    {"supermario.rtttl", "SuperMario", 17, 2325},
+    {"levelup.rtttl", "LevelUp", 5, 261},
+    {"metric.rtttl", "ImperialMarch", 37, 11505},
+    {"minimalist.rtttl", "Pip", 3, 123},
+};
+
+static uint32_t failures;
+
+#define CHECK(cond, ...)                                \
+    do {                                                \
+        if(!(cond)) {                                   \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);                        \
+            printf("\n");                               \
+            failures++;                                 \
+        }                                               \
+    } while(0)
+
+static bool load(const char* dir, const char* file, char* src, size_t size) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    FILE* fp = fopen(path, "rb");
+    if(!fp) return false;
+    size_t len = fread(src, 1, size - 1, fp);
+    fclose(fp);
+    src[len] = '\0';
+    return true;
+}
+
+static void test_bundled(const char* dir) {
+    char src[RINGTONE_SRC_MAX + 1];
+    RtttlTune tune;
+    for(size_t i = 0; i < COUNT_OF(ringtones); i++) {
+        const RingtoneCase* c = &ringtones[i];
+        if(!load(dir, c->file, src, sizeof(src))) {
+            CHECK(false, "%s: cannot read", c->file);
+            continue;
+        }
+        CHECK(rtttl_compile(src, &tune), "%s: compile failed", c->file);
+        CHECK(strcmp(tune.name, c->name) == 0, "%s: name %s, want %s", c->file, tune.name, c->name);
+        CHECK(tune.count == c->notes, "%s: %u notes, want %u", c->file, tune.count, c->notes);
+        CHECK(rtttl_duration_ms(&tune) == c->ms,
+              "%s: %lu ms, want %lu",
+              c->file,
+              (unsigned long)rtttl_duration_ms(&tune),
+              (unsigned long)c->ms);
+    }
+    /* Plus RingtoneNone, which has no file */
+    CHECK(COUNT_OF(ringtones) + 1 == RINGTONE_COUNT, "%u ringtones listed", (unsigned)COUNT_OF(ringtones));
+}
+
+static void test_malformed(void) {
+    RtttlTune tune;
+
+    /* An invalid duration falls back to the default one */
+    CHECK(rtttl_compile("T:d=4,o=5,b=120:3c", &tune), "bad note duration rejected");
+    CHECK(rtttl_duration_ms(&tune) == 500, "bad note duration: %lu ms", (unsigned long)rtttl_duration_ms(&tune));
+    CHECK(rtttl_compile("T:d=3,o=5,b=120:c", &tune), "bad default duration rejected");
+    CHECK(rtttl_duration_ms(&tune) == 500, "bad default duration: %lu ms", (unsigned long)rtttl_duration_ms(&tune));
+
+    /* So does an octave outside 3..8 */
+    CHECK(rtttl_compile("T:d=4,o=5,b=120:c9", &tune), "bad note octave rejected");
+    CHECK(tune.notes[0].freq == 523, "bad note octave: %u Hz", tune.notes[0].freq);
+    CHECK(rtttl_compile("T:d=4,o=9,b=120:a", &tune), "bad default octave rejected");
+    CHECK(tune.notes[0].freq == 1760, "bad default octave: %u Hz", tune.notes[0].freq);
+
+    CHECK(!rtttl_compile("no sections", &tune), "missing ':' accepted");
+    CHECK(!rtttl_compile("T:d=4,o=5,b=120", &tune), "missing note section accepted");
+    CHECK(!rtttl_compile("T:d=4,o=5,b=120:c,x,d", &tune), "unknown note letter accepted");
+    CHECK(!rtttl_compile("T:d=4,o=5,b=120:", &tune), "empty note list accepted");
+}
+
+/* Notes of "16c#6," after a header padded by pad characters, so the
+ * RINGTONE_SRC_MAX boundary lands at a different point inside a note */
+static size_t oversized_source(char* src, size_t size, size_t pad) {
+    size_t len = (size_t)sprintf(src, "Long%.*s:d=16,o=6,b=200:", (int)pad, "xxxxxxxx");
+    for(uint32_t i = 0; len + 7 < size; i++) len += (size_t)sprintf(src + len, "%s16c#6", i ? "," : "");
+    return len;
+}
+
+static void test_oversized(void) {
+    RtttlTune tune;
+    size_t size = RINGTONE_SRC_MAX * 2;
+    char* src = malloc(size);
+
+    /* The whole source compiles, capped at RTTTL_MAX_NOTES */
+    oversized_source(src, size, 0);
+    CHECK(rtttl_compile(src, &tune), "oversized source rejected");
+    CHECK(tune.count == RTTTL_MAX_NOTES, "oversized source: %u notes", tune.count);
+
+    /* The loader reads RINGTONE_SRC_MAX bytes; wherever that cuts a note,
+     * the clipped prefix still compiles */
+    for(size_t pad = 0; pad < 6; pad++) {
+        oversized_source(src, size, pad);
+        size_t keep = rtttl_clip(src, RINGTONE_SRC_MAX, RINGTONE_SRC_MAX);
+        src[keep] = '\0';
+        CHECK(keep < RINGTONE_SRC_MAX && src[keep - 1] == '6', "pad %u: clipped to %u", (unsigned)pad, (unsigned)keep);
+        CHECK(rtttl_compile(src, &tune), "pad %u: clipped source rejected", (unsigned)pad);
+    }
+
+    /* A short read is left alone */
+    const char* tune_src = "T:d=4,o=5,b=120:c,d";
+    CHECK(rtttl_clip(tune_src, strlen(tune_src), RINGTONE_SRC_MAX) == strlen(tune_src), "short source clipped");
+
+    free(src);
+}
+
+int main(int argc, char** argv) {
+    const char* dir = (argc > 1) ? argv[1] : "../ringtones";
+
+    test_bundled(dir);
+    test_malformed();
+    test_oversized();
+
+    if(failures) {
+        printf("rtttl_test: %lu failures\n", (unsigned long)failures);
+        return 1;
+    }
+    printf("rtttl_test: %u ringtones ok\n", (unsigned)COUNT_OF(ringtones));
+    return 0;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+/* Host stand-in for the parts of furi.h used by ZeroMesh, backed by pthreads */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define FuriWaitForever 0xFFFFFFFFU
+
+typedef enum {
+    FuriStatusOk = 0,
+    FuriStatusError = -1,
+    FuriStatusErrorTimeout = -2,
+    FuriStatusErrorResource = -3,
+} FuriStatus;
+
+#define FuriFlagWaitAny      0x00000000U
+#define FuriFlagWaitAll      0x00000001U
+#define FuriFlagNoClear      0x00000002U
+#define FuriFlagError        0x80000000U
+#define FuriFlagErrorTimeout 0xFFFFFFFEU
+
+#define FURI_LOG_E(tag, fmt, ...) ((void)(tag))
+#define FURI_LOG_W(tag, fmt, ...) ((void)(tag))
+#define FURI_LOG_I(tag, fmt, ...) ((void)(tag))
+#define FURI_LOG_D(tag, fmt, ...) ((void)(tag))
+
+#define UNUSED(x)   (void)(x)
+#define COUNT_OF(x) (sizeof(x) / sizeof(x[0]))
+
+void furi_check(bool cond);
+
+typedef enum {
+    FuriMutexTypeNormal,
+    FuriMutexTypeRecursive,
+} FuriMutexType;
+
+typedef struct FuriMutex FuriMutex;
+FuriMutex* furi_mutex_alloc(FuriMutexType type);
+void furi_mutex_free(FuriMutex* mutex);
+FuriStatus furi_mutex_acquire(FuriMutex* mutex, uint32_t timeout);
+FuriStatus furi_mutex_release(FuriMutex* mutex);
+
+typedef struct FuriStreamBuffer FuriStreamBuffer;
+FuriStreamBuffer* furi_stream_buffer_alloc(size_t size, size_t trigger_level);
+void furi_stream_buffer_free(FuriStreamBuffer* stream);
+size_t furi_stream_buffer_send(FuriStreamBuffer* stream, const void* data, size_t length, uint32_t timeout);
+size_t furi_stream_buffer_receive(FuriStreamBuffer* stream, void* data, size_t length, uint32_t timeout);
+size_t furi_stream_buffer_bytes_available(FuriStreamBuffer* stream);
+size_t furi_stream_buffer_spaces_available(FuriStreamBuffer* stream);
+FuriStatus furi_stream_buffer_reset(FuriStreamBuffer* stream);
+
+typedef struct FuriMessageQueue FuriMessageQueue;
+FuriMessageQueue* furi_message_queue_alloc(uint32_t msg_count, uint32_t msg_size);
+void furi_message_queue_free(FuriMessageQueue* queue);
+FuriStatus furi_message_queue_put(FuriMessageQueue* queue, const void* msg, uint32_t timeout);
+FuriStatus furi_message_queue_get(FuriMessageQueue* queue, void* msg, uint32_t timeout);
+uint32_t furi_message_queue_get_count(FuriMessageQueue* queue);
+FuriStatus furi_message_queue_reset(FuriMessageQueue* queue);
+
+typedef struct FuriThread FuriThread;
+typedef FuriThread* FuriThreadId;
+typedef int32_t (*FuriThreadCallback)(void* context);
+FuriThread* furi_thread_alloc_ex(const char* name, uint32_t stack_size, FuriThreadCallback callback, void* context);
+void furi_thread_free(FuriThread* thread);
+void furi_thread_start(FuriThread* thread);
+bool furi_thread_join(FuriThread* thread);
+FuriThreadId furi_thread_get_id(FuriThread* thread);
+FuriThreadId furi_thread_get_current_id(void);
+uint32_t furi_thread_get_stack_space(FuriThreadId thread_id);
+uint32_t furi_thread_flags_set(FuriThreadId thread_id, uint32_t flags);
+uint32_t furi_thread_flags_clear(uint32_t flags);
+uint32_t furi_thread_flags_wait(uint32_t flags, uint32_t options, uint32_t timeout);
+
+uint32_t furi_get_tick(void);
+uint32_t furi_ms_to_ticks(uint32_t milliseconds);
+void furi_delay_ms(uint32_t milliseconds);
+
+/* Reports a free heap typical of a running FAP so heap-sized tables match the device */
+size_t memmgr_get_free_heap(void);
+
+void* furi_record_open(const char* name);
+void furi_record_close(const char* name);
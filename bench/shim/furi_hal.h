@@ -0,0 +1,70 @@
+#pragma once
+
+/* Host stand-in for furi_hal: serial TX is counted and dropped, RX arrives
+ * through capture replay or furi_shim_serial_rx, DWT->CYCCNT counts
+ * nanoseconds */
+
+#include <furi.h>
+
+typedef enum {
+    FuriHalSerialIdUsart,
+    FuriHalSerialIdLpuart,
+    FuriHalSerialIdMax,
+} FuriHalSerialId;
+
+typedef enum {
+    FuriHalSerialRxEventData = (1 << 0),
+    FuriHalSerialRxEventIdle = (1 << 1),
+    FuriHalSerialRxEventFrameError = (1 << 2),
+    FuriHalSerialRxEventNoiseError = (1 << 3),
+    FuriHalSerialRxEventOverrunError = (1 << 4),
+} FuriHalSerialRxEvent;
+
+typedef struct FuriHalSerialHandle FuriHalSerialHandle;
+typedef void (*FuriHalSerialDmaRxCallback)(
+    FuriHalSerialHandle* handle,
+    FuriHalSerialRxEvent event,
+    size_t data_len,
+    void* context);
+
+FuriHalSerialHandle* furi_hal_serial_control_acquire(FuriHalSerialId serial_id);
+void furi_hal_serial_control_release(FuriHalSerialHandle* handle);
+void furi_hal_serial_init(FuriHalSerialHandle* handle, uint32_t baud);
+void furi_hal_serial_deinit(FuriHalSerialHandle* handle);
+void furi_hal_serial_tx(FuriHalSerialHandle* handle, const uint8_t* buffer, size_t buffer_size);
+void furi_hal_serial_dma_rx_start(
+    FuriHalSerialHandle* handle,
+    FuriHalSerialDmaRxCallback callback,
+    void* context,
+    bool report_errors);
+void furi_hal_serial_dma_rx_stop(FuriHalSerialHandle* handle);
+size_t furi_hal_serial_dma_rx(FuriHalSerialHandle* handle, uint8_t* data, size_t len);
+
+uint32_t furi_hal_random_get(void);
+uint32_t furi_hal_rtc_get_timestamp(void);
+
+bool furi_hal_speaker_acquire(uint32_t timeout);
+void furi_hal_speaker_release(void);
+void furi_hal_speaker_start(float frequency, float volume);
+void furi_hal_speaker_stop(void);
+
+typedef struct {
+    uint32_t CYCCNT;
+} DWT_Type;
+
+DWT_Type* furi_shim_dwt(void);
+#define DWT (furi_shim_dwt())
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void);
+
+/* Bytes handed to furi_hal_serial_tx since start */
+extern volatile uint64_t furi_shim_serial_tx_bytes;
+
+/* Called from furi_hal_serial_tx with every buffer written, on the
+ * writing thread; NULL to stop */
+typedef void (*FuriShimSerialTx)(const uint8_t* data, size_t len, void* ctx);
+void furi_shim_serial_on_tx(FuriShimSerialTx callback, void* ctx);
+
+/* Delivers data to the DMA RX callback as one idle-line burst, the way the
+ * UART does after a gap. False when no RX callback is running. */
+bool furi_shim_serial_rx(const uint8_t* data, size_t len);
@@ -0,0 +1,499 @@
+#include <furi.h>
+#include <furi_hal.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+struct FuriMutex {
+    pthread_mutex_t m;
+};
+
+struct FuriStreamBuffer {
+    pthread_mutex_t m;
+    pthread_cond_t cond;
+    uint8_t* buf;
+    size_t size;
+    size_t head;
+    size_t count;
+};
+
+struct FuriMessageQueue {
+    pthread_mutex_t m;
+    pthread_cond_t cond;
+    uint8_t* buf;
+    uint32_t msg_count;
+    uint32_t msg_size;
+    uint32_t head;
+    uint32_t count;
+};
+
+struct FuriThread {
+    pthread_t pt;
+    FuriThreadCallback callback;
+    void* context;
+    pthread_mutex_t m;
+    pthread_cond_t cond;
+    uint32_t flags;
+    bool started;
+};
+
+struct FuriHalSerialHandle {
+    FuriHalSerialId id;
+    FuriHalSerialDmaRxCallback rx_callback;
+    void* rx_context;
+    const uint8_t* rx_data;
+    size_t rx_len;
+};
+
+static FuriHalSerialHandle* shim_rx_handle;
+
+volatile uint64_t furi_shim_serial_tx_bytes;
+static FuriShimSerialTx shim_tx_callback;
+static void* shim_tx_context;
+
+static uint64_t shim_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t shim_boot_ns;
+
+static void shim_deadline(struct timespec* ts, uint32_t timeout) {
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += timeout / 1000;
+    ts->tv_nsec += (long)(timeout % 1000) * 1000000L;
+    if(ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/* Waits on cond until woken or the furi-style timeout runs out.
+ * Returns false once the timeout has expired. */
+static bool shim_wait(pthread_cond_t* cond, pthread_mutex_t* m, uint32_t timeout, const struct timespec* until) {
+    if(timeout == 0) return false;
+    if(timeout == FuriWaitForever) {
+        pthread_cond_wait(cond, m);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, m, until) != ETIMEDOUT;
+}
+
+static void shim_cond_init(pthread_cond_t* cond) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+void furi_check(bool cond) {
+    if(!cond) abort();
+}
+
+FuriMutex* furi_mutex_alloc(FuriMutexType type) {
+    FuriMutex* mutex = malloc(sizeof(FuriMutex));
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    if(type == FuriMutexTypeRecursive) pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mutex->m, &attr);
+    pthread_mutexattr_destroy(&attr);
+    return mutex;
+}
+
+void furi_mutex_free(FuriMutex* mutex) {
+    pthread_mutex_destroy(&mutex->m);
+    free(mutex);
+}
+
+FuriStatus furi_mutex_acquire(FuriMutex* mutex, uint32_t timeout) {
+    if(timeout == FuriWaitForever) return pthread_mutex_lock(&mutex->m) == 0 ? FuriStatusOk : FuriStatusError;
+    if(timeout == 0) return pthread_mutex_trylock(&mutex->m) == 0 ? FuriStatusOk : FuriStatusErrorResource;
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec += timeout / 1000;
+    until.tv_nsec += (long)(timeout % 1000) * 1000000L;
+    if(until.tv_nsec >= 1000000000L) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+    }
+    return pthread_mutex_timedlock(&mutex->m, &until) == 0 ? FuriStatusOk : FuriStatusErrorTimeout;
+}
+
+FuriStatus furi_mutex_release(FuriMutex* mutex) {
+    return pthread_mutex_unlock(&mutex->m) == 0 ? FuriStatusOk : FuriStatusError;
+}
+
+FuriStreamBuffer* furi_stream_buffer_alloc(size_t size, size_t trigger_level) {
+    UNUSED(trigger_level);
+    FuriStreamBuffer* stream = calloc(1, sizeof(FuriStreamBuffer));
+    pthread_mutex_init(&stream->m, NULL);
+    shim_cond_init(&stream->cond);
+    stream->buf = malloc(size);
+    stream->size = size;
+    return stream;
+}
+
+void furi_stream_buffer_free(FuriStreamBuffer* stream) {
+    pthread_cond_destroy(&stream->cond);
+    pthread_mutex_destroy(&stream->m);
+    free(stream->buf);
+    free(stream);
+}
+
+size_t furi_stream_buffer_send(FuriStreamBuffer* stream, const void* data, size_t length, uint32_t timeout) {
+    const uint8_t* src = data;
+    struct timespec until;
+    shim_deadline(&until, timeout);
+    pthread_mutex_lock(&stream->m);
+    while(stream->count == stream->size) {
+        if(!shim_wait(&stream->cond, &stream->m, timeout, &until)) break;
+    }
+    size_t n = stream->size - stream->count;
+    if(n > length) n = length;
+    for(size_t i = 0; i < n; i++) {
+        stream->buf[(stream->head + stream->count + i) % stream->size] = src[i];
+    }
+    stream->count += n;
+    if(n > 0) pthread_cond_broadcast(&stream->cond);
+    pthread_mutex_unlock(&stream->m);
+    return n;
+}
+
+size_t furi_stream_buffer_receive(FuriStreamBuffer* stream, void* data, size_t length, uint32_t timeout) {
+    uint8_t* dst = data;
+    struct timespec until;
+    shim_deadline(&until, timeout);
+    pthread_mutex_lock(&stream->m);
+    while(stream->count == 0) {
+        if(!shim_wait(&stream->cond, &stream->m, timeout, &until)) break;
+    }
+    size_t n = stream->count < length ? stream->count : length;
+    for(size_t i = 0; i < n; i++) {
+        dst[i] = stream->buf[(stream->head + i) % stream->size];
+    }
+    stream->head = (stream->head + n) % stream->size;
+    stream->count -= n;
+    if(n > 0) pthread_cond_broadcast(&stream->cond);
+    pthread_mutex_unlock(&stream->m);
+    return n;
+}
+
+size_t furi_stream_buffer_bytes_available(FuriStreamBuffer* stream) {
+    pthread_mutex_lock(&stream->m);
+    size_t n = stream->count;
+    pthread_mutex_unlock(&stream->m);
+    return n;
+}
+
+size_t furi_stream_buffer_spaces_available(FuriStreamBuffer* stream) {
+    pthread_mutex_lock(&stream->m);
+    size_t n = stream->size - stream->count;
+    pthread_mutex_unlock(&stream->m);
+    return n;
+}
+
+FuriStatus furi_stream_buffer_reset(FuriStreamBuffer* stream) {
+    pthread_mutex_lock(&stream->m);
+    stream->head = 0;
+    stream->count = 0;
+    pthread_cond_broadcast(&stream->cond);
+    pthread_mutex_unlock(&stream->m);
+    return FuriStatusOk;
+}
+
+FuriMessageQueue* furi_message_queue_alloc(uint32_t msg_count, uint32_t msg_size) {
+    FuriMessageQueue* queue = calloc(1, sizeof(FuriMessageQueue));
+    pthread_mutex_init(&queue->m, NULL);
+    shim_cond_init(&queue->cond);
+    queue->buf = malloc((size_t)msg_count * msg_size);
+    queue->msg_count = msg_count;
+    queue->msg_size = msg_size;
+    return queue;
+}
+
+void furi_message_queue_free(FuriMessageQueue* queue) {
+    pthread_cond_destroy(&queue->cond);
+    pthread_mutex_destroy(&queue->m);
+    free(queue->buf);
+    free(queue);
+}
+
+FuriStatus furi_message_queue_put(FuriMessageQueue* queue, const void* msg, uint32_t timeout) {
+    struct timespec until;
+    shim_deadline(&until, timeout);
+    pthread_mutex_lock(&queue->m);
+    while(queue->count == queue->msg_count) {
+        if(!shim_wait(&queue->cond, &queue->m, timeout, &until)) {
+            pthread_mutex_unlock(&queue->m);
+            return timeout ? FuriStatusErrorTimeout : FuriStatusErrorResource;
+        }
+    }
+    uint32_t slot = (queue->head + queue->count) % queue->msg_count;
+    memcpy(queue->buf + (size_t)slot * queue->msg_size, msg, queue->msg_size);
+    queue->count++;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->m);
+    return FuriStatusOk;
+}
+
+FuriStatus furi_message_queue_get(FuriMessageQueue* queue, void* msg, uint32_t timeout) {
+    struct timespec until;
+    shim_deadline(&until, timeout);
+    pthread_mutex_lock(&queue->m);
+    while(queue->count == 0) {
+        if(!shim_wait(&queue->cond, &queue->m, timeout, &until)) {
+            pthread_mutex_unlock(&queue->m);
+            return timeout ? FuriStatusErrorTimeout : FuriStatusErrorResource;
+        }
+    }
+    memcpy(msg, queue->buf + (size_t)queue->head * queue->msg_size, queue->msg_size);
+    queue->head = (queue->head + 1) % queue->msg_count;
+    queue->count--;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->m);
+    return FuriStatusOk;
+}
+
+uint32_t furi_message_queue_get_count(FuriMessageQueue* queue) {
+    pthread_mutex_lock(&queue->m);
+    uint32_t n = queue->count;
+    pthread_mutex_unlock(&queue->m);
+    return n;
+}
+
+FuriStatus furi_message_queue_reset(FuriMessageQueue* queue) {
+    pthread_mutex_lock(&queue->m);
+    queue->head = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->m);
+    return FuriStatusOk;
+}
+
+static __thread FuriThread* shim_current;
+static FuriThread shim_main_thread = {
+    .m = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static void* shim_thread_body(void* arg) {
+    FuriThread* thread = arg;
+    shim_current = thread;
+    thread->callback(thread->context);
+    return NULL;
+}
+
+FuriThread* furi_thread_alloc_ex(const char* name, uint32_t stack_size, FuriThreadCallback callback, void* context) {
+    UNUSED(name);
+    UNUSED(stack_size);
+    FuriThread* thread = calloc(1, sizeof(FuriThread));
+    thread->callback = callback;
+    thread->context = context;
+    pthread_mutex_init(&thread->m, NULL);
+    shim_cond_init(&thread->cond);
+    return thread;
+}
+
+void furi_thread_free(FuriThread* thread) {
+    pthread_cond_destroy(&thread->cond);
+    pthread_mutex_destroy(&thread->m);
+    free(thread);
+}
+
+void furi_thread_start(FuriThread* thread) {
+    thread->started = pthread_create(&thread->pt, NULL, shim_thread_body, thread) == 0;
+    furi_check(thread->started);
+}
+
+bool furi_thread_join(FuriThread* thread) {
+    if(thread->started) pthread_join(thread->pt, NULL);
+    thread->started = false;
+    return true;
+}
+
+FuriThreadId furi_thread_get_id(FuriThread* thread) {
+    return thread;
+}
+
+FuriThreadId furi_thread_get_current_id(void) {
+    return shim_current ? shim_current : &shim_main_thread;
+}
+
+uint32_t furi_thread_get_stack_space(FuriThreadId thread_id) {
+    /* Not measurable on the host; large enough to leave minimums untouched */
+    UNUSED(thread_id);
+    return UINT32_MAX;
+}
+
+uint32_t furi_thread_flags_set(FuriThreadId thread_id, uint32_t flags) {
+    FuriThread* thread = thread_id;
+    pthread_mutex_lock(&thread->m);
+    thread->flags |= flags;
+    uint32_t now = thread->flags;
+    pthread_cond_broadcast(&thread->cond);
+    pthread_mutex_unlock(&thread->m);
+    return now;
+}
+
+uint32_t furi_thread_flags_clear(uint32_t flags) {
+    FuriThread* thread = furi_thread_get_current_id();
+    pthread_mutex_lock(&thread->m);
+    uint32_t prev = thread->flags;
+    thread->flags &= ~flags;
+    pthread_mutex_unlock(&thread->m);
+    return prev;
+}
+
+uint32_t furi_thread_flags_wait(uint32_t flags, uint32_t options, uint32_t timeout) {
+    FuriThread* thread = furi_thread_get_current_id();
+    struct timespec until;
+    shim_deadline(&until, timeout);
+    pthread_mutex_lock(&thread->m);
+    for(;;) {
+        uint32_t hit = thread->flags & flags;
+        bool done = (options & FuriFlagWaitAll) ? hit == flags : hit != 0;
+        if(done) {
+            if(!(options & FuriFlagNoClear)) thread->flags &= ~hit;
+            pthread_mutex_unlock(&thread->m);
+            return hit;
+        }
+        if(!shim_wait(&thread->cond, &thread->m, timeout, &until)) break;
+    }
+    pthread_mutex_unlock(&thread->m);
+    return timeout ? FuriFlagErrorTimeout : FuriFlagError;
+}
+
+uint32_t furi_get_tick(void) {
+    if(!shim_boot_ns) shim_boot_ns = shim_now_ns();
+    return (uint32_t)((shim_now_ns() - shim_boot_ns) / 1000000ULL);
+}
+
+uint32_t furi_ms_to_ticks(uint32_t milliseconds) {
+    return milliseconds;
+}
+
+void furi_delay_ms(uint32_t milliseconds) {
+    struct timespec ts = {.tv_sec = milliseconds / 1000, .tv_nsec = (long)(milliseconds % 1000) * 1000000L};
+    while(nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+size_t memmgr_get_free_heap(void) {
+    return 96 * 1024;
+}
+
+void* furi_record_open(const char* name) {
+    /* Services are stateless in the shim; any non-NULL handle will do */
+    return (void*)name;
+}
+
+void furi_record_close(const char* name) {
+    UNUSED(name);
+}
+
+FuriHalSerialHandle* furi_hal_serial_control_acquire(FuriHalSerialId serial_id) {
+    static FuriHalSerialHandle handles[FuriHalSerialIdMax];
+    handles[serial_id].id = serial_id;
+    return &handles[serial_id];
+}
+
+void furi_hal_serial_control_release(FuriHalSerialHandle* handle) {
+    UNUSED(handle);
+}
+
+void furi_hal_serial_init(FuriHalSerialHandle* handle, uint32_t baud) {
+    UNUSED(handle);
+    UNUSED(baud);
+}
+
+void furi_hal_serial_deinit(FuriHalSerialHandle* handle) {
+    UNUSED(handle);
+}
+
+void furi_hal_serial_tx(FuriHalSerialHandle* handle, const uint8_t* buffer, size_t buffer_size) {
+    UNUSED(handle);
+    __atomic_fetch_add(&furi_shim_serial_tx_bytes, buffer_size, __ATOMIC_RELAXED);
+    if(shim_tx_callback) shim_tx_callback(buffer, buffer_size, shim_tx_context);
+}
+
+void furi_shim_serial_on_tx(FuriShimSerialTx callback, void* ctx) {
+    shim_tx_context = ctx;
+    shim_tx_callback = callback;
+}
+
+void furi_hal_serial_dma_rx_start(
+    FuriHalSerialHandle* handle,
+    FuriHalSerialDmaRxCallback callback,
+    void* context,
+    bool report_errors) {
+    UNUSED(report_errors);
+    handle->rx_callback = callback;
+    handle->rx_context = context;
+    __atomic_store_n(&shim_rx_handle, handle, __ATOMIC_RELEASE);
+}
+
+void furi_hal_serial_dma_rx_stop(FuriHalSerialHandle* handle) {
+    __atomic_compare_exchange_n(&shim_rx_handle, &handle, NULL, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+size_t furi_hal_serial_dma_rx(FuriHalSerialHandle* handle, uint8_t* data, size_t len) {
+    if(len > handle->rx_len) len = handle->rx_len;
+    memcpy(data, handle->rx_data, len);
+    handle->rx_data += len;
+    handle->rx_len -= len;
+    return len;
+}
+
+bool furi_shim_serial_rx(const uint8_t* data, size_t len) {
+    FuriHalSerialHandle* handle = __atomic_load_n(&shim_rx_handle, __ATOMIC_ACQUIRE);
+    if(!handle) return false;
+    handle->rx_data = data;
+    handle->rx_len = len;
+    handle->rx_callback(
+        handle, FuriHalSerialRxEventData | FuriHalSerialRxEventIdle, len, handle->rx_context);
+    handle->rx_len = 0;
+    return true;
+}
+
+uint32_t furi_hal_random_get(void) {
+    static uint32_t state = 0x2545F491;
+    uint32_t x = __atomic_load_n(&state, __ATOMIC_RELAXED);
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    __atomic_store_n(&state, x, __ATOMIC_RELAXED);
+    return x;
+}
+
+uint32_t furi_hal_rtc_get_timestamp(void) {
+    return (uint32_t)time(NULL);
+}
+
+bool furi_hal_speaker_acquire(uint32_t timeout) {
+    UNUSED(timeout);
+    return false;
+}
+
+void furi_hal_speaker_release(void) {
+}
+
+void furi_hal_speaker_start(float frequency, float volume) {
+    UNUSED(frequency);
+    UNUSED(volume);
+}
+
+void furi_hal_speaker_stop(void) {
+}
+
+DWT_Type* furi_shim_dwt(void) {
+    static __thread DWT_Type dwt;
+    dwt.CYCCNT = (uint32_t)shim_now_ns();
+    return &dwt;
+}
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void) {
+    return 1000;
+}
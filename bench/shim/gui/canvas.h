@@ -0,0 +1,38 @@
+#pragma once
+
+/* Host stand-in: drawing calls are accepted and discarded */
+
+#include <furi.h>
+
+typedef struct Canvas Canvas;
+
+typedef enum {
+    ColorWhite,
+    ColorBlack,
+    ColorXOR,
+} Color;
+
+typedef enum {
+    FontPrimary,
+    FontSecondary,
+    FontKeyboard,
+    FontBigNumbers,
+} Font;
+
+void canvas_clear(Canvas* canvas);
+void canvas_set_color(Canvas* canvas, Color color);
+void canvas_set_font(Canvas* canvas, Font font);
+void canvas_draw_str(Canvas* canvas, int32_t x, int32_t y, const char* str);
+uint16_t canvas_string_width(Canvas* canvas, const char* str);
+uint16_t canvas_glyph_width(Canvas* canvas, uint16_t symbol);
+void canvas_draw_box(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height);
+void canvas_draw_rbox(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height, size_t radius);
+void canvas_draw_rframe(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height, size_t radius);
+void canvas_draw_disc(Canvas* canvas, int32_t x, int32_t y, size_t radius);
+void canvas_draw_circle(Canvas* canvas, int32_t x, int32_t y, size_t radius);
+void canvas_draw_line(Canvas* canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+void canvas_draw_dot(Canvas* canvas, int32_t x, int32_t y);
+
+/* Width queries made through the shim, for the layout benchmark */
+extern uint64_t furi_shim_string_width_calls;
+extern uint64_t furi_shim_glyph_width_calls;
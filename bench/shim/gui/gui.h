@@ -0,0 +1,15 @@
+#pragma once
+
+#include <gui/canvas.h>
+#include <gui/view_port.h>
+
+#define RECORD_GUI "gui"
+
+typedef struct Gui Gui;
+
+typedef enum {
+    GuiLayerFullscreen,
+} GuiLayer;
+
+void gui_add_view_port(Gui* gui, ViewPort* view_port, GuiLayer layer);
+void gui_remove_view_port(Gui* gui, ViewPort* view_port);
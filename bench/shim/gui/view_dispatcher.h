@@ -0,0 +1,30 @@
+#pragma once
+
+#include <gui/gui.h>
+
+typedef struct ViewDispatcher ViewDispatcher;
+typedef struct View View;
+
+#define VIEW_NONE 0xFFFFFFFF
+
+typedef enum {
+    ViewDispatcherTypeFullscreen,
+} ViewDispatcherType;
+
+typedef uint32_t (*ViewNavigationCallback)(void* context);
+typedef void (*ViewDispatcherTickEventCallback)(void* context);
+
+ViewDispatcher* view_dispatcher_alloc(void);
+void view_dispatcher_free(ViewDispatcher* view_dispatcher);
+void view_dispatcher_add_view(ViewDispatcher* view_dispatcher, uint32_t view_id, View* view);
+void view_dispatcher_remove_view(ViewDispatcher* view_dispatcher, uint32_t view_id);
+void view_dispatcher_attach_to_gui(ViewDispatcher* view_dispatcher, Gui* gui, ViewDispatcherType type);
+void view_dispatcher_switch_to_view(ViewDispatcher* view_dispatcher, uint32_t view_id);
+void view_dispatcher_set_event_callback_context(ViewDispatcher* view_dispatcher, void* context);
+void view_dispatcher_set_tick_event_callback(
+    ViewDispatcher* view_dispatcher,
+    ViewDispatcherTickEventCallback callback,
+    uint32_t tick_period);
+void view_dispatcher_run(ViewDispatcher* view_dispatcher);
+void view_dispatcher_stop(ViewDispatcher* view_dispatcher);
+void view_set_previous_callback(View* view, ViewNavigationCallback callback);
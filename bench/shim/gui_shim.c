@@ -0,0 +1,123 @@
+#include <gui/gui.h>
+#include <gui/view_dispatcher.h>
+#include <gui/modules/text_input.h>
+#include <notification/notification_messages.h>
+
+/* Nothing is rendered on the host. Widths follow the 6 px FontSecondary
+ * cell so layout code still wraps text the way it does on the device. */
+
+struct NotificationMessage {
+    uint8_t unused;
+};
+
+const NotificationMessage message_vibro_on;
+const NotificationMessage message_vibro_off;
+const NotificationMessage message_blue_255;
+const NotificationMessage message_blue_0;
+const NotificationMessage message_delay_50;
+const NotificationMessage message_delay_100;
+const NotificationMessage message_delay_250;
+
+void notification_message(NotificationApp* app, const NotificationSequence* sequence) {
+    UNUSED(app);
+    UNUSED(sequence);
+}
+
+void canvas_clear(Canvas* canvas) {
+    UNUSED(canvas);
+}
+
+void canvas_set_color(Canvas* canvas, Color color) {
+    UNUSED(canvas);
+    UNUSED(color);
+}
+
+void canvas_set_font(Canvas* canvas, Font font) {
+    UNUSED(canvas);
+    UNUSED(font);
+}
+
+void canvas_draw_str(Canvas* canvas, int32_t x, int32_t y, const char* str) {
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(str);
+}
+
+uint64_t furi_shim_string_width_calls;
+uint64_t furi_shim_glyph_width_calls;
+
+uint16_t canvas_string_width(Canvas* canvas, const char* str) {
+    UNUSED(canvas);
+    furi_shim_string_width_calls++;
+    return (uint16_t)(strlen(str) * 6);
+}
+
+uint16_t canvas_glyph_width(Canvas* canvas, uint16_t symbol) {
+    UNUSED(canvas);
+    UNUSED(symbol);
+    furi_shim_glyph_width_calls++;
+    return 6;
+}
+
+void canvas_draw_box(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height) {
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(width);
+    UNUSED(height);
+}
+
+void canvas_draw_rbox(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height, size_t radius) {
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(width);
+    UNUSED(height);
+    UNUSED(radius);
+}
+
+void canvas_draw_rframe(Canvas* canvas, int32_t x, int32_t y, size_t width, size_t height, size_t radius) {
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(width);
+    UNUSED(height);
+    UNUSED(radius);
+}
+
+void canvas_draw_disc(Canvas* canvas, int32_t x, int32_t y, size_t radius) {
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(radius);
+}
+
+void canvas_draw_circle(Canvas* canvas, int32_t x, int32_t y, size_t radius) {
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+    UNUSED(radius);
+}
+
+void canvas_draw_line(Canvas* canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+    UNUSED(canvas);
+    UNUSED(x1);
+    UNUSED(y1);
+    UNUSED(x2);
+    UNUSED(y2);
+}
+
+void canvas_draw_dot(Canvas* canvas, int32_t x, int32_t y) {
+    UNUSED(canvas);
+    UNUSED(x);
+    UNUSED(y);
+}
+
+void view_port_update(ViewPort* view_port) {
+    UNUSED(view_port);
+}
+
+void view_dispatcher_stop(ViewDispatcher* view_dispatcher) {
+    UNUSED(view_dispatcher);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <furi.h>
+
+#define RECORD_NOTIFICATION "notification"
+
+typedef struct NotificationApp NotificationApp;
+typedef struct NotificationMessage NotificationMessage;
+typedef const NotificationMessage* NotificationSequence[];
+
+void notification_message(NotificationApp* app, const NotificationSequence* sequence);
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <notification/notification.h>
+
+extern const NotificationMessage message_vibro_on;
+extern const NotificationMessage message_vibro_off;
+extern const NotificationMessage message_blue_255;
+extern const NotificationMessage message_blue_0;
+extern const NotificationMessage message_delay_50;
+extern const NotificationMessage message_delay_100;
+extern const NotificationMessage message_delay_250;
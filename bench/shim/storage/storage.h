@@ -0,0 +1,69 @@
+#pragma once
+
+/* Host stand-in for the storage service. Paths under /ext are mapped to
+ * the directory passed to furi_shim_storage_root() */
+
+#include <furi.h>
+
+#define RECORD_STORAGE "storage"
+
+#define APP_ASSETS_PATH(path) "/ext/apps_assets/zeromesh/" path
+
+typedef struct Storage Storage;
+typedef struct File File;
+
+typedef enum {
+    FSAM_READ = (1 << 0),
+    FSAM_WRITE = (1 << 1),
+    FSAM_READ_WRITE = FSAM_READ | FSAM_WRITE,
+} FS_AccessMode;
+
+typedef enum {
+    FSOM_OPEN_EXISTING = 1,
+    FSOM_OPEN_ALWAYS = 2,
+    FSOM_OPEN_APPEND = 4,
+    FSOM_CREATE_NEW = 8,
+    FSOM_CREATE_ALWAYS = 16,
+} FS_OpenMode;
+
+typedef enum {
+    FSE_OK,
+    FSE_NOT_READY,
+    FSE_EXIST,
+    FSE_NOT_EXIST,
+    FSE_INTERNAL,
+} FS_Error;
+
+#define FSF_DIRECTORY (1 << 0)
+
+typedef struct {
+    uint8_t flags;
+    uint64_t size;
+} FileInfo;
+
+/* Calls made through the shim, for the store benchmark */
+extern uint64_t furi_shim_storage_reads;
+extern uint64_t furi_shim_storage_read_bytes;
+extern uint64_t furi_shim_storage_writes;
+
+File* storage_file_alloc(Storage* storage);
+void storage_file_free(File* file);
+bool storage_file_open(File* file, const char* path, FS_AccessMode access_mode, FS_OpenMode open_mode);
+bool storage_file_close(File* file);
+size_t storage_file_read(File* file, void* buff, size_t bytes_to_read);
+size_t storage_file_write(File* file, const void* buff, size_t bytes_to_write);
+bool storage_file_seek(File* file, uint32_t offset, bool from_start);
+uint64_t storage_file_tell(File* file);
+uint64_t storage_file_size(File* file);
+bool storage_file_truncate(File* file);
+
+bool storage_dir_open(File* file, const char* path);
+bool storage_dir_close(File* file);
+bool storage_dir_read(File* file, FileInfo* fileinfo, char* name, uint16_t name_length);
+bool file_info_is_dir(const FileInfo* file_info);
+
+FS_Error storage_common_mkdir(Storage* storage, const char* path);
+FS_Error storage_common_remove(Storage* storage, const char* path);
+FS_Error storage_common_rename(Storage* storage, const char* old_path, const char* new_path);
+
+void furi_shim_storage_root(const char* dir);
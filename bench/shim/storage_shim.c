@@ -0,0 +1,169 @@
+#include <storage/storage.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct File {
+    FILE* fp;
+    DIR* dir;
+};
+
+static char shim_root[512] = ".";
+
+uint64_t furi_shim_storage_reads;
+uint64_t furi_shim_storage_read_bytes;
+uint64_t furi_shim_storage_writes;
+
+void furi_shim_storage_root(const char* dir) {
+    snprintf(shim_root, sizeof(shim_root), "%s", dir);
+}
+
+static void shim_path(char* out, size_t size, const char* path) {
+    if(strncmp(path, "/ext", 4) == 0) {
+        snprintf(out, size, "%s%s", shim_root, path + 4);
+    } else {
+        snprintf(out, size, "%s", path);
+    }
+}
+
+File* storage_file_alloc(Storage* storage) {
+    UNUSED(storage);
+    return calloc(1, sizeof(File));
+}
+
+void storage_file_free(File* file) {
+    storage_file_close(file);
+    free(file);
+}
+
+bool storage_file_open(File* file, const char* path, FS_AccessMode access_mode, FS_OpenMode open_mode) {
+    char host[1024];
+    shim_path(host, sizeof(host), path);
+    storage_file_close(file);
+
+    switch(open_mode) {
+    case FSOM_OPEN_EXISTING:
+        file->fp = fopen(host, access_mode == FSAM_READ ? "rb" : "r+b");
+        break;
+    case FSOM_OPEN_ALWAYS:
+        file->fp = fopen(host, "r+b");
+        if(!file->fp) file->fp = fopen(host, "w+b");
+        break;
+    case FSOM_OPEN_APPEND:
+        file->fp = fopen(host, access_mode == FSAM_WRITE ? "ab" : "a+b");
+        break;
+    case FSOM_CREATE_NEW:
+        if(access(host, F_OK) == 0) return false;
+        file->fp = fopen(host, "w+b");
+        break;
+    case FSOM_CREATE_ALWAYS:
+        file->fp = fopen(host, "w+b");
+        break;
+    }
+    return file->fp != NULL;
+}
+
+bool storage_file_close(File* file) {
+    if(file->fp) fclose(file->fp);
+    file->fp = NULL;
+    return true;
+}
+
+size_t storage_file_read(File* file, void* buff, size_t bytes_to_read) {
+    if(!file->fp) return 0;
+    size_t got = fread(buff, 1, bytes_to_read, file->fp);
+    furi_shim_storage_reads++;
+    furi_shim_storage_read_bytes += got;
+    return got;
+}
+
+size_t storage_file_write(File* file, const void* buff, size_t bytes_to_write) {
+    if(!file->fp) return 0;
+    furi_shim_storage_writes++;
+    return fwrite(buff, 1, bytes_to_write, file->fp);
+}
+
+bool storage_file_seek(File* file, uint32_t offset, bool from_start) {
+    if(!file->fp) return false;
+    return fseek(file->fp, (long)offset, from_start ? SEEK_SET : SEEK_CUR) == 0;
+}
+
+uint64_t storage_file_tell(File* file) {
+    if(!file->fp) return 0;
+    return (uint64_t)ftell(file->fp);
+}
+
+uint64_t storage_file_size(File* file) {
+    if(!file->fp) return 0;
+    struct stat st;
+    fflush(file->fp);
+    if(fstat(fileno(file->fp), &st) != 0) return 0;
+    return (uint64_t)st.st_size;
+}
+
+bool storage_file_truncate(File* file) {
+    if(!file->fp) return false;
+    fflush(file->fp);
+    return ftruncate(fileno(file->fp), ftell(file->fp)) == 0;
+}
+
+bool storage_dir_open(File* file, const char* path) {
+    char host[1024];
+    shim_path(host, sizeof(host), path);
+    file->dir = opendir(host);
+    return file->dir != NULL;
+}
+
+bool storage_dir_close(File* file) {
+    if(file->dir) closedir(file->dir);
+    file->dir = NULL;
+    return true;
+}
+
+bool storage_dir_read(File* file, FileInfo* fileinfo, char* name, uint16_t name_length) {
+    if(!file->dir) return false;
+    struct dirent* entry;
+    while((entry = readdir(file->dir)) != NULL) {
+        if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        if(fileinfo) {
+            fileinfo->flags = entry->d_type == DT_DIR ? FSF_DIRECTORY : 0;
+            fileinfo->size = 0;
+        }
+        if(name) snprintf(name, name_length, "%s", entry->d_name);
+        return true;
+    }
+    return false;
+}
+
+bool file_info_is_dir(const FileInfo* file_info) {
+    return file_info->flags & FSF_DIRECTORY;
+}
+
+FS_Error storage_common_mkdir(Storage* storage, const char* path) {
+    UNUSED(storage);
+    char host[1024];
+    shim_path(host, sizeof(host), path);
+    if(mkdir(host, 0755) == 0) return FSE_OK;
+    return errno == EEXIST ? FSE_EXIST : FSE_INTERNAL;
+}
+
+FS_Error storage_common_remove(Storage* storage, const char* path) {
+    UNUSED(storage);
+    char host[1024];
+    shim_path(host, sizeof(host), path);
+    if(remove(host) == 0) return FSE_OK;
+    return errno == ENOENT ? FSE_NOT_EXIST : FSE_INTERNAL;
+}
+
+FS_Error storage_common_rename(Storage* storage, const char* old_path, const char* new_path) {
+    UNUSED(storage);
+    char old_host[1024];
+    char new_host[1024];
+    shim_path(old_host, sizeof(old_host), old_path);
+    shim_path(new_host, sizeof(new_host), new_path);
+    if(access(new_host, F_OK) == 0) return FSE_EXIST;
+    if(rename(old_host, new_host) == 0) return FSE_OK;
+    return errno == ENOENT ? FSE_NOT_EXIST : FSE_INTERNAL;
+}
@@ -0,0 +1,148 @@
+/* Host benchmark: appends a message history to the SD store through
+ * history_add/store_flush, reopens it, then pages one conversation back
+ * from its newest record and reports time and storage calls per page. */
+
+#define _GNU_SOURCE
+
+#include "bench_util.h"
+#include "zeromesh_app.h"
+#include "zeromesh_history.h"
+#include "zeromesh_store.h"
+
+#include <storage/storage.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define BENCH_PEERS   8
+#define BENCH_SELF    0x12345678UL
+#define BENCH_PEER(i) (0x10000000UL + (i))
+
+static const uint32_t depths[] = {0, 64, 512, 2048};
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [-n records]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    uint32_t records = 10000;
+    int opt;
+    while((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch(opt) {
+        case 'n':
+            records = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if(optind != argc || records == 0 || records > BENCH_SAMPLES_MAX) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    char root[64];
+    if(!bench_sd_create(root, sizeof(root))) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    ZeroMeshApp* app = app_alloc();
+    uint32_t* flush_ns = malloc(records * sizeof(uint32_t));
+    uint32_t flushes = 0;
+    uint64_t append_ns = 0;
+    uint64_t writes = furi_shim_storage_writes;
+    char text[MSG_TEXT_LEN];
+
+    /* Every third message goes to the primary channel, the rest are DMs
+     * from BENCH_PEERS nodes in turn */
+    for(uint32_t i = 0; i < records; i++) {
+        snprintf(text, sizeof(text), "message %lu from the store benchmark", (unsigned long)i);
+        uint32_t from = BENCH_PEER(i % BENCH_PEERS);
+        uint32_t to = (i % 3 == 0) ? HISTORY_CONV_BROADCAST : BENCH_SELF;
+        uint32_t batches = app->store.flush_batches;
+
+        uint64_t t0 = bench_now_ns();
+        history_add(app, text, from, to, 0, false);
+        store_flush(app, false);
+        uint64_t dt = bench_now_ns() - t0;
+
+        append_ns += dt;
+        if(app->store.flush_batches != batches) flush_ns[flushes++] = (uint32_t)dt;
+    }
+    store_flush(app, true);
+    writes = furi_shim_storage_writes - writes;
+
+    bench_sort(flush_ns, flushes);
+    printf("append     %lu records, %.2f us/record, %lu flushes p50 %.1f us  p99 %.1f us  max %.1f us\n",
+           (unsigned long)records,
+           (double)append_ns / records / 1000.0,
+           (unsigned long)flushes,
+           bench_pct(flush_ns, flushes, 50, 1000.0),
+           bench_pct(flush_ns, flushes, 99, 1000.0),
+           bench_pct(flush_ns, flushes, 100, 1000.0));
+    printf("store      %lu flushed, %lu lost, %lu rotations, %llu writes\n",
+           (unsigned long)app->store.flushed,
+           (unsigned long)app->store.dropped,
+           (unsigned long)app->store.rotations,
+           (unsigned long long)writes);
+    app_free(app);
+    free(flush_ns);
+
+    uint64_t reads = furi_shim_storage_reads;
+    uint64_t t0 = bench_now_ns();
+    app = app_alloc();
+    printf("open       %.1f us, %llu reads, %lu live + %lu rotated records\n",
+           (double)(bench_now_ns() - t0) / 1000.0,
+           (unsigned long long)(furi_shim_storage_reads - reads),
+           (unsigned long)(app->store.total - app->store.base),
+           (unsigned long)app->store.old_count);
+
+    Message page[MSG_PAGE_SIZE];
+    uint32_t conv = BENCH_PEER(1);
+    uint16_t got;
+    bool exhausted;
+
+    for(size_t d = 0; d < COUNT_OF(depths); d++) {
+        reads = furi_shim_storage_reads;
+        t0 = bench_now_ns();
+        bool ok = store_scan(app, conv, app->store.flushed, depths[d], page, MSG_PAGE_SIZE, &got, &exhausted);
+        printf("page skip  %4lu: %.1f us, %llu reads, %u msgs%s\n",
+               (unsigned long)depths[d],
+               (double)(bench_now_ns() - t0) / 1000.0,
+               (unsigned long long)(furi_shim_storage_reads - reads),
+               got,
+               ok ? "" : " (failed)");
+    }
+
+    /* Scrolling back page by page, each scan anchored on the last record
+     * returned by the previous one */
+    uint32_t pages = 0;
+    uint32_t msgs = 0;
+    uint32_t bad = 0;
+    uint32_t top = app->store.flushed;
+    reads = furi_shim_storage_reads;
+    t0 = bench_now_ns();
+    do {
+        if(!store_scan(app, conv, top, 0, page, MSG_PAGE_SIZE, &got, &exhausted) || got == 0) break;
+        for(uint16_t i = 0; i < got; i++) {
+            if(page[i].from != conv || page[i].seq >= top) bad++;
+            top = page[i].seq;
+        }
+        msgs += got;
+        pages++;
+    } while(!exhausted);
+    uint64_t walk_ns = bench_now_ns() - t0;
+    printf("page walk  %lu pages, %lu msgs (%lu out of order), %.1f us/page, %.1f reads/page\n",
+           (unsigned long)pages,
+           (unsigned long)msgs,
+           (unsigned long)bad,
+           pages ? (double)walk_ns / pages / 1000.0 : 0.0,
+           pages ? (double)(furi_shim_storage_reads - reads) / pages : 0.0);
+
+    app_free(app);
+    bench_sd_remove(root);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,256 @@
+/* Host benchmark: scripts bursts of text messages through send_text_message
+ * into the paced TX worker, against a simulated radio that takes frames off
+ * the serial shim, holds up to maxlen packets, drains one per airtime and
+ * answers every packet and every drain with a QueueStatus frame through the
+ * UART RX path. Reports TX queue depth, time-to-wire latency and drops. */
+
+#define _GNU_SOURCE
+
+#include "bench_util.h"
+#include "zeromesh_app.h"
+#include "zeromesh_protocol.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Any non-zero res tells the worker the radio refused the packet */
+#define BENCH_RES_FULL    1
+#define BENCH_DRAIN_MS    5000
+#define BENCH_INBOX_SIZE  32
+
+typedef struct {
+    uint32_t packet_id;
+} RadioMsg;
+
+typedef struct {
+    ZeroMeshApp* app;
+    FuriMessageQueue* inbox;
+    uint32_t maxlen;
+    uint32_t airtime_ms;
+    uint32_t held;
+    volatile bool stop;
+
+    /* Written on the TX thread only */
+    uint32_t last_id[TX_QUEUE_SIZE];
+    uint32_t last_tick[TX_QUEUE_SIZE];
+    uint32_t* latency_ms;
+    uint32_t latencies;
+    uint32_t cap;
+    volatile uint32_t wired;
+
+    uint32_t accepted;
+    uint32_t refused;
+} Radio;
+
+static void radio_status(int32_t res, uint32_t free, uint32_t maxlen, uint32_t packet_id) {
+    SynBuf body;
+    uint8_t frame[MAX_FRAME_SIZE + 4];
+    syn_queue_status(&body, res, free, maxlen, packet_id);
+    furi_shim_serial_rx(frame, syn_frame(&body, frame));
+}
+
+/* Runs inside tx_wire: finds the pool slot being written to take its
+ * packet id and queue time, then hands the packet to the radio thread */
+static void radio_on_tx(const uint8_t* data, size_t len, void* ctx) {
+    UNUSED(len);
+    Radio* radio = ctx;
+    ZeroMeshApp* app = radio->app;
+    for(uint8_t slot = 0; slot < TX_QUEUE_SIZE; slot++) {
+        TxFrame* f = &app->tx_pool[slot];
+        if(data != f->frame) continue;
+        radio->wired++;
+        if(f->packet_id == 0) return;
+
+        if(f->packet_id != radio->last_id[slot] || f->queued_tick != radio->last_tick[slot]) {
+            radio->last_id[slot] = f->packet_id;
+            radio->last_tick[slot] = f->queued_tick;
+            if(radio->latencies < radio->cap) {
+                radio->latency_ms[radio->latencies++] = furi_get_tick() - f->queued_tick;
+            }
+        }
+        RadioMsg msg = {.packet_id = f->packet_id};
+        furi_message_queue_put(radio->inbox, &msg, FuriWaitForever);
+        return;
+    }
+}
+
+static void* radio_thread_fn(void* ctx) {
+    Radio* radio = ctx;
+    uint32_t next_drain = 0;
+    while(!radio->stop || radio->held > 0) {
+        uint32_t now = furi_get_tick();
+        uint32_t timeout = 10;
+        if(radio->held > 0) {
+            if((int32_t)(next_drain - now) <= 0) {
+                radio->held--;
+                radio_status(0, radio->maxlen - radio->held, radio->maxlen, 0);
+                next_drain = now + radio->airtime_ms;
+            }
+            timeout = next_drain - now < timeout ? next_drain - now : timeout;
+        }
+
+        RadioMsg msg;
+        if(furi_message_queue_get(radio->inbox, &msg, timeout) != FuriStatusOk) continue;
+        if(radio->held < radio->maxlen) {
+            if(radio->held == 0) next_drain = furi_get_tick() + radio->airtime_ms;
+            radio->held++;
+            radio->accepted++;
+            radio_status(0, radio->maxlen - radio->held, radio->maxlen, msg.packet_id);
+        } else {
+            radio->refused++;
+            radio_status(BENCH_RES_FULL, 0, radio->maxlen, msg.packet_id);
+        }
+    }
+    return NULL;
+}
+
+static void usage(const char* argv0) {
+    fprintf(
+        stderr,
+        "usage: %s [-b bursts] [-k messages] [-i ms] [-g ms] [-q maxlen] [-a ms]\n"
+        "  -b bursts    bursts in the script (default 5)\n"
+        "  -k messages  messages per burst (default 12)\n"
+        "  -i ms        gap between messages in a burst (default 0)\n"
+        "  -g ms        gap between bursts (default 1000)\n"
+        "  -q maxlen    packets the simulated radio holds (default 4)\n"
+        "  -a ms        radio airtime per packet (default 40)\n",
+        argv0);
+}
+
+int main(int argc, char** argv) {
+    uint32_t bursts = 5;
+    uint32_t per_burst = 12;
+    uint32_t msg_gap = 0;
+    uint32_t burst_gap = 1000;
+    Radio radio = {.maxlen = 4, .airtime_ms = 40};
+    int opt;
+    while((opt = getopt(argc, argv, "b:k:i:g:q:a:h")) != -1) {
+        switch(opt) {
+        case 'b':
+            bursts = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'k':
+            per_burst = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'i':
+            msg_gap = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'g':
+            burst_gap = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'q':
+            radio.maxlen = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'a':
+            radio.airtime_ms = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if(optind != argc || bursts == 0 || per_burst == 0 || radio.maxlen == 0 || radio.airtime_ms == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    char root[64];
+    if(!bench_sd_create(root, sizeof(root))) {
+        perror("mkdtemp");
+        return 1;
+    }
+    furi_get_tick();
+    ZeroMeshApp* app = app_alloc();
+    app_start(app);
+
+    uint32_t sent = bursts * per_burst;
+    radio.app = app;
+    radio.inbox = furi_message_queue_alloc(BENCH_INBOX_SIZE, sizeof(RadioMsg));
+    radio.cap = sent;
+    radio.latency_ms = malloc(sent * sizeof(uint32_t));
+    furi_shim_serial_on_tx(radio_on_tx, &radio);
+    pthread_t radio_thread;
+    pthread_create(&radio_thread, NULL, radio_thread_fn, &radio);
+
+    uint64_t depth_sum = 0;
+    uint32_t depth_max = 0;
+    char text[MSG_TEXT_LEN];
+    uint32_t start = furi_get_tick();
+    for(uint32_t b = 0; b < bursts; b++) {
+        uint32_t due = start + b * burst_gap;
+        while((int32_t)(furi_get_tick() - due) < 0) {
+            app_tick(app);
+            furi_delay_ms(1);
+        }
+        for(uint32_t k = 0; k < per_burst; k++) {
+            snprintf(text, sizeof(text), "burst %lu message %lu", (unsigned long)b, (unsigned long)k);
+            send_text_message(app, text, 0xFFFFFFFF);
+            uint32_t depth = TX_QUEUE_SIZE - furi_message_queue_get_count(app->tx_free);
+            depth_sum += depth;
+            if(depth > depth_max) depth_max = depth;
+            app_tick(app);
+            if(msg_gap) furi_delay_ms(msg_gap);
+        }
+    }
+
+    /* Until the worker has handed back every slot and settled its retries */
+    uint32_t idle_since = furi_get_tick();
+    uint32_t settle = TX_RETRY_MS * 2;
+    uint32_t wired = radio.wired;
+    while(furi_get_tick() - idle_since < settle) {
+        app_tick(app);
+        furi_delay_ms(1);
+        if(furi_message_queue_get_count(app->tx_free) != TX_QUEUE_SIZE || radio.wired != wired) {
+            wired = radio.wired;
+            idle_since = furi_get_tick();
+        }
+        if(furi_get_tick() - start > bursts * burst_gap + BENCH_DRAIN_MS) break;
+    }
+    uint32_t elapsed = furi_get_tick() - start;
+
+    app_stop(app);
+    radio.stop = true;
+    pthread_join(radio_thread, NULL);
+    furi_shim_serial_on_tx(NULL, NULL);
+
+    uint32_t queued = sent - app->tx_drops;
+    bench_sort(radio.latency_ms, radio.latencies);
+    printf("script     %lu bursts of %lu messages, %lu ms apart (%lu ms within), radio maxlen %lu, airtime %lu ms\n",
+           (unsigned long)bursts,
+           (unsigned long)per_burst,
+           (unsigned long)burst_gap,
+           (unsigned long)msg_gap,
+           (unsigned long)radio.maxlen,
+           (unsigned long)radio.airtime_ms);
+    printf("queue      %lu slots, depth mean %.1f at enqueue, max %lu (app %u)\n",
+           (unsigned long)TX_QUEUE_SIZE,
+           (double)depth_sum / sent,
+           (unsigned long)depth_max,
+           app->tx_depth_max);
+    printf("wire ms    p50 %.0f  p90 %.0f  p99 %.0f  max %.0f over %lu packets\n",
+           bench_pct(radio.latency_ms, radio.latencies, 50, 1.0),
+           bench_pct(radio.latency_ms, radio.latencies, 90, 1.0),
+           bench_pct(radio.latency_ms, radio.latencies, 99, 1.0),
+           bench_pct(radio.latency_ms, radio.latencies, 100, 1.0),
+           (unsigned long)radio.latencies);
+    printf("drops      %lu sent, %lu queued, %lu dropped at enqueue, %lu failed after retries\n",
+           (unsigned long)sent,
+           (unsigned long)queued,
+           (unsigned long)app->tx_drops,
+           (unsigned long)app->tx_failed);
+    printf("radio      %lu accepted, %lu refused, %lu retries, %lu frames written in %lu ms\n",
+           (unsigned long)radio.accepted,
+           (unsigned long)radio.refused,
+           (unsigned long)app->tx_retries,
+           (unsigned long)app->tx_frames,
+           (unsigned long)elapsed);
+
+    furi_message_queue_free(radio.inbox);
+    free(radio.latency_ms);
+    app_free(app);
+    bench_sd_remove(root);
+    return 0;
+}
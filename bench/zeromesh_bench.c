@@ -0,0 +1,236 @@
+/* Host benchmark: replays a .bin serial capture through rx_thread_fn and
+ * the main-loop event drain, then reports throughput, per-frame decode
+ * latency and heap allocations. With -u the capture is fed through the
+ * UART DMA callback instead of the app's replay thread, so stream buffer
+ * overflows show up the way they would on the wire. */
+
+#define _GNU_SOURCE
+
+#include "bench_util.h"
+#include "zeromesh_app.h"
+#include "zeromesh_protocol.h"
+#include "zeromesh_capture.h"
+
+#include <storage/storage.h>
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_SETTLE_MS 200
+
+typedef struct {
+    const char* path;
+    uint32_t baud;
+    uint64_t bytes;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    volatile bool done;
+} UartFeed;
+
+/* Paces the capture's chunks at baud (10 bits per byte, 0 = unpaced) into
+ * the DMA RX callback */
+static void* uart_feed_fn(void* ctx) {
+    UartFeed* feed = ctx;
+    FILE* fp = fopen(feed->path, "rb");
+    CaptureHeader hdr;
+    CaptureRecord rec;
+    uint8_t buf[RX_SPAN_SIZE];
+
+    feed->start_ns = bench_now_ns();
+    if(fp && fread(&hdr, sizeof(hdr), 1, fp) == 1 && hdr.magic == CAPTURE_MAGIC) {
+        while(fread(&rec, sizeof(rec), 1, fp) == 1) {
+            if(rec.len > sizeof(buf) || fread(buf, 1, rec.len, fp) != rec.len) break;
+            if(feed->baud) {
+                uint64_t due = feed->start_ns + feed->bytes * 10ULL * 1000000000ULL / feed->baud;
+                while(bench_now_ns() < due) sched_yield();
+            }
+            if(!furi_shim_serial_rx(buf, rec.len)) break;
+            feed->bytes += rec.len;
+        }
+    }
+    feed->end_ns = bench_now_ns();
+    if(fp) fclose(fp);
+    feed->done = true;
+    return NULL;
+}
+
+static void usage(const char* argv0) {
+    fprintf(
+        stderr,
+        "usage: %s [-s speed] [-u baud] [-g frames] capture.bin\n"
+        "  -s speed   replay speed as a multiple of real time, 0 = as fast as possible (default 0)\n"
+        "  -u baud    feed the capture through the UART RX callback at baud, 0 = unpaced\n"
+        "  -g frames  first write a synthetic capture with this many packets to capture.bin\n",
+        argv0);
+}
+
+int main(int argc, char** argv) {
+    uint32_t speed = 0;
+    long synth = -1;
+    bool uart = false;
+    UartFeed feed = {0};
+    int opt;
+    while((opt = getopt(argc, argv, "s:u:g:h")) != -1) {
+        switch(opt) {
+        case 's':
+            speed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'u':
+            uart = true;
+            feed.baud = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'g':
+            synth = strtol(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if(optind != argc - 1 || speed >= REPLAY_SPEED_MAX || synth == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char* capture = argv[optind];
+
+    if(synth > 0 && !syn_capture(capture, (uint32_t)synth)) {
+        fprintf(stderr, "cannot write %s\n", capture);
+        return 1;
+    }
+
+    char capture_abs[PATH_MAX];
+    if(!realpath(capture, capture_abs)) {
+        fprintf(stderr, "cannot open %s\n", capture);
+        return 1;
+    }
+
+    /* The app replays the newest file in CAPTURE_DIR, so give it an SD
+     * card of its own holding just this capture */
+    char root[64];
+    char link_path[PATH_MAX];
+    if(!bench_sd_create(root, sizeof(root))) {
+        perror("mkdtemp");
+        return 1;
+    }
+    storage_common_mkdir(NULL, CAPTURE_DIR);
+    snprintf(link_path, sizeof(link_path), "%s%s/00000000.bin", root, CAPTURE_DIR + 4);
+    if(!uart && symlink(capture_abs, link_path) != 0) {
+        perror("symlink");
+        bench_sd_remove(root);
+        return 1;
+    }
+
+    bench_frames_alloc();
+    furi_get_tick();
+    ZeroMeshApp* app = app_alloc();
+
+    bench_thread_allocs = 0;
+    bench_counting = true;
+    uint64_t start_ns = bench_now_ns();
+    app_start(app);
+    request_info(app);
+    uint8_t replay_speed = speed ? (uint8_t)speed : REPLAY_SPEED_MAX;
+    pthread_t feeder;
+    if(uart) {
+        feed.path = capture_abs;
+        pthread_create(&feeder, NULL, uart_feed_fn, &feed);
+    } else {
+        app->replay_speed = replay_speed;
+    }
+
+    uint32_t seen = 0;
+    uint32_t idle_since = 0;
+    bool started = uart;
+    for(;;) {
+        app_tick(app);
+
+        if(app->replay_thread) started = true;
+        bool feeding = uart ? !feed.done : app->replay_thread != NULL;
+        if(!started || feeding || furi_stream_buffer_bytes_available(app->rx_stream) > 0) continue;
+        uint32_t frames = __atomic_load_n(&bench_frames.frames, __ATOMIC_ACQUIRE);
+        if(frames != seen || idle_since == 0) {
+            seen = frames;
+            idle_since = furi_get_tick();
+        } else if(furi_get_tick() - idle_since >= BENCH_SETTLE_MS) {
+            break;
+        }
+    }
+
+    if(uart) pthread_join(feeder, NULL);
+    app_stop(app);
+    bench_counting = false;
+    uint64_t end_ns = bench_now_ns();
+
+    uint32_t frames = bench_frames.frames;
+    uint32_t sampled = frames < bench_frames.cap ? frames : bench_frames.cap;
+    uint64_t rx_allocs = 0;
+    uint32_t rx_allocs_max = 0;
+    for(uint32_t i = 0; i < sampled; i++) {
+        rx_allocs += bench_frames.allocs[i];
+        if(bench_frames.allocs[i] > rx_allocs_max) rx_allocs_max = bench_frames.allocs[i];
+    }
+    bench_sort(bench_frames.cycles, sampled);
+    double scale = furi_hal_cortex_instructions_per_microsecond();
+
+    double span_s = (double)(bench_frames.last_ns - bench_frames.first_ns) / 1e9;
+    double wall_s = (double)(end_ns - start_ns) / 1e9;
+    double per_frame = frames ? 1.0 / frames : 0.0;
+
+    if(uart) {
+        double feed_s = (double)(feed.end_ns - feed.start_ns) / 1e9;
+        printf("capture    %s (%llu B through the UART callback, %s)\n",
+               capture,
+               (unsigned long long)feed.bytes,
+               feed.baud ? "paced" : "unpaced");
+        printf("uart       %.0f B/s offered (%lu baud), %lu B received, %lu B overflow, %lu overruns\n",
+               feed_s > 0 ? feed.bytes / feed_s : 0.0,
+               (unsigned long)feed.baud,
+               (unsigned long)app->rx_bytes,
+               (unsigned long)app->rx_overflow,
+               (unsigned long)app->rx_uart_overrun);
+    } else {
+        printf("capture    %s (%lu B replayed, speed %s)\n",
+               capture,
+               (unsigned long)app->replay_bytes,
+               replay_speed_name(replay_speed));
+    }
+    printf("frames     %lu decoded, %lu ok, %lu failed, %lu bad len, %lu resyncs\n",
+           (unsigned long)frames,
+           (unsigned long)app->rx_frames_ok,
+           (unsigned long)app->rx_decode_fail,
+           (unsigned long)app->framing.bad_len,
+           (unsigned long)app->framing.resyncs);
+    printf("rate       %.0f frames/s over %.3f s (%.0f frames/s wall, %.3f s)\n",
+           span_s > 0 ? (frames - 1) / span_s : 0.0,
+           span_s,
+           wall_s > 0 ? frames / wall_s : 0.0,
+           wall_s);
+    printf("decode us  p50 %.2f  p90 %.2f  p99 %.2f  max %.2f\n",
+           bench_pct(bench_frames.cycles, sampled, 50, scale),
+           bench_pct(bench_frames.cycles, sampled, 90, scale),
+           bench_pct(bench_frames.cycles, sampled, 99, scale),
+           bench_pct(bench_frames.cycles, sampled, 100, scale));
+    printf("allocs     rx %.2f/frame (max %lu), all threads %.2f/frame, %.1f B/frame\n",
+           (double)rx_allocs * per_frame,
+           (unsigned long)rx_allocs_max,
+           (double)bench_allocs * per_frame,
+           (double)bench_alloc_bytes * per_frame);
+    printf("events     %lu posted, %lu merged, %lu dropped, %lu lost, %lu waits, stream hwm %lu B, %lu stalls\n",
+           (unsigned long)app->rx_event_head,
+           (unsigned long)app->rx_event_merged,
+           (unsigned long)app->rx_event_dropped,
+           (unsigned long)app->rx_event_lost,
+           (unsigned long)app->rx_event_waits,
+           (unsigned long)app->rx_stream_hwm,
+           (unsigned long)app->rx_stalls);
+    printf("tx         %llu B written to the serial shim\n", (unsigned long long)furi_shim_serial_tx_bytes);
+
+    app_free(app);
+    bench_frames_free();
+    bench_sd_remove(root);
+    return 0;
+}
@@ -0,0 +1,80 @@
+/* Trimmed nanopb constant definitions for ZeroMesh */
+/* Field lists are subsets of the nanopb-0.4.9.1 output in meshtastic/ */
+/* Linked instead of the generated meshtastic tables when ZEROMESH_MIN_PB is set in application.fam */
+
+#include "meshtastic/mesh.pb.h"
+#include "meshtastic/telemetry.pb.h"
+#if PB_PROTO_HEADER_VERSION != 40
+#error Regenerate this file with the current version of nanopb generator.
+#endif
+
+/* FromRadio packets are walked by zeromesh_wire.c, so only the TX side of
+ * MeshPacket and the two bodies still handed to pb_decode need tables.
+ * Fields left out here are skipped on the wire by pb_decode. */
+
+#define zm_Data_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UENUM,    portnum,           1) \
+X(a, CALLBACK, SINGULAR, BYTES,    payload,           2) \
+X(a, STATIC,   SINGULAR, BOOL,     want_response,     3)
+#define zm_Data_CALLBACK pb_default_field_callback
+#define zm_Data_DEFAULT NULL
+
+#define zm_MeshPacket_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, FIXED32,  from,              1) \
+X(a, STATIC,   SINGULAR, FIXED32,  to,                2) \
+X(a, STATIC,   SINGULAR, UINT32,   channel,           3) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload_variant,decoded,payload_variant.decoded),   4) \
+X(a, STATIC,   SINGULAR, FIXED32,  id,                6) \
+X(a, STATIC,   SINGULAR, UINT32,   hop_limit,         9) \
+X(a, STATIC,   SINGULAR, BOOL,     want_ack,         10)
+#define zm_MeshPacket_CALLBACK NULL
+#define zm_MeshPacket_DEFAULT NULL
+
+#define zm_ToRadio_FIELDLIST(X, a) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload_variant,packet,payload_variant.packet),   1) \
+X(a, STATIC,   ONEOF,    UINT32,   (payload_variant,want_config_id,payload_variant.want_config_id),   3) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (payload_variant,heartbeat,payload_variant.heartbeat),   7)
+#define zm_ToRadio_CALLBACK NULL
+#define zm_ToRadio_DEFAULT NULL
+
+#define zm_Heartbeat_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   nonce,             1)
+#define zm_Heartbeat_CALLBACK NULL
+#define zm_Heartbeat_DEFAULT NULL
+
+#define zm_MyNodeInfo_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, UINT32,   my_node_num,       1)
+#define zm_MyNodeInfo_CALLBACK NULL
+#define zm_MyNodeInfo_DEFAULT NULL
+
+#define zm_DeviceMetrics_FIELDLIST(X, a) \
+X(a, STATIC,   OPTIONAL, UINT32,   battery_level,     1) \
+X(a, STATIC,   OPTIONAL, FLOAT,    voltage,           2)
+#define zm_DeviceMetrics_CALLBACK NULL
+#define zm_DeviceMetrics_DEFAULT NULL
+
+#define zm_Telemetry_FIELDLIST(X, a) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (variant,device_metrics,variant.device_metrics),   2)
+#define zm_Telemetry_CALLBACK NULL
+#define zm_Telemetry_DEFAULT NULL
+
+PB_BIND(zm_Data, meshtastic_Data, AUTO)
+
+
+PB_BIND(zm_MeshPacket, meshtastic_MeshPacket, AUTO)
+
+
+PB_BIND(zm_ToRadio, meshtastic_ToRadio, AUTO)
+
+
+PB_BIND(zm_Heartbeat, meshtastic_Heartbeat, AUTO)
+
+
+PB_BIND(zm_MyNodeInfo, meshtastic_MyNodeInfo, AUTO)
+
+
+PB_BIND(zm_DeviceMetrics, meshtastic_DeviceMetrics, AUTO)
+
+
+PB_BIND(zm_Telemetry, meshtastic_Telemetry, AUTO)
+
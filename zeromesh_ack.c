@@ -0,0 +1,94 @@
+#include "zeromesh_ack.h"
+#include "zeromesh_history.h"
+#include "zeromesh_roster.h"
+#include "zeromesh_redraw.h"
+
+#include <string.h>
+
+static const uint16_t ack_hist_limits_ms[ACK_HIST_BUCKETS - 1] = {1000, 2000, 5000, 15000, 30000};
+
+static void ack_record_rtt(ZeroMeshApp* app, uint32_t rtt) {
+    uint8_t bucket = 0;
+    while(bucket < ACK_HIST_BUCKETS - 1 && rtt >= ack_hist_limits_ms[bucket]) bucket++;
+    if(app->ack_hist[bucket] < UINT16_MAX) app->ack_hist[bucket]++;
+    app->ack_rtt_last_ms = rtt;
+}
+
+void ack_track(ZeroMeshApp* app, uint32_t packet_id, uint32_t to, uint32_t seq) {
+    if(packet_id == 0) return;
+
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+    PendingAck* slot = &app->ack_pending[0];
+    for(uint8_t i = 0; i < ACK_PENDING_MAX; i++) {
+        PendingAck* p = &app->ack_pending[i];
+        if(p->packet_id == 0) {
+            slot = p;
+            break;
+        }
+        if(p->sent_tick - slot->sent_tick > 0x80000000UL) slot = p;
+    }
+    uint32_t evicted_seq = slot->seq;
+    bool evicted = slot->packet_id != 0;
+    if(evicted) app->acks_expired++;
+
+    slot->packet_id = packet_id;
+    slot->to = to;
+    slot->seq = seq;
+    slot->sent_tick = furi_get_tick();
+    furi_mutex_release(app->lock);
+
+    if(evicted) history_set_ack(app, evicted_seq, MsgAckFailed);
+}
+
+void ack_resolve(ZeroMeshApp* app, uint32_t request_id, uint32_t from, uint32_t error) {
+    if(request_id == 0) return;
+
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+    PendingAck* p = NULL;
+    for(uint8_t i = 0; i < ACK_PENDING_MAX; i++) {
+        if(app->ack_pending[i].packet_id == request_id) {
+            p = &app->ack_pending[i];
+            break;
+        }
+    }
+    if(!p || (error == 0 && p->to != 0xFFFFFFFF && from != p->to)) {
+        furi_mutex_release(app->lock);
+        return;
+    }
+
+    PendingAck done = *p;
+    memset(p, 0, sizeof(*p));
+    uint32_t rtt = furi_get_tick() - done.sent_tick;
+    if(error == 0) {
+        app->acks_ok++;
+        ack_record_rtt(app, rtt);
+    } else {
+        app->acks_failed++;
+    }
+    furi_mutex_release(app->lock);
+
+    history_set_ack(app, done.seq, error == 0 ? MsgAckDelivered : MsgAckFailed);
+    if(error == 0 && done.to != 0xFFFFFFFF) roster_note_ack(app, done.to, rtt);
+    redraw_mark(app, REDRAW_PAGE(PAGE_STATS));
+}
+
+void ack_expire(ZeroMeshApp* app) {
+    uint32_t now = furi_get_tick();
+    for(uint8_t i = 0; i < ACK_PENDING_MAX; i++) {
+        PendingAck* p = &app->ack_pending[i];
+        if(p->packet_id == 0 || now - p->sent_tick < ACK_TIMEOUT_MS) continue;
+
+        furi_mutex_acquire(app->lock, FuriWaitForever);
+        if(p->packet_id == 0 || now - p->sent_tick < ACK_TIMEOUT_MS) {
+            furi_mutex_release(app->lock);
+            continue;
+        }
+        uint32_t seq = p->seq;
+        memset(p, 0, sizeof(*p));
+        app->acks_expired++;
+        furi_mutex_release(app->lock);
+
+        history_set_ack(app, seq, MsgAckFailed);
+        redraw_mark(app, REDRAW_PAGE(PAGE_STATS));
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "zeromesh_serial.h"
+
+void ack_track(ZeroMeshApp* app, uint32_t packet_id, uint32_t to, uint32_t seq);
+void ack_resolve(ZeroMeshApp* app, uint32_t request_id, uint32_t from, uint32_t error);
+void ack_expire(ZeroMeshApp* app);
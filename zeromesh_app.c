@@ -0,0 +1,111 @@
+#include "zeromesh_app.h"
+#include "zeromesh_uart.h"
+#include "zeromesh_protocol.h"
+#include "zeromesh_settings.h"
+#include "zeromesh_channel.h"
+#include "zeromesh_notify.h"
+#include "zeromesh_store.h"
+#include "zeromesh_history.h"
+#include "zeromesh_redraw.h"
+#include "zeromesh_roster.h"
+#include "zeromesh_tx.h"
+#include "zeromesh_ack.h"
+#include "zeromesh_capture.h"
+#include "zeromesh_dedup.h"
+#include "zeromesh_events.h"
+#include "zeromesh_link.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+ZeroMeshApp* app_alloc(void) {
+    ZeroMeshApp* app = malloc(sizeof(ZeroMeshApp));
+    memset(app, 0, sizeof(ZeroMeshApp));
+    app->boot_tick = furi_get_tick();
+    app->link_down_tick = app->boot_tick;
+    app->link_probe_tick = app->boot_tick;
+
+    app->lock = furi_mutex_alloc(FuriMutexTypeNormal);
+
+    app->uart_id = FuriHalSerialIdUsart;
+    app->baud = 115200;
+
+    app->ui_mode = PAGE_MESSAGES;
+
+    app->notify_vibro = true;
+    app->notify_led = true;
+    app->notify_ringtone = RingtoneShort;
+
+    app->scroll_speed = 5;
+    app->scroll_framerate = 5;
+    app->lmh_mode = LMH_Scroll;
+
+    channel_init(app);
+    roster_init(app);
+    dedup_init(app);
+    protocol_init(app);
+
+    settings_load(app);
+    store_open(app);
+
+    snprintf(app->status, sizeof(app->status), "Connecting...");
+
+    app->rx_stream = furi_stream_buffer_alloc(RX_STREAM_SIZE, 1);
+    redraw_init(app);
+    return app;
+}
+
+void app_start(ZeroMeshApp* app) {
+    notify_start(app);
+
+    uart_open(app);
+    tx_start(app);
+
+    app->stop_thread = false;
+    app->rx_thread = furi_thread_alloc_ex("mt_rx", RX_THREAD_STACK_SIZE, rx_thread_fn, app);
+    furi_thread_start(app->rx_thread);
+}
+
+void app_tick(ZeroMeshApp* app) {
+    store_flush(app, false);
+    rx_events_drain(app);
+    history_page_sync(app);
+    ack_expire(app);
+    capture_sync(app);
+    link_sync(app);
+    redraw_wait(app);
+}
+
+void app_stop(ZeroMeshApp* app) {
+    app->stop_thread = true;
+
+    settings_save(app);
+
+    furi_thread_join(app->rx_thread);
+    furi_thread_free(app->rx_thread);
+    app->rx_thread = NULL;
+    rx_events_drain(app);
+
+    tx_stop(app);
+    capture_free(app);
+
+    uart_close(app);
+
+    store_flush(app, true);
+
+    notify_stop(app);
+}
+
+void app_free(ZeroMeshApp* app) {
+    redraw_free(app);
+
+    furi_stream_buffer_free(app->rx_stream);
+
+    roster_free(app);
+    dedup_free(app);
+
+    furi_mutex_free(app->lock);
+
+    free(app);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "zeromesh_serial.h"
+
+ZeroMeshApp* app_alloc(void);
+void app_start(ZeroMeshApp* app);
+void app_tick(ZeroMeshApp* app);
+void app_stop(ZeroMeshApp* app);
+void app_free(ZeroMeshApp* app);
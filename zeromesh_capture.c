@@ -0,0 +1,232 @@
+#include "zeromesh_capture.h"
+#include "zeromesh_history.h"
+#include "zeromesh_redraw.h"
+
+#include <storage/storage.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TAG "zeromesh_serial"
+
+static const uint8_t replay_speeds[] = {0, 1, 2, 5, 10, REPLAY_SPEED_MAX};
+#define REPLAY_SPEED_COUNT (sizeof(replay_speeds) / sizeof(replay_speeds[0]))
+
+const char* replay_speed_name(uint8_t speed) {
+    static char buf[8];
+    if(speed == 0) return "OFF";
+    if(speed == REPLAY_SPEED_MAX) return "Max";
+    snprintf(buf, sizeof(buf), "%ux", speed);
+    return buf;
+}
+
+uint8_t replay_speed_step(uint8_t speed, int direction) {
+    uint8_t idx = 0;
+    while(idx < REPLAY_SPEED_COUNT - 1 && replay_speeds[idx] != speed) idx++;
+    if(direction > 0) {
+        idx = (idx + 1) % REPLAY_SPEED_COUNT;
+    } else {
+        idx = (idx == 0) ? (uint8_t)(REPLAY_SPEED_COUNT - 1) : (uint8_t)(idx - 1);
+    }
+    return replay_speeds[idx];
+}
+
+void capture_tee(ZeroMeshApp* app, const uint8_t* data, size_t len) {
+    if(!app->capture_active || app->replay_active) return;
+
+    CaptureRecord rec = {.ms = furi_get_tick() - app->capture_start_tick, .len = (uint16_t)len};
+    if(furi_stream_buffer_spaces_available(app->capture_stream) < sizeof(rec) + len) {
+        app->capture_dropped += len;
+        return;
+    }
+    furi_stream_buffer_send(app->capture_stream, &rec, sizeof(rec), 0);
+    furi_stream_buffer_send(app->capture_stream, data, len, 0);
+}
+
+static void capture_flush(ZeroMeshApp* app, bool force) {
+    if(!app->capture_stream) return;
+    size_t pending = furi_stream_buffer_bytes_available(app->capture_stream);
+    if(pending == 0) return;
+    if(!force && pending < CAPTURE_BATCH && furi_get_tick() - app->capture_flush_tick < CAPTURE_FLUSH_MS) return;
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool ok = storage_file_open(file, app->capture_path, FSAM_WRITE, FSOM_OPEN_APPEND);
+
+    uint8_t chunk[256];
+    size_t n;
+    while((n = furi_stream_buffer_receive(app->capture_stream, chunk, sizeof(chunk), 0)) > 0) {
+        if(ok && storage_file_write(file, chunk, n) == n) {
+            app->capture_bytes += n;
+        } else {
+            app->capture_dropped += n;
+        }
+    }
+
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    app->capture_flush_tick = furi_get_tick();
+    redraw_mark(app, REDRAW_PAGE(PAGE_STATS));
+}
+
+static void capture_start(ZeroMeshApp* app) {
+    if(!app->capture_stream) app->capture_stream = furi_stream_buffer_alloc(CAPTURE_STREAM_SIZE, 1);
+    furi_stream_buffer_reset(app->capture_stream);
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    storage_common_mkdir(storage, "/ext/zeromesh");
+    storage_common_mkdir(storage, CAPTURE_DIR);
+    snprintf(
+        app->capture_path,
+        sizeof(app->capture_path),
+        CAPTURE_DIR "/%08lX.bin",
+        (unsigned long)furi_hal_rtc_get_timestamp());
+
+    File* file = storage_file_alloc(storage);
+    CaptureHeader hdr = {.magic = CAPTURE_MAGIC, .baud = app->baud};
+    bool ok = storage_file_open(file, app->capture_path, FSAM_WRITE, FSOM_CREATE_ALWAYS) &&
+              storage_file_write(file, &hdr, sizeof(hdr)) == sizeof(hdr);
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+
+    if(!ok) {
+        app->capture_want = false;
+        log_line(app, "Capture: open failed");
+        return;
+    }
+
+    app->capture_bytes = 0;
+    app->capture_dropped = 0;
+    app->capture_start_tick = furi_get_tick();
+    app->capture_flush_tick = app->capture_start_tick;
+    app->capture_active = true;
+    log_line(app, "Capture: %s", app->capture_path + sizeof(CAPTURE_DIR));
+}
+
+static void capture_stop(ZeroMeshApp* app) {
+    app->capture_active = false;
+    capture_flush(app, true);
+    log_line(app, "Capture: %lu B saved", (unsigned long)app->capture_bytes);
+}
+
+static bool replay_latest(char* path, size_t size) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* dir = storage_file_alloc(storage);
+    char best[16] = "";
+
+    if(storage_dir_open(dir, CAPTURE_DIR)) {
+        FileInfo info;
+        char name[64];
+        while(storage_dir_read(dir, &info, name, sizeof(name))) {
+            if(file_info_is_dir(&info)) continue;
+            size_t len = strlen(name);
+            if(len >= sizeof(best) || len <= 4 || strcmp(name + len - 4, ".bin") != 0) continue;
+            if(strcmp(name, best) > 0) memcpy(best, name, len + 1);
+        }
+    }
+    storage_dir_close(dir);
+
+    storage_file_free(dir);
+    furi_record_close(RECORD_STORAGE);
+
+    if(best[0] == '\0') return false;
+    snprintf(path, size, CAPTURE_DIR "/%s", best);
+    return true;
+}
+
+static bool replay_wait(ZeroMeshApp* app, uint32_t start, uint32_t ms) {
+    while(!app->replay_stop) {
+        uint8_t speed = app->replay_speed;
+        if(speed == REPLAY_SPEED_MAX || speed == 0) return true;
+        int32_t left = (int32_t)(start + ms / speed - furi_get_tick());
+        if(left <= 0) return true;
+        furi_delay_ms(left > 100 ? 100 : (uint32_t)left);
+    }
+    return false;
+}
+
+static int32_t replay_thread_fn(void* ctx) {
+    ZeroMeshApp* app = (ZeroMeshApp*)ctx;
+    char path[sizeof(app->capture_path)];
+    uint8_t buf[RX_SPAN_SIZE];
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    CaptureHeader hdr;
+
+    if(replay_latest(path, sizeof(path)) && storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING) &&
+       storage_file_read(file, &hdr, sizeof(hdr)) == sizeof(hdr) && hdr.magic == CAPTURE_MAGIC) {
+        log_line(app, "Replay: %s", path + sizeof(CAPTURE_DIR));
+        uint32_t start = furi_get_tick();
+        CaptureRecord rec;
+        while(!app->replay_stop && storage_file_read(file, &rec, sizeof(rec)) == sizeof(rec)) {
+            if(rec.len > sizeof(buf) || storage_file_read(file, buf, rec.len) != rec.len) break;
+            if(!replay_wait(app, start, rec.ms)) break;
+
+            size_t off = 0;
+            while(off < rec.len && !app->replay_stop) {
+                off += furi_stream_buffer_send(app->rx_stream, buf + off, rec.len - off, 100);
+            }
+            app->replay_bytes += off;
+        }
+        log_line(app, "Replay: %lu B done", (unsigned long)app->replay_bytes);
+    } else {
+        log_line(app, "Replay: no capture");
+    }
+
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+
+    app->replay_done = true;
+    redraw_wake(app);
+    return 0;
+}
+
+static void replay_stop(ZeroMeshApp* app) {
+    if(!app->replay_thread) return;
+    app->replay_stop = true;
+    furi_thread_join(app->replay_thread);
+    furi_thread_free(app->replay_thread);
+    app->replay_thread = NULL;
+    app->replay_active = false;
+    redraw_mark(app, REDRAW_ALL);
+}
+
+static void replay_start(ZeroMeshApp* app) {
+    app->replay_stop = false;
+    app->replay_done = false;
+    app->replay_bytes = 0;
+    app->replay_active = true;
+    app->replay_thread = furi_thread_alloc_ex("mt_replay", 2048, replay_thread_fn, app);
+    furi_thread_start(app->replay_thread);
+}
+
+void capture_sync(ZeroMeshApp* app) {
+    if(app->capture_want != app->capture_active) {
+        if(app->capture_want) {
+            capture_start(app);
+        } else {
+            capture_stop(app);
+        }
+    } else if(app->capture_active) {
+        capture_flush(app, false);
+    }
+
+    if(app->replay_thread && (app->replay_done || app->replay_speed == 0)) {
+        replay_stop(app);
+        app->replay_speed = 0;
+    } else if(!app->replay_thread && app->replay_speed != 0) {
+        replay_start(app);
+    }
+}
+
+void capture_free(ZeroMeshApp* app) {
+    replay_stop(app);
+    if(app->capture_active) capture_stop(app);
+    if(app->capture_stream) {
+        furi_stream_buffer_free(app->capture_stream);
+        app->capture_stream = NULL;
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "zeromesh_serial.h"
+
+/* File layout: CaptureHeader, then a CaptureRecord before each chunk of raw UART bytes */
+#define CAPTURE_MAGIC 0x50434D5AUL
+
+typedef struct {
+    uint32_t magic;
+    uint32_t baud;
+} CaptureHeader;
+
+typedef struct {
+    uint32_t ms;
+    uint16_t len;
+    uint16_t reserved;
+} CaptureRecord;
+
+void capture_tee(ZeroMeshApp* app, const uint8_t* data, size_t len);
+void capture_sync(ZeroMeshApp* app);
+void capture_free(ZeroMeshApp* app);
+const char* replay_speed_name(uint8_t speed);
+uint8_t replay_speed_step(uint8_t speed, int direction);
@@ -22,7 +22,9 @@ void channel_init(ZeroMeshApp* app) {
 void channel_next(ZeroMeshApp* app) {
     if(!app) return;
     
+    furi_mutex_acquire(app->lock, FuriWaitForever);
     app->current_channel = (app->current_channel + 1) % app->num_channels;
+    furi_mutex_release(app->lock);
     
     char status_msg[64];
     snprintf(status_msg, sizeof(status_msg), "Channel: %s", channel_names[app->current_channel]);
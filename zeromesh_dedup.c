@@ -0,0 +1,68 @@
+#include "zeromesh_dedup.h"
+#include "zeromesh_events.h"
+
+static uint32_t dedup_bucket(uint32_t from, uint32_t id) {
+    return ((from * 0x9E3779B1u) ^ id) * 0x9E3779B1u >> (32 - DEDUP_BITS);
+}
+
+static bool dedup_fresh(const DedupEntry* e, uint32_t now) {
+    return e->id != 0 && now - e->tick < DEDUP_WINDOW_MS;
+}
+
+static bool dedup_lookup_insert(ZeroMeshApp* app, uint32_t from, uint32_t id, uint32_t now) {
+    uint32_t base = dedup_bucket(from, id);
+    DedupEntry* victim = NULL;
+
+    for(uint8_t i = 0; i < DEDUP_PROBE; i++) {
+        DedupEntry* e = &app->dedup[(base + i) & (DEDUP_SLOTS - 1)];
+        if(!dedup_fresh(e, now)) {
+            if(!victim || dedup_fresh(victim, now)) victim = e;
+            continue;
+        }
+        if(e->from == from && e->id == id) return true;
+        if(!victim || (dedup_fresh(victim, now) && e->tick - victim->tick > 0x80000000UL)) victim = e;
+    }
+
+    if(dedup_fresh(victim, now)) app->dedup_evictions++;
+    victim->from = from;
+    victim->id = id;
+    victim->tick = now;
+    return false;
+}
+
+void dedup_init(ZeroMeshApp* app) {
+    app->dedup_lock = furi_mutex_alloc(FuriMutexTypeNormal);
+}
+
+void dedup_free(ZeroMeshApp* app) {
+    furi_mutex_free(app->dedup_lock);
+    app->dedup_lock = NULL;
+}
+
+bool dedup_seen(ZeroMeshApp* app, uint32_t from, uint32_t id) {
+    if(id == 0) return false;
+
+    uint32_t start = DWT->CYCCNT;
+    furi_mutex_acquire(app->dedup_lock, FuriWaitForever);
+    rx_wait_account(app, start);
+    app->dedup_lookups++;
+    bool self = from != 0 && from == app->rx_my_node_num;
+    bool seen = dedup_lookup_insert(app, self ? DEDUP_FROM_SELF : from, id, furi_get_tick());
+    if(seen) {
+        if(self) {
+            app->dedup_echoes++;
+        } else {
+            app->dedup_dups++;
+        }
+    }
+    furi_mutex_release(app->dedup_lock);
+    return seen;
+}
+
+void dedup_note_tx(ZeroMeshApp* app, uint32_t id) {
+    if(id == 0) return;
+
+    furi_mutex_acquire(app->dedup_lock, FuriWaitForever);
+    dedup_lookup_insert(app, DEDUP_FROM_SELF, id, furi_get_tick());
+    furi_mutex_release(app->dedup_lock);
+}
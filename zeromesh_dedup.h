@@ -0,0 +1,8 @@
+#pragma once
+
+#include "zeromesh_serial.h"
+
+void dedup_init(ZeroMeshApp* app);
+void dedup_free(ZeroMeshApp* app);
+bool dedup_seen(ZeroMeshApp* app, uint32_t from, uint32_t id);
+void dedup_note_tx(ZeroMeshApp* app, uint32_t id);
@@ -0,0 +1,352 @@
+#include "zeromesh_events.h"
+#include "zeromesh_history.h"
+#include "zeromesh_roster.h"
+#include "zeromesh_notify.h"
+#include "zeromesh_ack.h"
+#include "zeromesh_redraw.h"
+#include "zeromesh_link.h"
+#include "zeromesh_ports.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+void rx_wait_account(ZeroMeshApp* app, uint32_t start_cycles) {
+    uint32_t us = (DWT->CYCCNT - start_cycles) / furi_hal_cortex_instructions_per_microsecond();
+    app->rx_wait_us += us;
+    if(us > app->rx_wait_max_us) app->rx_wait_max_us = us;
+}
+
+static bool rx_event_space(ZeroMeshApp* app, uint32_t limit) {
+    uint32_t used = app->rx_event_head - __atomic_load_n(&app->rx_event_tail, __ATOMIC_ACQUIRE);
+    return used < limit;
+}
+
+/* Blocks the RX thread until the main loop frees a slot or RX_EVENT_WAIT_MS
+ * runs out. UART bytes keep queueing in rx_stream meanwhile. */
+static void rx_event_wait(ZeroMeshApp* app, uint32_t limit) {
+    uint32_t start = DWT->CYCCNT;
+    uint32_t begin = furi_get_tick();
+    app->rx_event_waits++;
+    redraw_wake(app);
+    while(!app->stop_thread) {
+        furi_thread_flags_clear(RX_FLAG_EVENT_SPACE);
+        __atomic_store_n(&app->rx_event_waiting, true, __ATOMIC_RELEASE);
+        uint32_t waited = furi_get_tick() - begin;
+        if(rx_event_space(app, limit) || waited >= RX_EVENT_WAIT_MS) break;
+        furi_thread_flags_wait(RX_FLAG_EVENT_SPACE, FuriFlagWaitAny, RX_EVENT_WAIT_MS - waited);
+    }
+    __atomic_store_n(&app->rx_event_waiting, false, __ATOMIC_RELEASE);
+    rx_wait_account(app, start);
+}
+
+static RxEvent* rx_event_slot(ZeroMeshApp* app) {
+    RxEvent* ev = &app->rx_events[app->rx_event_head % RX_EVENT_RING];
+    ev->port = app->rx_port_current;
+    return ev;
+}
+
+static RxEvent* rx_event_claim(ZeroMeshApp* app, bool critical) {
+    uint32_t limit = critical ? RX_EVENT_RING : RX_EVENT_RING - RX_EVENT_RESERVE;
+    if(!rx_event_space(app, limit)) {
+        if(critical) rx_event_wait(app, limit);
+        if(!rx_event_space(app, limit)) {
+            if(critical) {
+                app->rx_event_lost++;
+            } else {
+                app->rx_event_dropped++;
+            }
+            redraw_wake(app);
+            return NULL;
+        }
+    }
+    return rx_event_slot(app);
+}
+
+static void rx_event_publish(ZeroMeshApp* app) {
+    __atomic_store_n(&app->rx_event_head, app->rx_event_head + 1, __ATOMIC_RELEASE);
+    redraw_wake(app);
+}
+
+void rx_post_log(ZeroMeshApp* app, const char* fmt, ...) {
+    RxEvent* ev = rx_event_claim(app, false);
+    if(!ev) return;
+    ev->type = RxEventLog;
+    ev->port = PORT_SLOT_NONE;
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(ev->text, sizeof(ev->text), fmt, args);
+    va_end(args);
+    rx_event_publish(app);
+}
+
+void rx_post_status(ZeroMeshApp* app, const char* text) {
+    RxEvent* ev = rx_event_claim(app, false);
+    if(!ev) return;
+    ev->type = RxEventStatus;
+    ev->port = PORT_SLOT_NONE;
+    snprintf(ev->text, sizeof(ev->text), "%s", text);
+    rx_event_publish(app);
+}
+
+void rx_post_message(ZeroMeshApp* app, const PacketView* p) {
+    RxEvent* ev = rx_event_claim(app, true);
+    if(!ev) return;
+    ev->type = RxEventMessage;
+    size_t len = p->payload_len;
+    if(len >= sizeof(ev->msg.text)) len = sizeof(ev->msg.text) - 1;
+    memcpy(ev->msg.text, p->payload, len);
+    ev->msg.text[len] = '\0';
+    ev->msg.from = p->from;
+    ev->msg.to = p->to;
+    ev->msg.channel = p->channel;
+    rx_event_publish(app);
+}
+
+static RxMerge* rx_merge_slot(ZeroMeshApp* app, uint32_t node_id) {
+    for(uint8_t i = 0; i < app->rx_merge_count; i++) {
+        if(app->rx_merge[i].node_id == node_id) return &app->rx_merge[i];
+    }
+    if(app->rx_merge_count == RX_MERGE_SLOTS) return NULL;
+    RxMerge* m = &app->rx_merge[app->rx_merge_count++];
+    memset(m, 0, sizeof(*m));
+    m->node_id = node_id;
+    return m;
+}
+
+/* Mergeable updates never count as dropped here: a miss parks them in rx_merge */
+static bool rx_emit_node(ZeroMeshApp* app, uint32_t node_id, uint32_t to, uint32_t id, int8_t snr, int16_t rssi) {
+    if(!rx_event_space(app, RX_EVENT_RING - RX_EVENT_RESERVE)) return false;
+    RxEvent* ev = rx_event_slot(app);
+    ev->type = RxEventNode;
+    ev->node.node_id = node_id;
+    ev->node.to = to;
+    ev->node.id = id;
+    ev->node.snr = snr;
+    ev->node.rssi = rssi;
+    rx_event_publish(app);
+    return true;
+}
+
+static bool rx_emit_telemetry(ZeroMeshApp* app, uint32_t node_id, uint8_t battery_level, float voltage) {
+    if(!rx_event_space(app, RX_EVENT_RING - RX_EVENT_RESERVE)) return false;
+    RxEvent* ev = rx_event_slot(app);
+    ev->type = RxEventTelemetry;
+    ev->telemetry.node_id = node_id;
+    ev->telemetry.battery_level = battery_level;
+    ev->telemetry.voltage = voltage;
+    rx_event_publish(app);
+    return true;
+}
+
+/* Signal and telemetry updates that did not fit in the ring wait here,
+ * newest value per node, and go out once the main loop catches up */
+void rx_merge_flush(ZeroMeshApp* app) {
+    uint8_t done = 0;
+    while(done < app->rx_merge_count) {
+        RxMerge* m = &app->rx_merge[done];
+        if(m->flags & RX_MERGE_NODE) {
+            if(!rx_emit_node(app, m->node_id, m->to, m->id, m->snr, m->rssi)) break;
+            m->flags &= ~RX_MERGE_NODE;
+        }
+        if(m->flags & RX_MERGE_TELEMETRY) {
+            if(!rx_emit_telemetry(app, m->node_id, m->battery_level, m->voltage)) break;
+            m->flags &= ~RX_MERGE_TELEMETRY;
+        }
+        done++;
+    }
+    if(done == 0) return;
+    app->rx_merge_count -= done;
+    memmove(app->rx_merge, app->rx_merge + done, app->rx_merge_count * sizeof(RxMerge));
+}
+
+static bool rx_merge_ready(ZeroMeshApp* app) {
+    if(app->rx_merge_count) rx_merge_flush(app);
+    return app->rx_merge_count == 0;
+}
+
+void rx_post_node(ZeroMeshApp* app, uint32_t node_id, uint32_t to, uint32_t id, int8_t snr, int16_t rssi) {
+    if(rx_merge_ready(app) && rx_emit_node(app, node_id, to, id, snr, rssi)) return;
+    RxMerge* m = rx_merge_slot(app, node_id);
+    if(!m) {
+        app->rx_event_dropped++;
+        return;
+    }
+    if(m->flags & RX_MERGE_NODE) app->rx_event_merged++;
+    m->to = to;
+    m->id = id;
+    m->snr = snr;
+    m->rssi = rssi;
+    m->flags |= RX_MERGE_NODE;
+}
+
+void rx_post_nodeinfo(ZeroMeshApp* app, RxEventType type, const NodeInfoView* info) {
+    RxEvent* ev = rx_event_claim(app, true);
+    if(!ev) return;
+    ev->type = type;
+    ev->info.view = *info;
+    ev->info.view.short_name_len = info->short_name_len > NAME_SHORT_MAX ? NAME_SHORT_MAX : info->short_name_len;
+    ev->info.view.long_name_len = info->long_name_len > NAME_LONG_MAX ? NAME_LONG_MAX : info->long_name_len;
+    memcpy(ev->info.short_name, info->short_name, ev->info.view.short_name_len);
+    memcpy(ev->info.long_name, info->long_name, ev->info.view.long_name_len);
+    rx_event_publish(app);
+}
+
+void rx_post_my_info(ZeroMeshApp* app, uint32_t node_id) {
+    RxEvent* ev = rx_event_claim(app, true);
+    if(!ev) return;
+    ev->type = RxEventMyInfo;
+    ev->node.node_id = node_id;
+    rx_event_publish(app);
+}
+
+void rx_post_telemetry(ZeroMeshApp* app, uint32_t node_id, uint8_t battery_level, float voltage) {
+    if(rx_merge_ready(app) && rx_emit_telemetry(app, node_id, battery_level, voltage)) return;
+    RxMerge* m = rx_merge_slot(app, node_id);
+    if(!m) {
+        app->rx_event_dropped++;
+        return;
+    }
+    if(m->flags & RX_MERGE_TELEMETRY) app->rx_event_merged++;
+    m->battery_level = battery_level;
+    m->voltage = voltage;
+    m->flags |= RX_MERGE_TELEMETRY;
+}
+
+void rx_post_ack(ZeroMeshApp* app, uint32_t request_id, uint32_t from, uint32_t error) {
+    RxEvent* ev = rx_event_claim(app, true);
+    if(!ev) return;
+    ev->type = RxEventAck;
+    ev->ack.request_id = request_id;
+    ev->ack.from = from;
+    ev->ack.error = error;
+    rx_event_publish(app);
+}
+
+void rx_post_rebooted(ZeroMeshApp* app) {
+    RxEvent* ev = rx_event_claim(app, true);
+    if(!ev) return;
+    ev->type = RxEventRebooted;
+    rx_event_publish(app);
+}
+
+void rx_post_config_done(ZeroMeshApp* app, uint32_t nonce, uint16_t nodes, uint8_t channels) {
+    RxEvent* ev = rx_event_claim(app, true);
+    if(!ev) return;
+    ev->type = RxEventConfigDone;
+    ev->config.nonce = nonce;
+    ev->config.tick = furi_get_tick();
+    ev->config.nodes = nodes;
+    ev->config.channels = channels;
+    rx_event_publish(app);
+}
+
+static void rx_config_done(ZeroMeshApp* app, const RxEvent* ev) {
+    if(ev->config.nonce != app->config_nonce || app->config_complete) return;
+
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+    app->config_done_ms = ev->config.tick - app->boot_tick;
+    app->config_nodes = ev->config.nodes;
+    app->config_complete = true;
+    if(ev->config.channels > 0) {
+        app->num_channels = ev->config.channels;
+        if(app->current_channel >= app->num_channels) app->current_channel = 0;
+    }
+    furi_mutex_release(app->lock);
+
+    log_line(app, "Config done: %u nodes %lums", app->config_nodes, (unsigned long)app->config_done_ms);
+    redraw_mark(app, REDRAW_ALL);
+}
+
+static void rx_signal_apply(ZeroMeshApp* app, const RxEvent* ev) {
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+    app->last_rx_from = ev->node.node_id;
+    app->last_rx_to = ev->node.to;
+    app->last_rx_id = ev->node.id;
+    if(ev->node.rssi != 0) {
+        app->last_rx_rssi = ev->node.rssi;
+        app->has_rx_signal_data = true;
+    }
+    if(ev->node.snr != 0) {
+        app->last_rx_snr = ev->node.snr;
+        app->has_rx_signal_data = true;
+    }
+    redraw_mark(app, REDRAW_PAGE(PAGE_SIGNAL));
+    furi_mutex_release(app->lock);
+}
+
+static void rx_event_apply(ZeroMeshApp* app, RxEvent* ev) {
+    switch(ev->type) {
+    case RxEventLog:
+        log_line(app, "%s", ev->text);
+        break;
+    case RxEventStatus:
+        set_status(app, "%s", ev->text);
+        break;
+    case RxEventMessage:
+        history_add(app, ev->msg.text, ev->msg.from, ev->msg.to, ev->msg.channel, false);
+        log_line(app, "Msg: %s", ev->msg.text);
+        set_status(app, "New message");
+        notify_rx_message(app);
+        break;
+    case RxEventNode:
+        rx_signal_apply(app, ev);
+        roster_add_node(app, ev->node.node_id, ev->node.snr, ev->node.rssi);
+        break;
+    case RxEventNodeInfo:
+    case RxEventUser:
+        ev->info.view.short_name = ev->info.short_name;
+        ev->info.view.long_name = ev->info.long_name;
+        if(ev->type == RxEventNodeInfo) {
+            roster_ingest_node(app, &ev->info.view);
+        } else {
+            roster_set_user(app, &ev->info.view);
+        }
+        break;
+    case RxEventMyInfo:
+        roster_set_self(app, ev->node.node_id);
+        log_line(app, "My ID: %08lX", (unsigned long)ev->node.node_id);
+        set_status(app, "Ready");
+        break;
+    case RxEventConfigDone:
+        rx_config_done(app, ev);
+        break;
+    case RxEventTelemetry:
+        roster_update_telemetry(
+            app, ev->telemetry.node_id, ev->telemetry.battery_level, ev->telemetry.voltage);
+        break;
+    case RxEventAck:
+        ack_resolve(app, ev->ack.request_id, ev->ack.from, ev->ack.error);
+        break;
+    case RxEventRebooted:
+        link_resync(app);
+        break;
+    default:
+        break;
+    }
+}
+
+void rx_events_drain(ZeroMeshApp* app) {
+    uint32_t tail = app->rx_event_tail;
+    uint32_t head = __atomic_load_n(&app->rx_event_head, __ATOMIC_ACQUIRE);
+    if(tail == head) return;
+
+    while(tail != head) {
+        /* Release the slot before applying, so a RX thread waiting for room
+         * is not held up while apply contends with render_cb for app->lock */
+        RxEvent ev = app->rx_events[tail % RX_EVENT_RING];
+        tail++;
+        __atomic_store_n(&app->rx_event_tail, tail, __ATOMIC_RELEASE);
+        if(__atomic_load_n(&app->rx_event_waiting, __ATOMIC_ACQUIRE) && app->rx_thread) {
+            furi_thread_flags_set(furi_thread_get_id(app->rx_thread), RX_FLAG_EVENT_SPACE);
+        }
+
+        if(ev.port == PORT_SLOT_NONE) {
+            rx_event_apply(app, &ev);
+        } else {
+            uint32_t start = DWT->CYCCNT;
+            rx_event_apply(app, &ev);
+            port_account(app, ev.port, (DWT->CYCCNT - start) / furi_hal_cortex_instructions_per_microsecond());
+        }
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "zeromesh_serial.h"
+
+void rx_post_log(ZeroMeshApp* app, const char* fmt, ...);
+void rx_post_status(ZeroMeshApp* app, const char* text);
+void rx_post_message(ZeroMeshApp* app, const PacketView* p);
+void rx_post_node(ZeroMeshApp* app, uint32_t node_id, uint32_t to, uint32_t id, int8_t snr, int16_t rssi);
+void rx_post_nodeinfo(ZeroMeshApp* app, RxEventType type, const NodeInfoView* info);
+void rx_post_my_info(ZeroMeshApp* app, uint32_t node_id);
+void rx_post_config_done(ZeroMeshApp* app, uint32_t nonce, uint16_t nodes, uint8_t channels);
+void rx_post_telemetry(ZeroMeshApp* app, uint32_t node_id, uint8_t battery_level, float voltage);
+void rx_post_ack(ZeroMeshApp* app, uint32_t request_id, uint32_t from, uint32_t error);
+void rx_post_rebooted(ZeroMeshApp* app);
+void rx_merge_flush(ZeroMeshApp* app);
+void rx_events_drain(ZeroMeshApp* app);
+void rx_wait_account(ZeroMeshApp* app, uint32_t start_cycles);
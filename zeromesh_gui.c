@@ -8,12 +8,18 @@
 #include "zeromesh_uart.h"
 #include "zeromesh_protocol.h"
 #include "zeromesh_history.h"
+#include "zeromesh_layout.h"
+#include "zeromesh_redraw.h"
 #include "zeromesh_roster.h"
+#include "zeromesh_names.h"
 #include "zeromesh_channel.h"
 #include "zeromesh_settings.h"
+#include "zeromesh_ports.h"
+#include "zeromesh_capture.h"
+#include "zeromesh_link.h"
+#include "zeromesh_events.h"
 
-static const uint32_t baud_options[] = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600};
-#define BAUD_OPTIONS_COUNT (sizeof(baud_options) / sizeof(baud_options[0]))
+#include <stdarg.h>
 
 static const char* lmh_names[] = {
     "Scroll",
@@ -24,11 +30,18 @@ static void get_short_node_id(uint32_t node_id, char* buf, size_t buf_size) {
     snprintf(buf, buf_size, "!%04lx", (unsigned long)(node_id & 0xFFFF));
 }
 
-static uint8_t baud_to_index(uint32_t baud) {
-    for(uint8_t i = 0; i < BAUD_OPTIONS_COUNT; i++) {
-        if(baud_options[i] == baud) return i;
+void draw_ack_glyph(Canvas* canvas, int x, int y, uint8_t ack) {
+    if(ack == MsgAckPending) {
+        canvas_draw_dot(canvas, x, y + 4);
+        canvas_draw_dot(canvas, x + 2, y + 4);
+        canvas_draw_dot(canvas, x + 4, y + 4);
+    } else if(ack == MsgAckDelivered) {
+        canvas_draw_line(canvas, x, y + 2, x + 2, y + 4);
+        canvas_draw_line(canvas, x + 2, y + 4, x + 4, y);
+    } else if(ack == MsgAckFailed) {
+        canvas_draw_line(canvas, x, y, x + 4, y + 4);
+        canvas_draw_line(canvas, x, y + 4, x + 4, y);
     }
-    return 4;
 }
 
 static void draw_footer(Canvas* canvas, const char* left_hint, const char* right_hint) {
@@ -79,107 +92,6 @@ static void draw_str_ellipsis(Canvas* canvas, int x, int y, int max_w, const cha
     canvas_draw_str(canvas, x, y, "...");
 }
 
-static int calculate_wrapped_lines(Canvas* canvas, const char* text, int max_w) {
-    if(!text || !text[0]) return 1;
-    
-    char line_buf[64];
-    size_t text_len = strlen(text);
-    size_t pos = 0;
-    int lines = 0;
-    
-    while(pos < text_len) {
-        size_t line_len = 0;
-        size_t last_space = 0;
-        
-        while(pos + line_len < text_len) {
-            line_buf[line_len] = text[pos + line_len];
-            line_buf[line_len + 1] = '\0';
-            
-            if(text[pos + line_len] == ' ') {
-                last_space = line_len;
-            }
-            
-            if(canvas_string_width(canvas, line_buf) > max_w) {
-                if(last_space > 0) {
-                    line_len = last_space;
-                } else {
-                    if(line_len > 0) line_len--;
-                }
-                break;
-            }
-            
-            line_len++;
-            if(line_len >= sizeof(line_buf) - 1) break;
-        }
-        
-        if(line_len == 0 && pos < text_len) {
-            line_len = 1;
-        }
-        
-        pos += line_len;
-        while(pos < text_len && text[pos] == ' ') pos++;
-        lines++;
-    }
-    
-    return lines > 0 ? lines : 1;
-}
-
-static void draw_wrapped_text_in_bubble(
-    Canvas* canvas,
-    int x,
-    int y,
-    int max_w,
-    const char* text,
-    Color text_col) {
-    if(!text || !text[0]) return;
-    
-    canvas_set_color(canvas, text_col);
-    
-    char line_buf[64];
-    size_t text_len = strlen(text);
-    size_t pos = 0;
-    int current_y = y;
-    
-    while(pos < text_len) {
-        size_t line_len = 0;
-        size_t last_space = 0;
-        
-        while(pos + line_len < text_len) {
-            line_buf[line_len] = text[pos + line_len];
-            line_buf[line_len + 1] = '\0';
-            
-            if(text[pos + line_len] == ' ') {
-                last_space = line_len;
-            }
-            
-            if(canvas_string_width(canvas, line_buf) > max_w) {
-                if(last_space > 0) {
-                    line_len = last_space;
-                    line_buf[line_len] = '\0';
-                } else {
-                    if(line_len > 0) line_len--;
-                    line_buf[line_len] = '\0';
-                }
-                break;
-            }
-            
-            line_len++;
-            if(line_len >= sizeof(line_buf) - 1) break;
-        }
-        
-        if(line_len == 0 && pos < text_len) {
-            line_buf[0] = text[pos];
-            line_buf[1] = '\0';
-            line_len = 1;
-        }
-        
-        canvas_draw_str(canvas, x, current_y, line_buf);
-        pos += line_len;
-        while(pos < text_len && text[pos] == ' ') pos++;
-        current_y += 9;
-    }
-}
-
 void draw_header(Canvas* canvas, ZeroMeshApp* app, const char* title) {
     canvas_set_color(canvas, ColorBlack);
     canvas_draw_box(canvas, 0, 0, 128, 14);
@@ -192,7 +104,7 @@ void draw_header(Canvas* canvas, ZeroMeshApp* app, const char* title) {
     int title_max = (dot_x - 6) - title_x;
     draw_str_ellipsis(canvas, title_x, 11, title_max, title);
 
-    if(app->serial && app->rx_bytes > 0) {
+    if(app->serial && app->link_up) {
         canvas_draw_disc(canvas, 120, 7, 3);
     } else {
         canvas_draw_circle(canvas, 120, 7, 3);
@@ -209,28 +121,87 @@ void draw_header(Canvas* canvas, ZeroMeshApp* app, const char* title) {
     canvas_set_color(canvas, ColorBlack);
 }
 
-static void draw_message_bubble(Canvas* canvas, int x, int y, int max_w, const char* text, bool is_tx, uint32_t from_id, uint32_t phase_seed, ZeroMeshApp* app) {
+void message_window(
+    Canvas* canvas,
+    ZeroMeshApp* app,
+    uint32_t conv,
+    uint16_t* offset,
+    int msg_h,
+    int wrap_pad,
+    MessageWindow* win) {
+    win->count = history_conv_count(app, conv, &win->more);
+    history_conv_mark_read(app, conv);
+
+    if(!win->more && *offset >= win->count) {
+        *offset = win->count > 0 ? win->count - 1 : 0;
+    }
+
+    int available_height = 46;
+    while(true) {
+        uint8_t avail = history_conv_collect(app, conv, *offset, win->msgs, MSG_HISTORY);
+        int y = 18;
+        bool full = false;
+        win->visible = 0;
+
+        for(uint8_t i = 0; i < avail; i++) {
+            const Message* msg = win->msgs[i];
+            int h = msg_h;
+            if(app->lmh_mode == LMH_Wrap) {
+                int inner_w = 116;
+                const TextLayout* layout = layout_get(canvas, app, msg, FontSecondary, inner_w);
+                if(layout->text_w > inner_w) {
+                    h = wrap_pad + (layout->lines * 9) + 2;
+                }
+            }
+
+            if(y + h > available_height + 18 && win->visible > 0) {
+                full = true;
+                break;
+            }
+            win->heights[win->visible++] = h;
+            y += h;
+        }
+
+        if(full || win->more || *offset == 0 || win->visible == 0) break;
+        (*offset)--;
+    }
+
+    history_page_request(app, conv, *offset + win->visible);
+}
+
+static void draw_message_bubble(Canvas* canvas, int x, int y, int max_w, const Message* msg, ZeroMeshApp* app) {
     canvas_set_font(canvas, FontSecondary);
 
-    char sender[10];
-    get_short_node_id(from_id, sender, sizeof(sender));
+    bool is_tx = msg->is_tx;
+    uint32_t phase_seed = msg->seq * 977u;
+
+    char fallback[10];
+    const char* sender = fallback;
+    int sender_w;
+    uint16_t name_idx = names_lookup(app, msg->from);
+    if(name_idx != ROSTER_SLOT_NONE) {
+        sender = names_label(app, name_idx, NameShort);
+        sender_w = names_width(canvas, app, name_idx, NameShort, FontSecondary);
+    } else {
+        get_short_node_id(msg->from, fallback, sizeof(fallback));
+        sender_w = canvas_string_width(canvas, fallback);
+    }
     
-    int sender_w = canvas_string_width(canvas, sender);
     int name_y = y;
     int bubble_y = y + 10;
     
-    const char* s = text ? text : "";
-    uint16_t text_w = canvas_string_width(canvas, s);
-    
+    const char* s = msg->text;
     int pad = 4;
     int inner_w = max_w - (pad * 2);
+
+    const TextLayout* layout = layout_get(canvas, app, msg, FontSecondary, inner_w);
+    uint16_t text_w = layout->text_w;
     
     int bubble_h = 12;
     int bubble_w = text_w + (pad * 2);
     
     if(app->lmh_mode == LMH_Wrap && text_w > inner_w) {
-        int lines = calculate_wrapped_lines(canvas, s, inner_w);
-        bubble_h = 2 + (lines * 9) + 2;
+        bubble_h = 2 + (layout->lines * 9) + 2;
         bubble_w = max_w;
     } else if(bubble_w > max_w) {
         bubble_w = max_w;
@@ -265,7 +236,8 @@ static void draw_message_bubble(Canvas* canvas, int x, int y, int max_w, const c
         canvas_set_color(canvas, text_col);
         canvas_draw_str(canvas, inner_x, baseline, s);
     } else if(app->lmh_mode == LMH_Wrap) {
-        draw_wrapped_text_in_bubble(canvas, inner_x, baseline, inner_w, s, text_col);
+        canvas_set_color(canvas, text_col);
+        layout_draw_lines(canvas, layout, s, inner_x, baseline);
     } else {
         uint32_t t = furi_get_tick() + phase_seed;
         uint32_t speed_delay = 24 * (11 - app->scroll_speed);
@@ -277,6 +249,7 @@ static void draw_message_bubble(Canvas* canvas, int x, int y, int max_w, const c
         int32_t x1 = (int32_t)inner_x - (int32_t)off;
         int32_t x2 = x1 + (int32_t)cycle;
         
+        app->redraw_animating = true;
         canvas_set_color(canvas, text_col);
         canvas_draw_str(canvas, (int)x1, baseline, s);
         canvas_draw_str(canvas, (int)x2, baseline, s);
@@ -298,6 +271,7 @@ static void draw_message_bubble(Canvas* canvas, int x, int y, int max_w, const c
     }
     
     canvas_set_color(canvas, ColorBlack);
+    if(is_tx) draw_ack_glyph(canvas, x + max_w - 5, name_y + 3, msg->ack);
 }
 
 static void render_messages(Canvas* canvas, ZeroMeshApp* app) {
@@ -311,119 +285,263 @@ static void render_messages(Canvas* canvas, ZeroMeshApp* app) {
     canvas_set_font(canvas, FontSecondary);
     canvas_set_color(canvas, ColorBlack);
 
-    uint8_t broadcast_indices[MSG_HISTORY];
-    uint8_t broadcast_count = 0;
-
-    for(uint8_t i = 0; i < app->history.count; i++) {
-        uint8_t idx = (app->history.head + MSG_HISTORY - app->history.count + i) % MSG_HISTORY;
-        if(app->history.msgs[idx].to == 0xFFFFFFFF) {
-            broadcast_indices[broadcast_count++] = idx;
-        }
-    }
+    uint32_t conv = HISTORY_CONV_CHANNEL(app->current_channel);
+    MessageWindow win;
+    message_window(canvas, app, conv, &app->msg_scroll_offset, 16, 8, &win);
 
-    if(broadcast_count == 0) {
+    if(win.count == 0 && !win.more) {
         canvas_draw_str(canvas, 16, 34, "No mesh traffic yet");
         canvas_draw_str(canvas, 10, 46, "Press OK to broadcast");
         draw_footer(canvas, "", "");
         return;
     }
 
-    int available_height = 46;
-    int y = 18;
-    int visible_count = 0;
-    
-    for(int i = broadcast_count - 1; i >= 0; i--) {
-        uint8_t idx = broadcast_indices[i];
-        Message* msg = &app->history.msgs[idx];
-        
-        int msg_height = 16;
-        if(app->lmh_mode == LMH_Wrap) {
-            int text_w = canvas_string_width(canvas, msg->text);
-            int inner_w = 116;
-            if(text_w > inner_w) {
-                int lines = calculate_wrapped_lines(canvas, msg->text, inner_w);
-                msg_height = 8 + (lines * 9) + 2;
-            }
-        }
-        
-        if(y + msg_height <= available_height + 18) {
-            visible_count++;
-            y += msg_height;
-        } else {
-            break;
-        }
-    }
-    
-    if(visible_count == 0) visible_count = 1;
-    
-    if(broadcast_count <= visible_count) {
-        app->msg_scroll_offset = 0;
-    } else if(app->msg_scroll_offset > broadcast_count - visible_count) {
-        app->msg_scroll_offset = broadcast_count - visible_count;
+    if(win.visible == 0) {
+        canvas_draw_str(canvas, 40, 40, "Loading...");
     }
 
-    uint8_t start_idx = broadcast_count - visible_count - app->msg_scroll_offset;
-    if(start_idx > broadcast_count) start_idx = 0;
-
-    y = 18;
-    for(int i = 0; i < visible_count && (start_idx + i) < broadcast_count; i++) {
-        uint8_t history_idx = broadcast_indices[start_idx + i];
-        Message* msg = &app->history.msgs[history_idx];
-        
-        draw_message_bubble(canvas, 2, y, 124, msg->text, msg->is_tx, msg->from, (uint32_t)history_idx * 977u, app);
-        
-        if(app->lmh_mode == LMH_Wrap) {
-            int text_w = canvas_string_width(canvas, msg->text);
-            int inner_w = 116;
-            if(text_w > inner_w) {
-                int lines = calculate_wrapped_lines(canvas, msg->text, inner_w);
-                y += 8 + (lines * 9) + 2;
-            } else {
-                y += 16;
-            }
-        } else {
-            y += 16;
-        }
+    int y = 18;
+    for(int i = win.visible - 1; i >= 0; i--) {
+        const Message* msg = win.msgs[i];
+        draw_message_bubble(canvas, 2, y, 124, msg, app);
+        y += win.heights[i];
     }
 
     if(app->msg_scroll_offset > 0) {
         canvas_draw_str(canvas, 60, 62, "v");
     }
-    if(broadcast_count > visible_count && app->msg_scroll_offset < broadcast_count - visible_count) {
+    if(win.more || app->msg_scroll_offset + win.visible < win.count) {
         canvas_draw_str(canvas, 60, 17, "^");
     }
 
     draw_footer(canvas, "", "");
 }
 
+#define STATS_VISIBLE_ROWS 5
+
+typedef struct {
+    Canvas* canvas;
+    uint8_t row;
+    uint8_t first;
+} StatsCursor;
+
+static void stats_line(StatsCursor* c, const char* fmt, ...) {
+    if(c->row >= c->first && c->row < c->first + STATS_VISIBLE_ROWS) {
+        char buf[64];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        canvas_draw_str(c->canvas, 2, 24 + (c->row - c->first) * 10, buf);
+    }
+    c->row++;
+}
+
 static void render_stats(Canvas* canvas, ZeroMeshApp* app) {
     draw_header(canvas, app, "Statistics");
     canvas_set_font(canvas, FontSecondary);
 
-    char buf[64];
-    snprintf(
-        buf,
-        sizeof(buf),
+    StatsCursor c = {.canvas = canvas, .row = 0, .first = app->stats_scroll};
+
+    stats_line(
+        &c,
         "Port: %s @ %lu",
         (app->uart_id == FuriHalSerialIdUsart) ? "USART" : "LPUART",
         (unsigned long)app->baud);
-    canvas_draw_str(canvas, 2, 24, buf);
-
-    snprintf(buf, sizeof(buf), "RX: %lu bytes", (unsigned long)app->rx_bytes);
-    canvas_draw_str(canvas, 2, 34, buf);
-
-    snprintf(
-        buf,
-        sizeof(buf),
+    stats_line(
+        &c,
+        "Link: %lu B/s  err %u%%",
+        (unsigned long)app->link_bps,
+        app->link_err_pct);
+    stats_line(
+        &c,
+        "Link %s %lums  hb %lu",
+        app->link_up ? "up" : "down",
+        (unsigned long)app->link_reconnect_ms,
+        (unsigned long)app->link_heartbeats);
+    stats_line(
+        &c,
+        "Lost %lu  reboots %lu",
+        (unsigned long)app->link_losses,
+        (unsigned long)app->link_reboots);
+    stats_line(
+        &c,
+        "RX: %lu B / %lu drop",
+        (unsigned long)app->rx_bytes,
+        (unsigned long)(app->rx_overflow + app->rx_uart_overrun));
+    stats_line(
+        &c,
         "Frames: %lu OK / %lu bad",
         (unsigned long)app->rx_frames_ok,
-        (unsigned long)(app->rx_bad_magic + app->rx_bad_len + app->rx_decode_fail));
-    canvas_draw_str(canvas, 2, 44, buf);
-
-    snprintf(buf, sizeof(buf), "TX: %lu frames", (unsigned long)app->tx_frames);
-    canvas_draw_str(canvas, 2, 54, buf);
-
-    draw_footer(canvas, "", "");
+        (unsigned long)(app->framing.bad_magic + app->framing.bad_len + app->framing.rejected + app->rx_decode_fail));
+    stats_line(
+        &c,
+        "Reject: %lu pre %lu dec  resync %lu",
+        (unsigned long)app->framing.rejected,
+        (unsigned long)app->rx_decode_fail,
+        (unsigned long)app->framing.resyncs);
+    stats_line(
+        &c,
+        "TX: %lu  Q %u/%u  drop %lu",
+        (unsigned long)app->tx_frames,
+        app->tx_depth_max,
+        TX_QUEUE_SIZE,
+        (unsigned long)app->tx_drops);
+    stats_line(
+        &c,
+        "TX wire: %lu/%lums  retry %lu",
+        (unsigned long)app->tx_latency_ms,
+        (unsigned long)app->tx_latency_max_ms,
+        (unsigned long)(app->tx_retries + app->tx_failed));
+    stats_line(
+        &c,
+        "TX enc: %lu/%luus",
+        (unsigned long)app->tx_encode_us,
+        (unsigned long)app->tx_encode_max_us);
+    stats_line(
+        &c,
+        "ACK: %lu ok %lu fail %lu lost",
+        (unsigned long)app->acks_ok,
+        (unsigned long)app->acks_failed,
+        (unsigned long)app->acks_expired);
+    stats_line(
+        &c,
+        "RTT %lums %u/%u/%u/%u/%u/%u",
+        (unsigned long)app->ack_rtt_last_ms,
+        app->ack_hist[0],
+        app->ack_hist[1],
+        app->ack_hist[2],
+        app->ack_hist[3],
+        app->ack_hist[4],
+        app->ack_hist[5]);
+    stats_line(
+        &c,
+        "Dedup: %lu/%lu hit  %uB",
+        (unsigned long)(app->dedup_echoes + app->dedup_dups),
+        (unsigned long)app->dedup_lookups,
+        (unsigned)sizeof(app->dedup));
+    stats_line(
+        &c,
+        "Echo %lu  Dup %lu  Evict %lu",
+        (unsigned long)app->dedup_echoes,
+        (unsigned long)app->dedup_dups,
+        (unsigned long)app->dedup_evictions);
+    if(app->capture_active) {
+        stats_line(
+            &c,
+            "Capture: %lu B / %lu lost",
+            (unsigned long)app->capture_bytes,
+            (unsigned long)app->capture_dropped);
+    }
+    if(app->replay_active) {
+        stats_line(
+            &c,
+            "Replay %s: %lu B",
+            replay_speed_name(app->replay_speed),
+            (unsigned long)app->replay_bytes);
+    }
+    stats_line(
+        &c,
+        "RX wait: %luus max %luus",
+        (unsigned long)app->rx_wait_us,
+        (unsigned long)app->rx_wait_max_us);
+    stats_line(
+        &c,
+        "RX ev %lu drop %lu lost %lu",
+        (unsigned long)app->rx_event_head,
+        (unsigned long)app->rx_event_dropped,
+        (unsigned long)app->rx_event_lost);
+    stats_line(
+        &c,
+        "RX full waits %lu merged %lu",
+        (unsigned long)app->rx_event_waits,
+        (unsigned long)app->rx_event_merged);
+    stats_line(
+        &c,
+        "Stalls: %lu  HWM: %lu/%u",
+        (unsigned long)app->rx_stalls,
+        (unsigned long)app->rx_stream_hwm,
+        RX_STREAM_SIZE);
+    stats_line(
+        &c,
+        "Alerts: %lu / %lu merged",
+        (unsigned long)app->notify_alerts,
+        (unsigned long)app->notify_coalesced);
+    stats_line(
+        &c,
+        "RX stack peak: %lu/%u",
+        (unsigned long)(RX_THREAD_STACK_SIZE - app->rx_stack_free_min),
+        RX_THREAD_STACK_SIZE);
+    if(app->config_complete) {
+        stats_line(
+            &c,
+            "Config: %u nodes %lums",
+            app->config_nodes,
+            (unsigned long)app->config_done_ms);
+    } else if(app->config_nonce) {
+        stats_line(&c, "Config: syncing, %u nodes", app->rx_config_nodes);
+    }
+    stats_line(
+        &c,
+        "Nodes: %u/%u  %lu evict",
+        app->roster.count,
+        app->roster.capacity,
+        (unsigned long)app->roster.evictions);
+    stats_line(
+        &c,
+        "Names: %u/%uB  %lu gc",
+        app->names.pool_live,
+        app->names.pool_size,
+        (unsigned long)app->names.compactions);
+    stats_line(
+        &c,
+        "Store: %lu / %lu lost",
+        (unsigned long)app->store.flushed,
+        (unsigned long)app->store.dropped);
+    stats_line(
+        &c,
+        "Flush: %lu  Page: %lums",
+        (unsigned long)app->store.flush_batches,
+        (unsigned long)app->store.page_last_ms);
+    stats_line(
+        &c,
+        "Layout: %lu hit / %lu miss",
+        (unsigned long)app->layout_hits,
+        (unsigned long)app->layout_misses);
+    stats_line(
+        &c,
+        "Redraw/min: %lu idle %lu busy",
+        (unsigned long)app->redraws_idle_min,
+        (unsigned long)app->redraws_busy_min);
+
+    for(uint16_t slot = 0; slot < PORT_SLOT_COUNT; slot++) {
+        const PortStats* st = &app->port_stats[slot];
+        if(st->rx_count == 0) continue;
+        const char* name = port_name(slot);
+        char label[8];
+        if(name) {
+            snprintf(label, sizeof(label), "%s", name);
+        } else {
+            snprintf(label, sizeof(label), "P%u", slot);
+        }
+        stats_line(
+            &c,
+            "%s %lu %u/%u/%u/%u/%u/%u",
+            label,
+            (unsigned long)st->rx_count,
+            st->decode_hist[0],
+            st->decode_hist[1],
+            st->decode_hist[2],
+            st->decode_hist[3],
+            st->decode_hist[4],
+            st->decode_hist[5]);
+    }
+
+    if(c.row <= STATS_VISIBLE_ROWS) {
+        app->stats_scroll = 0;
+    } else if(app->stats_scroll > c.row - STATS_VISIBLE_ROWS) {
+        app->stats_scroll = c.row - STATS_VISIBLE_ROWS;
+    }
 }
 
 static void render_signal(Canvas* canvas, ZeroMeshApp* app) {
@@ -535,6 +653,14 @@ static void render_settings(Canvas* canvas, ZeroMeshApp* app) {
             label = "Baud Rate";
             snprintf(val_buf, sizeof(val_buf), "%lu", (unsigned long)app->baud);
             break;
+        case SettingAutoBaud:
+            label = "Auto Baud";
+            if(app->autobaud_want) {
+                snprintf(val_buf, sizeof(val_buf), "%lu?", (unsigned long)app->baud);
+            } else {
+                snprintf(val_buf, sizeof(val_buf), "Start");
+            }
+            break;
         case SettingVibro:
             label = "Vibration";
             snprintf(val_buf, sizeof(val_buf), "%s", app->notify_vibro ? "ON" : "OFF");
@@ -545,7 +671,7 @@ static void render_settings(Canvas* canvas, ZeroMeshApp* app) {
             break;
         case SettingRingtone:
             label = "Ringtone";
-            snprintf(val_buf, sizeof(val_buf), "%s", ringtone_names[app->notify_ringtone]);
+            snprintf(val_buf, sizeof(val_buf), "%s", ringtone_name(app, app->notify_ringtone));
             break;
         case SettingScrollSpeed:
             label = "Scroll Speed";
@@ -559,6 +685,14 @@ static void render_settings(Canvas* canvas, ZeroMeshApp* app) {
             label = "Long Msg";
             snprintf(val_buf, sizeof(val_buf), "%s", lmh_names[app->lmh_mode]);
             break;
+        case SettingCapture:
+            label = "Capture";
+            snprintf(val_buf, sizeof(val_buf), "%s", app->capture_want ? "ON" : "OFF");
+            break;
+        case SettingReplay:
+            label = "Replay";
+            snprintf(val_buf, sizeof(val_buf), "%s", replay_speed_name(app->replay_speed));
+            break;
         default:
             val_buf[0] = '\0';
             break;
@@ -585,6 +719,7 @@ void render_cb(Canvas* canvas, void* ctx) {
     canvas_clear(canvas);
 
     furi_mutex_acquire(app->lock, FuriWaitForever);
+    redraw_frame(app);
 
     switch(app->ui_mode) {
     case PAGE_MESSAGES:
@@ -623,14 +758,19 @@ static void setting_change(ZeroMeshApp* app, int direction) {
         break;
     }
     case SettingBaud: {
-        uint8_t idx = baud_to_index(app->baud);
-        if(direction > 0 && idx < BAUD_OPTIONS_COUNT - 1)
+        if(app->autobaud_want) break;
+        uint8_t idx = link_baud_index(app->baud);
+        if(direction > 0 && idx < link_baud_count() - 1)
             idx++;
         else if(direction < 0 && idx > 0)
             idx--;
-        uart_reopen(app, app->uart_id, baud_options[idx]);
+        uart_reopen(app, app->uart_id, link_baud(idx));
         break;
     }
+    case SettingAutoBaud:
+        app->autobaud_want = !app->autobaud_want;
+        redraw_wake(app);
+        break;
     case SettingVibro:
         app->notify_vibro = !app->notify_vibro;
         break;
@@ -639,12 +779,10 @@ static void setting_change(ZeroMeshApp* app, int direction) {
         break;
     case SettingRingtone: {
         int r = (int)app->notify_ringtone + direction;
-        if(r < 0) r = RINGTONE_COUNT - 1;
-        if(r >= RINGTONE_COUNT) r = 0;
-        app->notify_ringtone = (RingtoneType)r;
-        if(app->notify_ringtone != RingtoneNone) {
-            play_ringtone(app);
-        }
+        if(r < 0) r = ringtone_count(app) - 1;
+        if(r >= ringtone_count(app)) r = 0;
+        app->notify_ringtone = (uint8_t)r;
+        notify_preview_ringtone(app);
         break;
     }
     case SettingScrollSpeed: {
@@ -665,6 +803,14 @@ static void setting_change(ZeroMeshApp* app, int direction) {
         app->lmh_mode = (app->lmh_mode == LMH_Scroll) ? LMH_Wrap : LMH_Scroll;
         break;
     }
+    case SettingCapture:
+        app->capture_want = !app->capture_want;
+        redraw_wake(app);
+        break;
+    case SettingReplay:
+        app->replay_speed = replay_speed_step(app->replay_speed, direction);
+        redraw_wake(app);
+        break;
     default:
         break;
     }
@@ -676,7 +822,7 @@ void text_input_callback(void* ctx) {
     ZeroMeshApp* app = ctx;
     if(strlen(app->text_buffer) > 0) {
         if(app->ui_mode == PAGE_ROSTER && app->roster.state == RosterStateChat) {
-            uint32_t to_node = app->roster.nodes[app->roster.selected_idx].node_id;
+            uint32_t to_node = app->roster.selected_id;
             send_text_message(app, app->text_buffer, to_node);
         } else {
             send_text_message(app, app->text_buffer, 0xFFFFFFFF);
@@ -703,7 +849,7 @@ void input_cb(InputEvent* e, void* ctx) {
         if(app->ui_mode == PAGE_SETTINGS && app->settings_editing) {
             if(e->type == InputTypeShort || e->type == InputTypeRepeat) {
                 setting_change(app, -1);
-                view_port_update(app->vp);
+                redraw_mark(app, REDRAW_ALL);
             }
             break;
         }
@@ -712,44 +858,50 @@ void input_cb(InputEvent* e, void* ctx) {
             app->ui_mode = PAGE_COUNT - 1;
         else
             app->ui_mode--;
-        view_port_update(app->vp);
+        redraw_mark(app, REDRAW_ALL);
         break;
 
     case InputKeyRight:
         if(app->ui_mode == PAGE_SETTINGS && app->settings_editing) {
             if(e->type == InputTypeShort || e->type == InputTypeRepeat) {
                 setting_change(app, 1);
-                view_port_update(app->vp);
+                redraw_mark(app, REDRAW_ALL);
             }
             break;
         }
         if(e->type != InputTypeShort) break;
         app->ui_mode = (app->ui_mode + 1) % PAGE_COUNT;
-        view_port_update(app->vp);
+        redraw_mark(app, REDRAW_ALL);
         break;
 
     case InputKeyUp:
         if(e->type != InputTypeShort && e->type != InputTypeRepeat) break;
         if(app->ui_mode == PAGE_MESSAGES) {
-            if(app->msg_scroll_offset < app->history.count) {
+            bool more = false;
+            uint16_t count =
+                history_conv_count(app, HISTORY_CONV_CHANNEL(app->current_channel), &more);
+            if(more || app->msg_scroll_offset + 1 < count) {
                 app->msg_scroll_offset++;
             }
-            view_port_update(app->vp);
+            redraw_mark(app, REDRAW_ALL);
+        } else if(app->ui_mode == PAGE_STATS) {
+            if(app->stats_scroll > 0) app->stats_scroll--;
+            redraw_mark(app, REDRAW_ALL);
         } else if(app->ui_mode == PAGE_SIGNAL) {
             // Allow up/down scrolling in signal view if needed
-            view_port_update(app->vp);
+            redraw_mark(app, REDRAW_ALL);
         } else if(app->ui_mode == PAGE_LOGS) {
             if(app->log_paused && app->log_scroll_offset < LOG_LINES - 5) {
                 app->log_scroll_offset++;
             }
-            view_port_update(app->vp);
+            redraw_mark(app, REDRAW_ALL);
         } else if(app->ui_mode == PAGE_SETTINGS) {
             if(!app->settings_editing) {
                 if(app->settings_cursor > 0)
                     app->settings_cursor--;
                 else
                     app->settings_cursor = SETTING_COUNT - 1;
-                view_port_update(app->vp);
+                redraw_mark(app, REDRAW_ALL);
             }
         }
         break;
@@ -760,19 +912,22 @@ void input_cb(InputEvent* e, void* ctx) {
             if(app->msg_scroll_offset > 0) {
                 app->msg_scroll_offset--;
             }
-            view_port_update(app->vp);
+            redraw_mark(app, REDRAW_ALL);
+        } else if(app->ui_mode == PAGE_STATS) {
+            app->stats_scroll++;
+            redraw_mark(app, REDRAW_ALL);
         } else if(app->ui_mode == PAGE_SIGNAL) {
             // Allow up/down scrolling in signal view if needed
-            view_port_update(app->vp);
+            redraw_mark(app, REDRAW_ALL);
         } else if(app->ui_mode == PAGE_LOGS) {
             if(app->log_paused && app->log_scroll_offset > 0) {
                 app->log_scroll_offset--;
             }
-            view_port_update(app->vp);
+            redraw_mark(app, REDRAW_ALL);
         } else if(app->ui_mode == PAGE_SETTINGS) {
             if(!app->settings_editing) {
                 app->settings_cursor = (app->settings_cursor + 1) % SETTING_COUNT;
-                view_port_update(app->vp);
+                redraw_mark(app, REDRAW_ALL);
             }
         }
         break;
@@ -781,20 +936,22 @@ void input_cb(InputEvent* e, void* ctx) {
         if(e->type == InputTypeShort) {
             if(app->ui_mode == PAGE_SETTINGS) {
                 app->settings_editing = !app->settings_editing;
-                view_port_update(app->vp);
+                redraw_mark(app, REDRAW_ALL);
             } else if(app->ui_mode == PAGE_LOGS) {
                 app->log_paused = !app->log_paused;
                 if(!app->log_paused) app->log_scroll_offset = 0;
-                view_port_update(app->vp);
+                redraw_mark(app, REDRAW_ALL);
             } else if(app->ui_mode == PAGE_MESSAGES) {
                 app->show_keyboard = true;
+                redraw_wake(app);
             }
         } else if(e->type == InputTypeLong) {
             if(app->ui_mode == PAGE_MESSAGES && app->num_channels > 1) {
                 channel_next(app);
-                view_port_update(app->vp);
+                redraw_mark(app, REDRAW_ALL);
             } else {
-                request_info(app);
+                app->info_want = true;
+                redraw_wake(app);
                 set_status(app, "Info requested");
             }
         }
@@ -804,9 +961,10 @@ void input_cb(InputEvent* e, void* ctx) {
         if(e->type != InputTypeShort) break;
         if(app->ui_mode == PAGE_SETTINGS && app->settings_editing) {
             app->settings_editing = false;
-            view_port_update(app->vp);
+            redraw_mark(app, REDRAW_ALL);
         } else {
             app->stop_thread = true;
+            redraw_wake(app);
         }
         break;
 
@@ -818,4 +976,8 @@ void input_cb(InputEvent* e, void* ctx) {
 uint32_t kb_back_callback(void* ctx) {
     (void)ctx;
     return VIEW_NONE;
+}
+
+void kb_tick_callback(void* ctx) {
+    rx_events_drain((ZeroMeshApp*)ctx);
 }
\ No newline at end of file
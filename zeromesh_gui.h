@@ -4,8 +4,26 @@
 #include <gui/canvas.h>
 #include <input/input.h>
 
+typedef struct {
+    const Message* msgs[MSG_HISTORY];
+    int heights[MSG_HISTORY];
+    uint8_t visible;
+    uint16_t count;
+    bool more;
+} MessageWindow;
+
 void render_cb(Canvas* canvas, void* ctx);
 void input_cb(InputEvent* e, void* ctx);
 void draw_header(Canvas* canvas, ZeroMeshApp* app, const char* title);
+void draw_ack_glyph(Canvas* canvas, int x, int y, uint8_t ack);
+void message_window(
+    Canvas* canvas,
+    ZeroMeshApp* app,
+    uint32_t conv,
+    uint16_t* offset,
+    int msg_h,
+    int wrap_pad,
+    MessageWindow* win);
 void text_input_callback(void* ctx);
 uint32_t kb_back_callback(void* ctx);
+void kb_tick_callback(void* ctx);
@@ -1,29 +1,272 @@
 #include "zeromesh_history.h"
+#include "zeromesh_store.h"
+#include "zeromesh_redraw.h"
 #include <stdio.h>
+#include <string.h>
 #include <stdarg.h>
 
 #define TAG "zeromesh_serial"
 
-void history_add(ZeroMeshApp* app, const char* text, uint32_t from, uint32_t to, bool is_tx) {
+uint32_t history_conv_of(const Message* msg) {
+    if(msg->to == HISTORY_CONV_BROADCAST) return HISTORY_CONV_CHANNEL(msg->channel);
+    return msg->is_tx ? msg->to : msg->from;
+}
+
+static ConvIndex* history_conv_find(MessageHistory* h, uint32_t conv) {
+    for(uint8_t i = 0; i < HISTORY_CONV_MAX; i++) {
+        if(h->convs[i].used && h->convs[i].conv == conv) return &h->convs[i];
+    }
+    return NULL;
+}
+
+static bool history_conv_evict_before(const ConvIndex* a, const ConvIndex* b) {
+    if(!a->used || !b->used) return !a->used && b->used;
+    if((a->unread == 0) != (b->unread == 0)) return a->unread == 0;
+    return a->last_seq < b->last_seq;
+}
+
+static uint8_t history_conv_claim(MessageHistory* h, uint32_t conv) {
+    uint8_t victim = HISTORY_SLOT_NONE;
+    for(uint8_t i = 0; i < HISTORY_CONV_MAX; i++) {
+        const ConvIndex* c = &h->convs[i];
+        if(c->used && c->conv == conv) return i;
+        if(c->used && c->count > 0) continue;
+        if(victim == HISTORY_SLOT_NONE || history_conv_evict_before(c, &h->convs[victim])) victim = i;
+    }
+
+    ConvIndex* c = &h->convs[victim];
+    memset(c, 0, sizeof(*c));
+    c->used = true;
+    c->conv = conv;
+    c->newest = HISTORY_SLOT_NONE;
+    return victim;
+}
+
+static Message* history_push(ZeroMeshApp* app, uint32_t conv, uint32_t seq) {
+    MessageHistory* h = &app->history;
+    if(h->count == MSG_HISTORY) {
+        const Message* evicted = &h->msgs[h->head];
+        h->convs[evicted->conv_idx].count--;
+        MessagePage* page = &app->page;
+        if(page->valid && history_conv_of(evicted) == page->conv) page->shift++;
+        if(evicted->seq >= app->store.flushed && app->store.enabled) app->store.dropped++;
+    }
+
+    uint8_t slot = h->head;
+    uint8_t ci = history_conv_claim(h, conv);
+    ConvIndex* c = &h->convs[ci];
+
+    Message* msg = &h->msgs[slot];
+    msg->conv_idx = ci;
+    msg->conv_prev = (c->count > 0) ? c->newest : HISTORY_SLOT_NONE;
+    c->newest = slot;
+    c->count++;
+    c->last_seq = seq;
+
+    h->head = (h->head + 1) % MSG_HISTORY;
+    if(h->count < MSG_HISTORY) h->count++;
+    return msg;
+}
+
+uint32_t history_add(
+    ZeroMeshApp* app,
+    const char* text,
+    uint32_t from,
+    uint32_t to,
+    uint8_t channel,
+    bool is_tx) {
     furi_mutex_acquire(app->lock, FuriWaitForever);
 
-    uint8_t idx = app->history.head;
-    Message* msg = &app->history.msgs[idx];
+    Message tmp = {.from = from, .to = to, .channel = channel, .is_tx = is_tx};
+    uint32_t conv = history_conv_of(&tmp);
+    uint32_t seq = app->store.total++;
+    Message* msg = history_push(app, conv, seq);
 
     snprintf(msg->text, sizeof(msg->text), "%s", text);
     msg->from = from;
     msg->to = to;
+    msg->channel = channel;
     msg->is_tx = is_tx;
-    msg->timestamp = furi_get_tick() / 1000;
-
-    app->history.head = (app->history.head + 1) % MSG_HISTORY;
-    if(app->history.count < MSG_HISTORY) app->history.count++;
+    msg->timestamp = furi_hal_rtc_get_timestamp();
+    msg->seq = seq;
+    msg->ack = is_tx ? MsgAckPending : MsgAckNone;
+    if(seq == app->store.flushed) app->store.pending_tick = furi_get_tick();
+    if(!is_tx) {
+        ConvIndex* c = &app->history.convs[msg->conv_idx];
+        if(c->unread < UINT16_MAX) c->unread++;
+    }
 
     FURI_LOG_I(TAG, "history_add: count=%u head=%u is_tx=%d text=%s",
                app->history.count, app->history.head, is_tx, text);
 
     furi_mutex_release(app->lock);
-    view_port_update(app->vp);
+    redraw_mark(app, REDRAW_PAGE(PAGE_MESSAGES) | REDRAW_PAGE(PAGE_ROSTER));
+    return seq;
+}
+
+void history_set_ack(ZeroMeshApp* app, uint32_t seq, MsgAck ack) {
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+    Message* msg = (Message*)history_find_seq(app, seq);
+    if(msg) msg->ack = ack;
+    furi_mutex_release(app->lock);
+    store_set_ack(app, seq, ack);
+    redraw_mark(app, REDRAW_PAGE(PAGE_MESSAGES) | REDRAW_PAGE(PAGE_ROSTER));
+}
+
+void history_restore(ZeroMeshApp* app, const Message* msg) {
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+    Message* slot = history_push(app, history_conv_of(msg), msg->seq);
+    uint8_t conv_idx = slot->conv_idx;
+    uint8_t conv_prev = slot->conv_prev;
+    *slot = *msg;
+    slot->conv_idx = conv_idx;
+    slot->conv_prev = conv_prev;
+    furi_mutex_release(app->lock);
+}
+
+const Message* history_find_seq(ZeroMeshApp* app, uint32_t seq) {
+    const MessageHistory* h = &app->history;
+    if(h->count == 0) return NULL;
+    const Message* newest = &h->msgs[(h->head + MSG_HISTORY - 1) % MSG_HISTORY];
+    uint32_t back = newest->seq - seq;
+    if(seq > newest->seq || back >= h->count) return NULL;
+    const Message* msg = &h->msgs[(h->head + MSG_HISTORY - 1 - back) % MSG_HISTORY];
+    return (msg->seq == seq) ? msg : NULL;
+}
+
+static uint16_t history_ram_count(ZeroMeshApp* app, uint32_t conv) {
+    const ConvIndex* c = history_conv_find(&app->history, conv);
+    return c ? c->count : 0;
+}
+
+static uint32_t history_oldest_seq(ZeroMeshApp* app) {
+    const MessageHistory* h = &app->history;
+    if(h->count == 0) return app->store.total;
+    return h->msgs[(h->head + MSG_HISTORY - h->count) % MSG_HISTORY].seq;
+}
+
+uint16_t history_conv_count(ZeroMeshApp* app, uint32_t conv, bool* more) {
+    uint16_t n = history_ram_count(app, conv);
+    const MessagePage* page = &app->page;
+    bool on_sd = app->store.enabled && history_oldest_seq(app) > 0 && app->store.flushed > 0;
+
+    if(page->valid && page->conv == conv) {
+        n += page->shift + page->base + page->count;
+        *more = on_sd && !page->exhausted;
+    } else {
+        *more = on_sd;
+    }
+    return n;
+}
+
+uint16_t history_conv_unread(ZeroMeshApp* app, uint32_t conv) {
+    const ConvIndex* c = history_conv_find(&app->history, conv);
+    return c ? c->unread : 0;
+}
+
+void history_conv_mark_read(ZeroMeshApp* app, uint32_t conv) {
+    ConvIndex* c = history_conv_find(&app->history, conv);
+    if(c) c->unread = 0;
+}
+
+uint8_t history_conv_collect(
+    ZeroMeshApp* app,
+    uint32_t conv,
+    uint16_t k,
+    const Message** out,
+    uint8_t max) {
+    const MessageHistory* h = &app->history;
+    const ConvIndex* c = history_conv_find(&app->history, conv);
+    uint16_t ram = c ? c->count : 0;
+    uint8_t n = 0;
+
+    uint8_t slot = (ram > 0) ? c->newest : HISTORY_SLOT_NONE;
+    for(uint16_t i = 0; i < ram && n < max; i++) {
+        if(i >= k) out[n++] = &h->msgs[slot];
+        slot = h->msgs[slot].conv_prev;
+    }
+    if(n == max) return n;
+
+    const MessagePage* page = &app->page;
+    if(!page->valid || page->conv != conv) return n;
+    for(uint16_t j = k + n - ram; n < max; j++) {
+        if(j < page->shift) break;
+        uint16_t idx = j - page->shift;
+        if(idx < page->base || idx >= page->base + page->count) break;
+        out[n++] = &page->msgs[idx - page->base];
+    }
+    return n;
+}
+
+static bool history_page_covers(ZeroMeshApp* app, uint32_t conv, uint16_t k) {
+    uint16_t ram = history_ram_count(app, conv);
+    if(k < ram) return true;
+
+    const MessagePage* page = &app->page;
+    if(!page->valid || page->conv != conv) return false;
+    uint16_t j = k - ram;
+    if(j < page->shift) return false;
+    j -= page->shift;
+    return j >= page->base && (j < page->base + page->count || page->exhausted);
+}
+
+void history_page_request(ZeroMeshApp* app, uint32_t conv, uint16_t k) {
+    if(!app->store.enabled || history_page_covers(app, conv, k)) return;
+    app->page_want_conv = conv;
+    app->page_want_k = k;
+    app->page_want = true;
+    redraw_wake(app);
+}
+
+void history_page_sync(ZeroMeshApp* app) {
+    if(!app->page_want || !app->store.enabled) return;
+
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+    uint32_t conv = app->page_want_conv;
+    uint16_t k = app->page_want_k;
+    app->page_want = false;
+
+    if(history_page_covers(app, conv, k)) {
+        furi_mutex_release(app->lock);
+        return;
+    }
+
+    MessagePage* page = &app->page;
+    uint16_t j = k - history_ram_count(app, conv);
+    uint16_t base = (j > MSG_PAGE_SIZE / 2) ? j - MSG_PAGE_SIZE / 2 : 0;
+    uint32_t top_seq = history_oldest_seq(app);
+    uint16_t skip = base;
+
+    /* Scrolling further back continues from a record already in the page
+     * instead of walking the conversation again from its newest record */
+    if(page->valid && page->conv == conv && base > page->shift + page->base &&
+       base - page->shift - page->base <= page->count) {
+        top_seq = page->msgs[base - page->shift - page->base - 1].seq;
+        skip = 0;
+    }
+
+    page->valid = true;
+    page->conv = conv;
+    page->shift = 0;
+    page->base = base;
+    page->count = 0;
+    page->exhausted = false;
+    furi_mutex_release(app->lock);
+
+    uint16_t got;
+    bool exhausted;
+    uint32_t start = furi_get_tick();
+    bool ok = store_scan(app, conv, top_seq, skip, page->msgs, MSG_PAGE_SIZE, &got, &exhausted);
+    uint32_t elapsed = furi_get_tick() - start;
+
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+    page->count = got;
+    page->exhausted = exhausted || !ok;
+    app->store.page_loads++;
+    app->store.page_last_ms = elapsed;
+    furi_mutex_release(app->lock);
+
+    redraw_mark(app, REDRAW_PAGE(PAGE_MESSAGES) | REDRAW_PAGE(PAGE_ROSTER));
 }
 
 void log_line(ZeroMeshApp* app, const char* fmt, ...) {
@@ -46,6 +289,7 @@ void log_line(ZeroMeshApp* app, const char* fmt, ...) {
     }
 
     furi_mutex_release(app->lock);
+    redraw_mark(app, REDRAW_PAGE(PAGE_LOGS));
 
     FURI_LOG_I(TAG, "%s", buf);
 }
@@ -60,5 +304,5 @@ void set_status(ZeroMeshApp* app, const char* fmt, ...) {
     furi_mutex_release(app->lock);
     va_end(args);
 
-    view_port_update(app->vp);
+    redraw_mark(app, REDRAW_ALL);
 }
@@ -2,6 +2,30 @@
 
 #include "zeromesh_serial.h"
 
-void history_add(ZeroMeshApp* app, const char* text, uint32_t from, uint32_t to, bool is_tx);
+#define HISTORY_CONV_BROADCAST   0xFFFFFFFF
+#define HISTORY_CONV_CHANNEL(ch) (HISTORY_CONV_BROADCAST - (uint32_t)(ch))
+
+uint32_t history_add(
+    ZeroMeshApp* app,
+    const char* text,
+    uint32_t from,
+    uint32_t to,
+    uint8_t channel,
+    bool is_tx);
+void history_set_ack(ZeroMeshApp* app, uint32_t seq, MsgAck ack);
+void history_restore(ZeroMeshApp* app, const Message* msg);
+const Message* history_find_seq(ZeroMeshApp* app, uint32_t seq);
+uint32_t history_conv_of(const Message* msg);
+uint16_t history_conv_count(ZeroMeshApp* app, uint32_t conv, bool* more);
+uint8_t history_conv_collect(
+    ZeroMeshApp* app,
+    uint32_t conv,
+    uint16_t k,
+    const Message** out,
+    uint8_t max);
+uint16_t history_conv_unread(ZeroMeshApp* app, uint32_t conv);
+void history_conv_mark_read(ZeroMeshApp* app, uint32_t conv);
+void history_page_request(ZeroMeshApp* app, uint32_t conv, uint16_t k);
+void history_page_sync(ZeroMeshApp* app);
 void log_line(ZeroMeshApp* app, const char* fmt, ...);
 void set_status(ZeroMeshApp* app, const char* fmt, ...);
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "zeromesh_layout.h"
+
+#include <string.h>
+
+static void layout_wrap(Canvas* canvas, TextLayout* layout, const char* text, uint8_t max_w) {
+    size_t text_len = strlen(text);
+    size_t pos = 0;
+    layout->lines = 0;
+
+    while(pos < text_len && layout->lines < LAYOUT_MAX_LINES) {
+        size_t line_len = 0;
+        size_t last_space = 0;
+        uint16_t line_w = 0;
+
+        while(pos + line_len < text_len) {
+            char ch = text[pos + line_len];
+            if(ch == ' ') last_space = line_len;
+
+            line_w += canvas_glyph_width(canvas, (uint8_t)ch);
+            if(line_w > max_w) {
+                if(last_space > 0) {
+                    line_len = last_space;
+                } else if(line_len > 0) {
+                    line_len--;
+                }
+                break;
+            }
+            line_len++;
+        }
+
+        if(line_len == 0) line_len = 1;
+
+        layout->starts[layout->lines] = (uint8_t)pos;
+        layout->lens[layout->lines] = (uint8_t)line_len;
+        layout->lines++;
+
+        pos += line_len;
+        while(pos < text_len && text[pos] == ' ') pos++;
+    }
+
+    if(layout->lines == 0) {
+        layout->starts[0] = 0;
+        layout->lens[0] = 0;
+        layout->lines = 1;
+    }
+}
+
+const TextLayout* layout_get(Canvas* canvas, ZeroMeshApp* app, const Message* msg, Font font, uint8_t max_w) {
+    TextLayout* layout = &app->layout_cache[msg->seq % LAYOUT_CACHE_SIZE];
+    if(layout->valid && layout->seq == msg->seq && layout->font == font && layout->width == max_w) {
+        app->layout_hits++;
+        return layout;
+    }
+
+    app->layout_misses++;
+    canvas_set_font(canvas, font);
+    layout->seq = msg->seq;
+    layout->font = font;
+    layout->width = max_w;
+    layout->text_w = canvas_string_width(canvas, msg->text);
+    layout_wrap(canvas, layout, msg->text, max_w);
+    layout->valid = true;
+    return layout;
+}
+
+void layout_draw_lines(Canvas* canvas, const TextLayout* layout, const char* text, int x, int y) {
+    char line_buf[MSG_TEXT_LEN];
+    for(uint8_t i = 0; i < layout->lines; i++) {
+        memcpy(line_buf, text + layout->starts[i], layout->lens[i]);
+        line_buf[layout->lens[i]] = '\0';
+        canvas_draw_str(canvas, x, y, line_buf);
+        y += 9;
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "zeromesh_serial.h"
+#include <gui/canvas.h>
+
+const TextLayout* layout_get(Canvas* canvas, ZeroMeshApp* app, const Message* msg, Font font, uint8_t max_w);
+void layout_draw_lines(Canvas* canvas, const TextLayout* layout, const char* text, int x, int y);
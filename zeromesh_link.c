@@ -0,0 +1,170 @@
+#include "zeromesh_link.h"
+#include "zeromesh_uart.h"
+#include "zeromesh_protocol.h"
+#include "zeromesh_history.h"
+#include "zeromesh_settings.h"
+#include "zeromesh_redraw.h"
+
+static const uint32_t baud_options[] = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600};
+#define BAUD_OPTIONS_COUNT (sizeof(baud_options) / sizeof(baud_options[0]))
+#define BAUD_DEFAULT_INDEX 4
+
+uint8_t link_baud_count(void) {
+    return BAUD_OPTIONS_COUNT;
+}
+
+uint32_t link_baud(uint8_t idx) {
+    return baud_options[(idx < BAUD_OPTIONS_COUNT) ? idx : BAUD_DEFAULT_INDEX];
+}
+
+uint8_t link_baud_index(uint32_t baud) {
+    for(uint8_t i = 0; i < BAUD_OPTIONS_COUNT; i++) {
+        if(baud_options[i] == baud) return i;
+    }
+    return BAUD_DEFAULT_INDEX;
+}
+
+static uint32_t link_errors(ZeroMeshApp* app) {
+    return app->framing.bad_len + app->framing.rejected + app->rx_decode_fail;
+}
+
+static void link_meter(ZeroMeshApp* app, uint32_t now) {
+    uint32_t elapsed = now - app->link_tick;
+    if(elapsed < LINK_SAMPLE_MS) return;
+
+    uint32_t bytes = app->rx_bytes - app->link_bytes;
+    uint32_t ok = app->rx_frames_ok - app->link_ok;
+    uint32_t err = link_errors(app) - app->link_err;
+
+    app->link_bps = (uint32_t)(((uint64_t)bytes * 1000) / elapsed);
+    if(ok + err > 0) app->link_err_pct = (uint8_t)((err * 100) / (ok + err));
+
+    app->link_tick = now;
+    app->link_bytes = app->rx_bytes;
+    app->link_ok = app->rx_frames_ok;
+    app->link_err = link_errors(app);
+    redraw_mark(app, REDRAW_PAGE(PAGE_STATS));
+}
+
+static void autobaud_probe(ZeroMeshApp* app, uint8_t idx) {
+    app->autobaud_idx = idx;
+    app->autobaud_probing = false;
+    app->autobaud_tick = furi_get_tick();
+    uart_reopen(app, app->uart_id, baud_options[idx]);
+}
+
+static void autobaud_finish(ZeroMeshApp* app, bool found) {
+    app->autobaud_active = false;
+    app->autobaud_want = false;
+    if(found) {
+        log_line(app, "Auto-baud: %lu", (unsigned long)app->baud);
+        settings_save(app);
+    } else {
+        log_line(app, "Auto-baud: no link");
+        uart_reopen(app, app->uart_id, app->autobaud_prev);
+        request_info(app);
+    }
+    redraw_mark(app, REDRAW_ALL);
+}
+
+static void autobaud_step(ZeroMeshApp* app, uint32_t now) {
+    uint32_t elapsed = now - app->autobaud_tick;
+
+    if(!app->autobaud_probing) {
+        if(elapsed < LINK_SETTLE_MS) return;
+        app->autobaud_probing = true;
+        app->autobaud_tick = now;
+        app->autobaud_ok = app->rx_frames_ok;
+        app->autobaud_err = link_errors(app);
+        request_info(app);
+        return;
+    }
+
+    uint32_t ok = app->rx_frames_ok - app->autobaud_ok;
+    uint32_t err = link_errors(app) - app->autobaud_err;
+    if(err > 0 || elapsed >= LINK_PROBE_MS) {
+        if(ok > 0 && err == 0) {
+            autobaud_finish(app, true);
+        } else if(app->autobaud_idx > 0) {
+            autobaud_probe(app, app->autobaud_idx - 1);
+        } else {
+            autobaud_finish(app, false);
+        }
+        redraw_mark(app, REDRAW_PAGE(PAGE_SETTINGS));
+    }
+}
+
+static void link_down(ZeroMeshApp* app, uint32_t now) {
+    app->link_up = false;
+    app->link_down_tick = now;
+    app->link_probe_tick = now;
+    request_info(app);
+    redraw_mark(app, REDRAW_ALL);
+}
+
+void link_resync(ZeroMeshApp* app) {
+    app->link_reboots++;
+    log_line(app, "Node rebooted, resyncing");
+    link_down(app, furi_get_tick());
+}
+
+static void link_watchdog(ZeroMeshApp* app, uint32_t now) {
+    if(app->link_up) {
+        if(app->link_hb_pending) {
+            if((int32_t)(app->link_rx_tick - app->link_hb_tick) >= 0) {
+                app->link_hb_pending = false;
+                app->link_hb_answered = true;
+                app->link_hb_misses = 0;
+            } else if(now - app->link_hb_tick >= LINK_HB_REPLY_MS) {
+                app->link_hb_pending = false;
+                if(app->link_hb_answered && ++app->link_hb_misses >= LINK_HB_MISSES) {
+                    app->link_losses++;
+                    log_line(app, "Link lost");
+                    link_down(app, now);
+                }
+            }
+        } else if(now - app->link_rx_tick >= LINK_HEARTBEAT_MS && now - app->link_hb_tick >= LINK_HEARTBEAT_MS) {
+            app->link_hb_tick = now;
+            app->link_hb_pending = true;
+            send_heartbeat(app);
+        }
+    } else if(app->config_complete) {
+        app->link_up = true;
+        app->link_hb_tick = now;
+        app->link_hb_pending = false;
+        app->link_hb_misses = 0;
+        app->link_reconnect_ms = app->boot_tick + app->config_done_ms - app->link_down_tick;
+        log_line(app, "Link up: %lums", (unsigned long)app->link_reconnect_ms);
+        redraw_mark(app, REDRAW_ALL);
+    } else if(now - app->link_probe_tick >= LINK_RETRY_MS) {
+        app->link_probe_tick = now;
+        request_info(app);
+    }
+}
+
+void link_sync(ZeroMeshApp* app) {
+    uint32_t now = furi_get_tick();
+
+    if(app->info_want) {
+        app->info_want = false;
+        request_info(app);
+    }
+
+    if(app->autobaud_want != app->autobaud_active) {
+        if(app->autobaud_want) {
+            app->autobaud_active = true;
+            app->autobaud_prev = app->baud;
+            log_line(app, "Auto-baud: sweeping");
+            autobaud_probe(app, BAUD_OPTIONS_COUNT - 1);
+        } else {
+            app->autobaud_active = false;
+            uart_reopen(app, app->uart_id, app->autobaud_prev);
+        }
+    } else if(app->autobaud_active) {
+        autobaud_step(app, now);
+    } else {
+        link_watchdog(app, now);
+    }
+
+    link_meter(app, now);
+}
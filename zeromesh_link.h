@@ -0,0 +1,9 @@
+#pragma once
+
+#include "zeromesh_serial.h"
+
+uint8_t link_baud_count(void);
+uint32_t link_baud(uint8_t idx);
+uint8_t link_baud_index(uint32_t baud);
+void link_resync(ZeroMeshApp* app);
+void link_sync(ZeroMeshApp* app);
@@ -0,0 +1,133 @@
+#include "zeromesh_names.h"
+#include "zeromesh_roster.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Each pool string is preceded by its owner, entry index * NameKindCount
+ * + kind, so compaction can walk the pool in order and slide live strings
+ * down in place */
+#define NAME_HDR sizeof(uint16_t)
+
+void names_init(ZeroMeshApp* app, uint16_t capacity) {
+    NameTable* t = &app->names;
+    t->count = capacity + 1;
+    t->self = capacity;
+    t->entries = malloc(t->count * sizeof(NodeName));
+    memset(t->entries, 0xFF, t->count * sizeof(NodeName));
+    size_t pool_size = (size_t)t->count * NAME_POOL_PER_NODE;
+    t->pool_size = (pool_size > 0xFFFE) ? 0xFFFE : (uint16_t)pool_size;
+    t->pool = malloc(t->pool_size);
+    t->pool_used = 0;
+    t->pool_live = 0;
+}
+
+void names_free(ZeroMeshApp* app) {
+    free(app->names.entries);
+    free(app->names.pool);
+    app->names.entries = NULL;
+    app->names.pool = NULL;
+}
+
+static void names_release(NameTable* t, NodeName* e) {
+    for(uint8_t k = 0; k < NameKindCount; k++) {
+        if(e->off[k] == NAME_OFF_NONE) continue;
+        t->pool_live -= NAME_HDR + e->len[k] + 1;
+        e->off[k] = NAME_OFF_NONE;
+    }
+}
+
+static void names_compact(NameTable* t) {
+    uint16_t used = 0;
+    uint16_t pos = 0;
+    while(pos < t->pool_used) {
+        uint16_t owner;
+        memcpy(&owner, t->pool + pos, NAME_HDR);
+        uint16_t size = NAME_HDR + strlen(t->pool + pos + NAME_HDR) + 1;
+        NodeName* e = &t->entries[owner / NameKindCount];
+        uint8_t k = owner % NameKindCount;
+        if(e->off[k] == pos + NAME_HDR) {
+            if(used != pos) memmove(t->pool + used, t->pool + pos, size);
+            e->off[k] = used + NAME_HDR;
+            used += size;
+        }
+        pos += size;
+    }
+    t->pool_used = used;
+    t->compactions++;
+}
+
+static void names_intern(NameTable* t, uint16_t idx, NameKind kind, const char* s, size_t len) {
+    len = strnlen(s, len);
+    size_t size = NAME_HDR + len + 1;
+    if(t->pool_used + size > t->pool_size) names_compact(t);
+    if(t->pool_used + size > t->pool_size) return;
+
+    NodeName* e = &t->entries[idx];
+    uint16_t owner = idx * NameKindCount + kind;
+    memcpy(t->pool + t->pool_used, &owner, NAME_HDR);
+    memcpy(t->pool + t->pool_used + NAME_HDR, s, len);
+    t->pool[t->pool_used + NAME_HDR + len] = '\0';
+    e->off[kind] = t->pool_used + NAME_HDR;
+    e->len[kind] = (uint8_t)len;
+    e->width[kind] = 0;
+    t->pool_used += size;
+    t->pool_live += size;
+}
+
+void names_set(
+    ZeroMeshApp* app,
+    uint16_t idx,
+    uint32_t node_id,
+    const uint8_t* short_name,
+    size_t short_len,
+    const uint8_t* long_name,
+    size_t long_len) {
+    NameTable* t = &app->names;
+    if(!t->entries || idx >= t->count) return;
+    NodeName* e = &t->entries[idx];
+    names_release(t, e);
+
+    char id[12];
+    if(short_len == 0) {
+        snprintf(id, sizeof(id), "!%04lx", (unsigned long)(node_id & 0xFFFF));
+        names_intern(t, idx, NameShort, id, strlen(id));
+    } else {
+        names_intern(t, idx, NameShort, (const char*)short_name, short_len > NAME_SHORT_MAX ? NAME_SHORT_MAX : short_len);
+    }
+    if(long_len == 0) {
+        snprintf(id, sizeof(id), "!%08lx", (unsigned long)node_id);
+        names_intern(t, idx, NameLong, id, strlen(id));
+    } else {
+        names_intern(t, idx, NameLong, (const char*)long_name, long_len > NAME_LONG_MAX ? NAME_LONG_MAX : long_len);
+    }
+}
+
+void names_reset(ZeroMeshApp* app, uint16_t idx, uint32_t node_id) {
+    names_set(app, idx, node_id, NULL, 0, NULL, 0);
+}
+
+uint16_t names_lookup(ZeroMeshApp* app, uint32_t node_id) {
+    if(node_id != 0 && node_id == app->my_node_num) return app->names.self;
+    return roster_lookup(app, node_id);
+}
+
+const char* names_label(ZeroMeshApp* app, uint16_t idx, NameKind kind) {
+    const NameTable* t = &app->names;
+    if(idx >= t->count || t->entries[idx].off[kind] == NAME_OFF_NONE) return "?";
+    return t->pool + t->entries[idx].off[kind];
+}
+
+uint8_t names_width(Canvas* canvas, ZeroMeshApp* app, uint16_t idx, NameKind kind, Font font) {
+    NameTable* t = &app->names;
+    if(idx >= t->count || t->entries[idx].off[kind] == NAME_OFF_NONE) return 0;
+    NodeName* e = &t->entries[idx];
+    if(e->width[kind] == 0 || e->font[kind] != font) {
+        canvas_set_font(canvas, font);
+        uint16_t w = canvas_string_width(canvas, t->pool + e->off[kind]);
+        e->width[kind] = (w > 255) ? 255 : (uint8_t)w;
+        e->font[kind] = font;
+    }
+    return e->width[kind];
+}
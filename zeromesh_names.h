@@ -0,0 +1,19 @@
+#pragma once
+
+#include "zeromesh_serial.h"
+#include <gui/canvas.h>
+
+void names_init(ZeroMeshApp* app, uint16_t capacity);
+void names_free(ZeroMeshApp* app);
+void names_reset(ZeroMeshApp* app, uint16_t idx, uint32_t node_id);
+void names_set(
+    ZeroMeshApp* app,
+    uint16_t idx,
+    uint32_t node_id,
+    const uint8_t* short_name,
+    size_t short_len,
+    const uint8_t* long_name,
+    size_t long_len);
+uint16_t names_lookup(ZeroMeshApp* app, uint32_t node_id);
+const char* names_label(ZeroMeshApp* app, uint16_t idx, NameKind kind);
+uint8_t names_width(Canvas* canvas, ZeroMeshApp* app, uint16_t idx, NameKind kind, Font font);
@@ -1,8 +1,14 @@
 #include "zeromesh_notify.h"
 #include <notification/notification.h>
 #include <notification/notification_messages.h>
+#include <storage/storage.h>
 
-const char* ringtone_names[] = {
+#include <stdlib.h>
+#include <stddef.h>
+
+#define TAG "zeromesh_serial"
+
+static const char* ringtone_names[RINGTONE_COUNT] = {
     "Off",
     "Short",
     "Double",
@@ -56,268 +62,240 @@ static const NotificationSequence seq_vibro_led = {
     NULL,
 };
 
-static void play_nokia(void) {
-    const int melody[] = {659, 587, 370, 415, 554, 494, 370, 330};
-    const int durations[] = {125, 125, 250, 250, 125, 125, 250, 250};
-    for(int i = 0; i < 8; i++) {
-        furi_hal_speaker_start((float)melody[i], 0.6f);
-        furi_delay_ms(durations[i]);
-        furi_hal_speaker_stop();
-        furi_delay_ms(20);
-    }
+static const char* ringtone_files[RINGTONE_COUNT] = {
+    NULL,
+    "short.rtttl",
+    "double.rtttl",
+    "triple.rtttl",
+    "long.rtttl",
+    "sos.rtttl",
+    "chirp.rtttl",
+    "nokia.rtttl",
+    "descend.rtttl",
+    "bounce.rtttl",
+    "alert.rtttl",
+    "pulse.rtttl",
+    "siren.rtttl",
+    "beep3.rtttl",
+    "trill.rtttl",
+    "supermario.rtttl",
+    "levelup.rtttl",
+    "metric.rtttl",
+    "minimalist.rtttl",
+};
+
+uint8_t ringtone_count(ZeroMeshApp* app) {
+    return RINGTONE_COUNT + app->ringtone_user_count;
 }
 
-static void play_descend(void) {
-    for(int f = 1200; f >= 600; f -= 100) {
-        furi_hal_speaker_start((float)f, 0.6f);
-        furi_delay_ms(80);
-    }
-    furi_hal_speaker_stop();
+const char* ringtone_name(ZeroMeshApp* app, uint8_t idx) {
+    if(idx < RINGTONE_COUNT) return ringtone_names[idx];
+    if(idx < ringtone_count(app)) return app->ringtone_user_names[idx - RINGTONE_COUNT];
+    return "?";
 }
 
-static void play_bounce(void) {
-    const int melody[] = {600, 800, 600, 900, 600, 1000};
-    for(int i = 0; i < 6; i++) {
-        furi_hal_speaker_start((float)melody[i], 0.6f);
-        furi_delay_ms(100);
-        furi_hal_speaker_stop();
-        furi_delay_ms(30);
+static void ringtone_scan_user(ZeroMeshApp* app) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* dir = storage_file_alloc(storage);
+
+    app->ringtone_user_count = 0;
+    if(storage_dir_open(dir, RINGTONE_USER_DIR)) {
+        FileInfo info;
+        char name[64];
+        while(app->ringtone_user_count < RINGTONE_USER_MAX &&
+              storage_dir_read(dir, &info, name, sizeof(name))) {
+            if(file_info_is_dir(&info)) continue;
+            size_t len = strlen(name);
+            if(len <= 6 || strcmp(name + len - 6, ".rtttl") != 0) continue;
+            len -= 6;
+            if(len >= RINGTONE_USER_NAME_LEN) continue;
+            char* stem = app->ringtone_user_names[app->ringtone_user_count++];
+            memcpy(stem, name, len);
+            stem[len] = '\0';
+        }
     }
+    storage_dir_close(dir);
+
+    storage_file_free(dir);
+    furi_record_close(RECORD_STORAGE);
 }
 
-static void play_alert(void) {
-    for(int i = 0; i < 3; i++) {
-        furi_hal_speaker_start(900.0f, 0.7f);
-        furi_delay_ms(150);
-        furi_hal_speaker_stop();
-        furi_delay_ms(100);
-        furi_hal_speaker_start(700.0f, 0.7f);
-        furi_delay_ms(150);
-        furi_hal_speaker_stop();
-        if(i < 2) furi_delay_ms(100);
+static const RtttlTune* ringtone_get(ZeroMeshApp* app, uint8_t idx) {
+    if(idx == RingtoneNone || idx >= ringtone_count(app)) return NULL;
+    if(app->ringtone_cache[idx]) return app->ringtone_cache[idx];
+
+    char path[MAX_RINGTONE_PATH];
+    if(idx < RINGTONE_COUNT) {
+        snprintf(path, sizeof(path), APP_ASSETS_PATH("%s"), ringtone_files[idx]);
+    } else {
+        snprintf(
+            path,
+            sizeof(path),
+            RINGTONE_USER_DIR "/%s.rtttl",
+            app->ringtone_user_names[idx - RINGTONE_COUNT]);
     }
-}
 
-static void play_pulse(void) {
-    for(int i = 0; i < 4; i++) {
-        furi_hal_speaker_start(800.0f, 0.5f + (float)i * 0.1f);
-        furi_delay_ms(120);
-        furi_hal_speaker_stop();
-        furi_delay_ms(80);
+    char* src = malloc(RINGTONE_SRC_MAX + 1);
+    size_t len = 0;
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    if(storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        len = storage_file_read(file, src, RINGTONE_SRC_MAX);
+        storage_file_close(file);
     }
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    len = rtttl_clip(src, len, RINGTONE_SRC_MAX);
+    src[len] = '\0';
+
+    RtttlTune* scratch = malloc(sizeof(RtttlTune));
+    if(len > 0 && rtttl_compile(src, scratch)) {
+        size_t size = offsetof(RtttlTune, notes) + scratch->count * sizeof(RtttlNote);
+        RtttlTune* tune = malloc(size);
+        memcpy(tune, scratch, size);
+        app->ringtone_cache[idx] = tune;
+    } else {
+        FURI_LOG_W(TAG, "Ringtone load failed: %s", path);
+    }
+    free(scratch);
+    free(src);
+
+    return app->ringtone_cache[idx];
 }
 
-static void play_siren(void) {
-    for(int cycle = 0; cycle < 2; cycle++) {
-        for(int f = 600; f <= 900; f += 75) {
-            furi_hal_speaker_start((float)f, 0.6f);
-            furi_delay_ms(40);
-        }
-        for(int f = 900; f >= 600; f -= 75) {
-            furi_hal_speaker_start((float)f, 0.6f);
-            furi_delay_ms(40);
-        }
-    }
+static void player_stop(ZeroMeshApp* app) {
+    if(!app->player_tune) return;
     furi_hal_speaker_stop();
+    furi_hal_speaker_release();
+    app->player_tune = NULL;
 }
 
-static void play_beep3(void) {
-    for(int i = 0; i < 3; i++) {
-        furi_hal_speaker_start(1000.0f, 0.6f);
-        furi_delay_ms(100);
-        furi_hal_speaker_stop();
-        if(i < 2) furi_delay_ms(100);
-    }
-}
+static void player_step(ZeroMeshApp* app) {
+    const RtttlTune* tune = app->player_tune;
+    if(!tune) return;
 
-static void play_trill(void) {
-    const int melody[] = {800, 1000, 800, 1000, 800, 1000, 1200};
-    const int durations[] = {80, 80, 80, 80, 80, 80, 200};
-    for(int i = 0; i < 7; i++) {
-        furi_hal_speaker_start((float)melody[i], 0.6f);
-        furi_delay_ms(durations[i]);
-        furi_hal_speaker_stop();
-        if(i < 6) furi_delay_ms(30);
+    if(app->player_pos >= tune->count) {
+        player_stop(app);
+        app->notify_last_tick = furi_get_tick();
+        return;
     }
-}
 
-static void play_mario(void) {
-    const int melody[] = {659, 659, 659, 523, 659, 784};
-    const int durations[] = {150, 150, 150, 100, 150, 300};
-    for(int i = 0; i < 6; i++) {
-        furi_hal_speaker_start((float)melody[i], 0.6f);
-        furi_delay_ms(durations[i]);
+    const RtttlNote* note = &tune->notes[app->player_pos++];
+    if(note->freq > 0) {
+        furi_hal_speaker_start((float)note->freq, RINGTONE_VOLUME);
+    } else {
         furi_hal_speaker_stop();
-        if(i < 5) furi_delay_ms(50);
     }
+    app->player_next_tick += furi_ms_to_ticks(note->ms);
 }
 
-static void play_levelup(void) {
-    const int melody[] = {523, 659, 784, 1047, 1319, 1568};
-    for(int i = 0; i < 6; i++) {
-        furi_hal_speaker_start((float)melody[i], 0.6f);
-        furi_delay_ms(100);
-        furi_hal_speaker_stop();
-        if(i < 5) furi_delay_ms(30);
-    }
-}
+static void player_start(ZeroMeshApp* app, uint8_t idx) {
+    player_stop(app);
 
-static void play_metric(void) {
-    for(int i = 0; i < 4; i++) {
-        furi_hal_speaker_start(1047.0f, 0.6f);
-        furi_delay_ms(120);
-        furi_hal_speaker_stop();
-        if(i < 3) furi_delay_ms(120);
-    }
+    const RtttlTune* tune = ringtone_get(app, idx);
+    if(!tune) return;
+    if(!furi_hal_speaker_acquire(100)) return;
+
+    app->player_tune = tune;
+    app->player_pos = 0;
+    app->player_next_tick = furi_get_tick();
+    player_step(app);
 }
 
-static void play_minimalist(void) {
-    furi_hal_speaker_start(1047.0f, 0.6f);
-    furi_delay_ms(150);
-    furi_hal_speaker_stop();
-    furi_delay_ms(150);
-    furi_hal_speaker_start(1047.0f, 0.6f);
-    furi_delay_ms(150);
-    furi_hal_speaker_stop();
+static uint32_t player_timeout(ZeroMeshApp* app) {
+    if(!app->player_tune) return FuriWaitForever;
+    int32_t left = (int32_t)(app->player_next_tick - furi_get_tick());
+    return (left > 0) ? (uint32_t)left : 0;
 }
 
-void play_ringtone(ZeroMeshApp* app) {
-    if(app->notify_ringtone == RingtoneNone) return;
+static void play_notification(ZeroMeshApp* app) {
+    NotificationApp* notify = furi_record_open(RECORD_NOTIFICATION);
 
-    if(!furi_hal_speaker_acquire(1000)) return;
+    if(app->notify_vibro && app->notify_led) {
+        notification_message(notify, &seq_vibro_led);
+    } else if(app->notify_vibro) {
+        notification_message(notify, &seq_vibro_short);
+    } else if(app->notify_led) {
+        notification_message(notify, &seq_led_flash);
+    }
 
-    switch(app->notify_ringtone) {
-    case RingtoneShort:
-        furi_hal_speaker_start(800.0f, 0.6f);
-        furi_delay_ms(100);
-        furi_hal_speaker_stop();
-        break;
+    furi_record_close(RECORD_NOTIFICATION);
 
-    case RingtoneDouble:
-        furi_hal_speaker_start(800.0f, 0.6f);
-        furi_delay_ms(80);
-        furi_hal_speaker_stop();
-        furi_delay_ms(60);
-        furi_hal_speaker_start(1000.0f, 0.6f);
-        furi_delay_ms(80);
-        furi_hal_speaker_stop();
-        break;
-
-    case RingtoneTriple:
-        for(int i = 0; i < 3; i++) {
-            furi_hal_speaker_start(800.0f + (float)(i * 200), 0.6f);
-            furi_delay_ms(60);
-            furi_hal_speaker_stop();
-            if(i < 2) furi_delay_ms(40);
-        }
-        break;
+    player_start(app, app->notify_ringtone);
+}
 
-    case RingtoneLong:
-        furi_hal_speaker_start(600.0f, 0.5f);
-        furi_delay_ms(400);
-        furi_hal_speaker_stop();
-        break;
-
-    case RingtoneSOS:
-        for(int i = 0; i < 3; i++) {
-            furi_hal_speaker_start(800.0f, 0.6f);
-            furi_delay_ms(50);
-            furi_hal_speaker_stop();
-            furi_delay_ms(50);
-        }
-        furi_delay_ms(100);
-        for(int i = 0; i < 3; i++) {
-            furi_hal_speaker_start(800.0f, 0.6f);
-            furi_delay_ms(150);
-            furi_hal_speaker_stop();
-            furi_delay_ms(50);
-        }
-        furi_delay_ms(100);
-        for(int i = 0; i < 3; i++) {
-            furi_hal_speaker_start(800.0f, 0.6f);
-            furi_delay_ms(50);
-            furi_hal_speaker_stop();
-            if(i < 2) furi_delay_ms(50);
-        }
-        break;
+static int32_t notify_thread_fn(void* ctx) {
+    ZeroMeshApp* app = (ZeroMeshApp*)ctx;
+    NotifyEvent evt;
 
-    case RingtoneChirp:
-        for(int f = 400; f <= 1200; f += 50) {
-            furi_hal_speaker_start((float)f, 0.5f);
-            furi_delay_ms(15);
+    while(true) {
+        if(furi_message_queue_get(app->notify_queue, &evt, player_timeout(app)) != FuriStatusOk) {
+            player_step(app);
+            continue;
         }
-        furi_hal_speaker_stop();
-        break;
-
-    case RingtoneNokia:
-        play_nokia();
-        break;
-
-    case RingtoneDescend:
-        play_descend();
-        break;
-
-    case RingtoneBounce:
-        play_bounce();
-        break;
 
-    case RingtoneAlert:
-        play_alert();
-        break;
+        if(evt == NotifyEventStop) break;
 
-    case RingtonePulse:
-        play_pulse();
-        break;
-
-    case RingtoneSiren:
-        play_siren();
-        break;
-
-    case RingtoneBeep3:
-        play_beep3();
-        break;
+        if(evt == NotifyEventPreview) {
+            player_start(app, app->notify_ringtone);
+            continue;
+        }
 
-    case RingtoneTrill:
-        play_trill();
-        break;
+        uint32_t now = furi_get_tick();
+        if(app->player_tune ||
+           (app->notify_alerts > 0 && now - app->notify_last_tick < NOTIFY_COALESCE_MS)) {
+            app->notify_coalesced++;
+            continue;
+        }
+        app->notify_alerts++;
+        app->notify_last_tick = now;
+        play_notification(app);
+    }
 
-    case RingtoneMario:
-        play_mario();
-        break;
+    player_stop(app);
+    return 0;
+}
 
-    case RingtoneLevelUp:
-        play_levelup();
-        break;
+static void notify_post(ZeroMeshApp* app, NotifyEvent evt) {
+    if(!app || !app->notify_queue) return;
+    if(furi_message_queue_put(app->notify_queue, &evt, 0) != FuriStatusOk) {
+        app->notify_coalesced++;
+    }
+}
 
-    case RingtoneMetric:
-        play_metric();
-        break;
+void notify_rx_message(ZeroMeshApp* app) {
+    notify_post(app, NotifyEventMessage);
+}
 
-    case RingtoneMinimalist:
-        play_minimalist();
-        break;
+void notify_preview_ringtone(ZeroMeshApp* app) {
+    if(app->notify_ringtone == RingtoneNone) return;
+    notify_post(app, NotifyEventPreview);
+}
 
-    default:
-        break;
-    }
+void notify_start(ZeroMeshApp* app) {
+    ringtone_scan_user(app);
+    if(app->notify_ringtone >= ringtone_count(app)) app->notify_ringtone = RingtoneShort;
 
-    furi_hal_speaker_release();
+    app->notify_queue = furi_message_queue_alloc(NOTIFY_QUEUE_SIZE, sizeof(NotifyEvent));
+    app->notify_thread = furi_thread_alloc_ex("mt_notify", 2048, notify_thread_fn, app);
+    furi_thread_start(app->notify_thread);
 }
 
-void notify_rx_message(ZeroMeshApp* app) {
-    NotificationApp* notify = furi_record_open(RECORD_NOTIFICATION);
+void notify_stop(ZeroMeshApp* app) {
+    if(!app->notify_thread) return;
 
-    if(app->notify_vibro && app->notify_led) {
-        notification_message(notify, &seq_vibro_led);
-    } else if(app->notify_vibro) {
-        notification_message(notify, &seq_vibro_short);
-    } else if(app->notify_led) {
-        notification_message(notify, &seq_led_flash);
-    }
+    NotifyEvent evt = NotifyEventStop;
+    furi_message_queue_reset(app->notify_queue);
+    furi_message_queue_put(app->notify_queue, &evt, FuriWaitForever);
+    furi_thread_join(app->notify_thread);
+    furi_thread_free(app->notify_thread);
+    app->notify_thread = NULL;
 
-    furi_record_close(RECORD_NOTIFICATION);
+    furi_message_queue_free(app->notify_queue);
+    app->notify_queue = NULL;
 
-    if(app->notify_ringtone != RingtoneNone) {
-        play_ringtone(app);
+    for(uint8_t i = 0; i < RINGTONE_COUNT + RINGTONE_USER_MAX; i++) {
+        free(app->ringtone_cache[i]);
+        app->ringtone_cache[i] = NULL;
     }
-}
\ No newline at end of file
+}
@@ -2,7 +2,10 @@
 
 #include "zeromesh_serial.h"
 
-extern const char* ringtone_names[];
+uint8_t ringtone_count(ZeroMeshApp* app);
+const char* ringtone_name(ZeroMeshApp* app, uint8_t idx);
 
-void play_ringtone(ZeroMeshApp* app);
-void notify_rx_message(ZeroMeshApp* app);
\ No newline at end of file
+void notify_start(ZeroMeshApp* app);
+void notify_stop(ZeroMeshApp* app);
+void notify_rx_message(ZeroMeshApp* app);
+void notify_preview_ringtone(ZeroMeshApp* app);
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "zeromesh_ports.h"
+#include "zeromesh_events.h"
+
+static const uint16_t port_hist_limits_us[PORT_HIST_BUCKETS - 1] = {50, 100, 200, 500, 1000};
+
+static uint16_t port_slot(meshtastic_PortNum port) {
+    if((uint32_t)port >= PORT_SLOT_OTHER) return PORT_SLOT_OTHER;
+    return (uint16_t)port;
+}
+
+void port_register(ZeroMeshApp* app, meshtastic_PortNum port, bool needs_payload, PortHandlerFn fn) {
+    if(!app) return;
+    PortHandler* h = &app->port_handlers[port_slot(port)];
+    h->fn = fn;
+    h->needs_payload = needs_payload;
+}
+
+bool port_wants_payload(ZeroMeshApp* app, meshtastic_PortNum port) {
+    const PortHandler* h = &app->port_handlers[port_slot(port)];
+    return h->fn && h->needs_payload;
+}
+
+void port_dispatch(ZeroMeshApp* app, const PacketView* pkt) {
+    uint16_t slot = port_slot(pkt->portnum);
+    PortStats* st = &app->port_stats[slot];
+    st->rx_count++;
+
+    const PortHandler* h = &app->port_handlers[slot];
+    if(!h->fn) {
+        rx_post_log(app, "RX Port: %d", (int)pkt->portnum);
+        return;
+    }
+
+    app->rx_port_current = slot;
+    h->fn(app, pkt);
+    app->rx_port_current = PORT_SLOT_NONE;
+}
+
+void port_account(ZeroMeshApp* app, uint16_t slot, uint32_t us) {
+    if(slot >= PORT_SLOT_COUNT) return;
+    PortStats* st = &app->port_stats[slot];
+    uint8_t bucket = 0;
+    while(bucket < PORT_HIST_BUCKETS - 1 && us >= port_hist_limits_us[bucket]) bucket++;
+    if(st->decode_hist[bucket] < UINT16_MAX) st->decode_hist[bucket]++;
+}
+
+const char* port_name(uint16_t slot) {
+    switch(slot) {
+    case meshtastic_PortNum_TEXT_MESSAGE_APP:
+        return "Text";
+    case meshtastic_PortNum_POSITION_APP:
+        return "Pos";
+    case meshtastic_PortNum_NODEINFO_APP:
+        return "Node";
+    case meshtastic_PortNum_ROUTING_APP:
+        return "Route";
+    case meshtastic_PortNum_ADMIN_APP:
+        return "Admin";
+    case meshtastic_PortNum_WAYPOINT_APP:
+        return "Waypt";
+    case meshtastic_PortNum_STORE_FORWARD_APP:
+        return "S&F";
+    case meshtastic_PortNum_RANGE_TEST_APP:
+        return "Range";
+    case meshtastic_PortNum_TELEMETRY_APP:
+        return "Telem";
+    case meshtastic_PortNum_TRACEROUTE_APP:
+        return "Trace";
+    case meshtastic_PortNum_NEIGHBORINFO_APP:
+        return "Neigh";
+    case meshtastic_PortNum_MAP_REPORT_APP:
+        return "Map";
+    case PORT_SLOT_OTHER:
+        return "Other";
+    default:
+        return NULL;
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "zeromesh_serial.h"
+
+void port_register(ZeroMeshApp* app, meshtastic_PortNum port, bool needs_payload, PortHandlerFn fn);
+bool port_wants_payload(ZeroMeshApp* app, meshtastic_PortNum port);
+void port_dispatch(ZeroMeshApp* app, const PacketView* pkt);
+void port_account(ZeroMeshApp* app, uint16_t slot, uint32_t us);
+const char* port_name(uint16_t slot);
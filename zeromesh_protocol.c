@@ -1,74 +1,15 @@
 #include "zeromesh_protocol.h"
 #include "zeromesh_history.h"
-#include "zeromesh_notify.h"
-#include "zeromesh_roster.h"
-#include "lib/meshtastic_api/meshtastic/telemetry.pb.h"
+#include "zeromesh_ports.h"
+#include "zeromesh_redraw.h"
+#include "zeromesh_tx.h"
+#include "zeromesh_ack.h"
+#include "zeromesh_dedup.h"
+#include "zeromesh_capture.h"
+#include "zeromesh_events.h"
 
 #define TAG "zeromesh_serial"
 
-static void framing_reset(ZeroMeshApp* app) {
-    app->hdr_pos = 0;
-    app->frame_len = 0;
-    app->frame_pos = 0;
-}
-
-static bool framing_feed(ZeroMeshApp* app, uint8_t b) {
-    if(app->hdr_pos < 4) {
-        app->hdr[app->hdr_pos++] = b;
-        if(app->hdr_pos == 1 && app->hdr[0] != ZEROMESH_MAGIC0) {
-            app->rx_bad_magic++;
-            app->hdr_pos = 0;
-        } else if(app->hdr_pos == 2 && app->hdr[1] != ZEROMESH_MAGIC1) {
-            app->rx_bad_magic++;
-            app->hdr_pos = 0;
-        } else if(app->hdr_pos == 4) {
-            app->frame_len = ((uint16_t)app->hdr[2] << 8) | (uint16_t)app->hdr[3];
-            app->frame_pos = 0;
-            if(app->frame_len == 0 || app->frame_len > MAX_FRAME_SIZE) {
-                app->rx_bad_len++;
-                log_line(app, "Bad Len: %u", app->frame_len);
-                framing_reset(app);
-            }
-        }
-        return false;
-    }
-    if(app->frame_pos < app->frame_len) {
-        app->frame_buf[app->frame_pos++] = b;
-        if(app->frame_pos == app->frame_len) return true;
-    } else {
-        app->rx_bad_len++;
-        framing_reset(app);
-    }
-    return false;
-}
-
-typedef struct {
-    uint8_t buf[PAYLOAD_CAPTURE_MAX];
-    size_t len;
-    bool truncated;
-} PayloadCapture;
-
-static bool payload_decode_cb(pb_istream_t* stream, const pb_field_t* field, void** arg) {
-    (void)field;
-    PayloadCapture* cap = (PayloadCapture*)(*arg);
-    if(!cap) return false;
-    size_t n = stream->bytes_left;
-    if(n > PAYLOAD_CAPTURE_MAX) {
-        n = PAYLOAD_CAPTURE_MAX;
-        cap->truncated = true;
-    }
-    cap->len = n;
-    if(n > 0) {
-        if(!pb_read(stream, cap->buf, n)) return false;
-    }
-    while(stream->bytes_left > 0) {
-        uint8_t tmp[16];
-        size_t chunk = (stream->bytes_left > sizeof(tmp)) ? sizeof(tmp) : stream->bytes_left;
-        if(!pb_read(stream, tmp, chunk)) return false;
-    }
-    return true;
-}
-
 typedef struct {
     const uint8_t* buf;
     size_t len;
@@ -81,131 +22,138 @@ static bool payload_encode_cb(pb_ostream_t* stream, const pb_field_t* field, voi
     return pb_encode_string(stream, ps->buf, ps->len);
 }
 
+static bool wants_payload(void* ctx, meshtastic_PortNum port) {
+    return port_wants_payload((ZeroMeshApp*)ctx, port);
+}
+
+static void handle_text_message(ZeroMeshApp* app, const PacketView* p) {
+    if(p->payload_len == 0) return;
+    rx_post_message(app, p);
+}
+
+static void handle_nodeinfo(ZeroMeshApp* app, const PacketView* p) {
+    if(p->payload_len == 0) return;
+    NodeInfoView info = {0};
+    info.num = p->from;
+    if(!walk_user_payload(p->payload, p->payload_len, &info)) return;
+    rx_post_nodeinfo(app, RxEventUser, &info);
+}
+
+static void handle_routing(ZeroMeshApp* app, const PacketView* p) {
+    if(p->request_id == 0) return;
+    uint32_t error;
+    if(!walk_routing(p->payload, p->payload_len, &error)) return;
+    rx_post_ack(app, p->request_id, p->from, error);
+}
+
+static void handle_telemetry(ZeroMeshApp* app, const PacketView* p) {
+    if(p->payload_len == 0) return;
+    meshtastic_Telemetry* tel = &app->decode_scratch.telemetry;
+    *tel = (meshtastic_Telemetry)meshtastic_Telemetry_init_default;
+    pb_istream_t is_tel = pb_istream_from_buffer(p->payload, p->payload_len);
+    if(pb_decode(&is_tel, meshtastic_Telemetry_fields, tel)) {
+        if(tel->which_variant == meshtastic_Telemetry_device_metrics_tag) {
+            rx_post_telemetry(app, p->from, tel->variant.device_metrics.battery_level, tel->variant.device_metrics.voltage);
+            rx_post_log(app, "RX: Telemetry from %08lX", (unsigned long)p->from);
+        }
+    }
+}
+
+static void handle_packet(ZeroMeshApp* app, const PacketView* p) {
+    rx_post_node(app, p->from, p->to, p->id, p->rx_snr, p->rx_rssi);
+    if(!p->has_decoded) return;
+    port_dispatch(app, p);
+}
+
 static void decode_fromradio(ZeroMeshApp* app, const uint8_t* frame, size_t len) {
-    PayloadCapture cap = {0};
-    meshtastic_FromRadio from = meshtastic_FromRadio_init_default;
-    pb_istream_t is1 = pb_istream_from_buffer(frame, len);
-    bool ok1 = pb_decode(&is1, meshtastic_FromRadio_fields, &from);
-    if(!ok1) {
+    FromRadioView view;
+    if(!walk_fromradio(frame, len, &view)) {
         app->rx_decode_fail++;
-        log_line(app, "Decode Fail!");
+        rx_post_log(app, "Decode Fail!");
         return;
     }
-    app->rx_frames_ok++;
-    if(from.which_payload_variant == meshtastic_FromRadio_packet_tag) {
-        const meshtastic_MeshPacket* p = &from.payload_variant.packet;
-        bool is_echo = false;
-        for(uint8_t i = 0; i < 8; i++) {
-            if(app->sent_msg_ids[i] == p->id && p->id != 0) {
-                is_echo = true;
-                break;
+
+    if(view.variant == meshtastic_FromRadio_packet_tag) {
+        PacketView pkt = {0};
+        const uint8_t* data = NULL;
+        size_t data_len = 0;
+        if(!walk_packet(view.body, view.body_len, &pkt, &data, &data_len)) {
+            app->rx_decode_fail++;
+            rx_post_log(app, "Decode Fail!");
+            return;
+        }
+        if(dedup_seen(app, pkt.from, pkt.id)) {
+            app->rx_frames_ok++;
+            return;
+        }
+        if(pkt.has_decoded) {
+            if(!walk_data(data, data_len, &pkt, wants_payload, app)) {
+                app->rx_decode_fail++;
+                rx_post_log(app, "Decode Fail!");
+                return;
             }
         }
-        if(is_echo) return;
-        uint32_t sender_id = p->from;
-        app->last_rx_from = p->from;
-        app->last_rx_to = p->to;
-        app->last_rx_id = p->id;
-        if(p->rx_rssi != 0) {
-            app->last_rx_rssi = p->rx_rssi;
-            app->has_rx_signal_data = true;
+        if(pkt.channel >= MAX_CHANNELS) pkt.channel = 0;
+        app->rx_frames_ok++;
+        handle_packet(app, &pkt);
+    } else if(view.variant == meshtastic_FromRadio_my_info_tag) {
+        meshtastic_MyNodeInfo* info = &app->decode_scratch.my_info;
+        *info = (meshtastic_MyNodeInfo)meshtastic_MyNodeInfo_init_default;
+        pb_istream_t is = pb_istream_from_buffer(view.body, view.body_len);
+        if(!pb_decode(&is, meshtastic_MyNodeInfo_fields, info)) {
+            app->rx_decode_fail++;
+            rx_post_log(app, "Decode Fail!");
+            return;
         }
-        if(p->rx_snr != 0) {
-            app->last_rx_snr = p->rx_snr;
-            app->has_rx_signal_data = true;
+        app->rx_frames_ok++;
+        app->rx_my_node_num = info->my_node_num;
+        rx_post_my_info(app, info->my_node_num);
+    } else if(view.variant == meshtastic_FromRadio_node_info_tag) {
+        NodeInfoView info = {0};
+        if(!walk_nodeinfo(view.body, view.body_len, &info)) {
+            app->rx_decode_fail++;
+            rx_post_log(app, "Decode Fail!");
+            return;
         }
-        roster_add_node(app, sender_id, p->rx_snr, p->rx_rssi);
-        if(p->which_payload_variant == meshtastic_MeshPacket_decoded_tag) {
-            const meshtastic_Data* d = &p->payload_variant.decoded;
-            if(d->portnum == meshtastic_PortNum_TEXT_MESSAGE_APP || d->portnum == meshtastic_PortNum_TELEMETRY_APP) {
-                pb_istream_t walk = pb_istream_from_buffer(frame, len);
-                bool found_payload = false;
-                while(walk.bytes_left > 0) {
-                    pb_wire_type_t wire_type;
-                    uint32_t tag;
-                    bool eof;
-                    if(!pb_decode_tag(&walk, &wire_type, &tag, &eof)) break;
-                    if(eof) break;
-                    if(tag == meshtastic_FromRadio_packet_tag && wire_type == PB_WT_STRING) {
-                        uint32_t pkt_len;
-                        if(!pb_decode_varint32(&walk, &pkt_len)) break;
-                        if(pkt_len > walk.bytes_left) break;
-                        pb_istream_t pkt_stream = pb_istream_from_buffer(walk.state, pkt_len);
-                        while(pkt_stream.bytes_left > 0) {
-                            pb_wire_type_t pkt_wt;
-                            uint32_t pkt_tag;
-                            bool pkt_eof;
-                            if(!pb_decode_tag(&pkt_stream, &pkt_wt, &pkt_tag, &pkt_eof)) break;
-                            if(pkt_eof) break;
-                            if(pkt_tag == meshtastic_MeshPacket_decoded_tag && pkt_wt == PB_WT_STRING) {
-                                uint32_t data_len;
-                                if(!pb_decode_varint32(&pkt_stream, &data_len)) break;
-                                if(data_len > pkt_stream.bytes_left) break;
-                                meshtastic_Data data_msg = meshtastic_Data_init_default;
-                                data_msg.payload.funcs.decode = payload_decode_cb;
-                                data_msg.payload.arg = &cap;
-                                pb_istream_t data_stream = pb_istream_from_buffer(pkt_stream.state, data_len);
-                                if(pb_decode(&data_stream, meshtastic_Data_fields, &data_msg)) found_payload = true;
-                                break;
-                            } else {
-                                if(!pb_skip_field(&pkt_stream, pkt_wt)) break;
-                            }
-                        }
-                        break;
-                    } else {
-                        if(!pb_skip_field(&walk, wire_type)) break;
-                    }
-                }
-                if(found_payload && cap.len > 0) {
-                    if(d->portnum == meshtastic_PortNum_TEXT_MESSAGE_APP) {
-                        size_t copy_len = cap.len;
-                        if(copy_len >= sizeof(app->last_rx_text)) copy_len = sizeof(app->last_rx_text) - 1;
-                        memcpy(app->last_rx_text, cap.buf, copy_len);
-                        app->last_rx_text[copy_len] = '\0';
-                        history_add(app, app->last_rx_text, sender_id, p->to, false);
-                        if(p->to == app->my_node_num) {
-                            for(uint8_t i = 0; i < app->roster.count; i++) {
-                                if(app->roster.nodes[i].node_id == sender_id) {
-                                    app->roster.nodes[i].has_new_dm = true;
-                                    break;
-                                }
-                            }
-                        }
-                        log_line(app, "Msg: %s", app->last_rx_text);
-                        set_status(app, "New message");
-                        notify_rx_message(app);
-                        view_port_update(app->vp);
-                    } else if(d->portnum == meshtastic_PortNum_TELEMETRY_APP) {
-                        meshtastic_Telemetry tel = meshtastic_Telemetry_init_default;
-                        pb_istream_t is_tel = pb_istream_from_buffer(cap.buf, cap.len);
-                        if(pb_decode(&is_tel, meshtastic_Telemetry_fields, &tel)) {
-                            if(tel.which_variant == meshtastic_Telemetry_device_metrics_tag) {
-                                roster_update_telemetry(app, sender_id, tel.variant.device_metrics.battery_level, tel.variant.device_metrics.voltage);
-                                log_line(app, "RX: Telemetry from %08lX", (unsigned long)sender_id);
-                            }
-                        }
-                    }
-                }
-            } else {
-                log_line(app, "RX Port: %d", (int)d->portnum);
-            }
+        app->rx_frames_ok++;
+        if(info.num != 0) {
+            rx_post_nodeinfo(app, RxEventNodeInfo, &info);
+            if(info.num != app->rx_my_node_num) app->rx_config_nodes++;
+        }
+    } else if(view.variant == meshtastic_FromRadio_channel_tag) {
+        uint32_t index;
+        uint32_t role;
+        if(!walk_channel(view.body, view.body_len, &index, &role)) {
+            app->rx_decode_fail++;
+            rx_post_log(app, "Decode Fail!");
+            return;
         }
-    } else if(from.which_payload_variant == meshtastic_FromRadio_my_info_tag) {
-        const meshtastic_MyNodeInfo* info = &from.payload_variant.my_info;
-        app->my_node_num = info->my_node_num;
-        log_line(app, "My ID: %08lX", (unsigned long)app->my_node_num);
-        set_status(app, "Ready");
+        app->rx_frames_ok++;
+        if(role != meshtastic_Channel_Role_DISABLED && index < MAX_CHANNELS && index + 1 > app->rx_config_channels) {
+            app->rx_config_channels = index + 1;
+        }
+    } else if(view.variant == meshtastic_FromRadio_queueStatus_tag) {
+        meshtastic_QueueStatus qs;
+        if(!walk_queue_status(view.body, view.body_len, &qs)) {
+            app->rx_decode_fail++;
+            rx_post_log(app, "Decode Fail!");
+            return;
+        }
+        app->rx_frames_ok++;
+        tx_queue_status(app, qs.res, qs.free, qs.maxlen, qs.mesh_packet_id);
+    } else if(view.variant == meshtastic_FromRadio_config_complete_id_tag) {
+        app->rx_frames_ok++;
+        rx_post_config_done(app, view.value, app->rx_config_nodes, app->rx_config_channels);
+        app->rx_config_nodes = 0;
+        app->rx_config_channels = 0;
+    } else if(view.variant == meshtastic_FromRadio_rebooted_tag) {
+        app->rx_frames_ok++;
+        rx_post_rebooted(app);
+    } else {
+        app->rx_frames_ok++;
     }
 }
 
-static void send_frame(ZeroMeshApp* app, const uint8_t* payload, size_t len) {
-    if(!app || !app->serial) return;
-    uint8_t hdr[4] = {ZEROMESH_MAGIC0, ZEROMESH_MAGIC1, (uint8_t)((len >> 8) & 0xFF), (uint8_t)(len & 0xFF)};
-    furi_hal_serial_tx(app->serial, hdr, sizeof(hdr));
-    furi_hal_serial_tx(app->serial, payload, len);
-    app->tx_frames++;
-}
-
 void send_text_message(ZeroMeshApp* app, const char* text, uint32_t to_node) {
     if(!app || !app->serial || !text) return;
     size_t text_len = strlen(text);
@@ -214,11 +162,11 @@ void send_text_message(ZeroMeshApp* app, const char* text, uint32_t to_node) {
     to.which_payload_variant = meshtastic_ToRadio_packet_tag;
     meshtastic_MeshPacket* p = &to.payload_variant.packet;
     p->to = to_node;
+    p->channel = (to_node == 0xFFFFFFFF) ? app->current_channel : 0;
     p->id = (uint32_t)furi_hal_random_get();
     p->hop_limit = 3;
     p->want_ack = true;
-    app->sent_msg_ids[app->sent_msg_head] = p->id;
-    app->sent_msg_head = (app->sent_msg_head + 1) % 8;
+    dedup_note_tx(app, p->id);
     p->which_payload_variant = meshtastic_MeshPacket_decoded_tag;
     meshtastic_Data* d = &p->payload_variant.decoded;
     d->portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
@@ -226,16 +174,14 @@ void send_text_message(ZeroMeshApp* app, const char* text, uint32_t to_node) {
     PayloadSend ps = {.buf = (const uint8_t*)text, .len = text_len};
     d->payload.funcs.encode = payload_encode_cb;
     d->payload.arg = &ps;
-    uint8_t buf[MAX_FRAME_SIZE];
-    pb_ostream_t os = pb_ostream_from_buffer(buf, sizeof(buf));
-    if(!pb_encode(&os, meshtastic_ToRadio_fields, &to)) {
-        app->tx_encode_fail++;
-        log_line(app, "TX Encode Fail");
+    TxResult res = tx_encode(app, meshtastic_ToRadio_fields, &to, p->id);
+    if(res != TxOk) {
+        log_line(app, res == TxEncodeFail ? "TX Encode Fail" : "TX queue full");
         set_status(app, "Send failed");
         return;
     }
-    send_frame(app, buf, os.bytes_written);
-    history_add(app, text, app->my_node_num, to_node, true);
+    uint32_t seq = history_add(app, text, app->my_node_num, to_node, p->channel, true);
+    ack_track(app, p->id, to_node, seq);
     log_line(app, "TX: %s", text);
     set_status(app, "Sent!");
 }
@@ -244,26 +190,67 @@ void request_info(ZeroMeshApp* app) {
     if(!app || !app->serial) return;
     meshtastic_ToRadio to = meshtastic_ToRadio_init_default;
     to.which_payload_variant = meshtastic_ToRadio_want_config_id_tag;
-    to.payload_variant.want_config_id = 12345;
-    uint8_t buf[MAX_FRAME_SIZE];
-    pb_ostream_t os = pb_ostream_from_buffer(buf, sizeof(buf));
-    if(pb_encode(&os, meshtastic_ToRadio_fields, &to)) {
-        send_frame(app, buf, os.bytes_written);
+    to.payload_variant.want_config_id = CONFIG_NONCE;
+    if(tx_encode(app, meshtastic_ToRadio_fields, &to, 0) == TxOk) {
+        app->config_nonce = CONFIG_NONCE;
+        app->config_complete = false;
         log_line(app, "Info Request Sent");
     }
 }
 
+void send_heartbeat(ZeroMeshApp* app) {
+    if(!app || !app->serial) return;
+    meshtastic_ToRadio to = meshtastic_ToRadio_init_default;
+    to.which_payload_variant = meshtastic_ToRadio_heartbeat_tag;
+    if(tx_encode(app, meshtastic_ToRadio_fields, &to, 0) == TxOk) app->link_heartbeats++;
+}
+
+static void rx_stack_sample(ZeroMeshApp* app) {
+    uint32_t free_bytes = furi_thread_get_stack_space(furi_thread_get_current_id());
+    if(free_bytes < app->rx_stack_free_min) app->rx_stack_free_min = free_bytes;
+}
+
+void protocol_init(ZeroMeshApp* app) {
+    port_register(app, meshtastic_PortNum_TEXT_MESSAGE_APP, true, handle_text_message);
+    port_register(app, meshtastic_PortNum_TELEMETRY_APP, true, handle_telemetry);
+    port_register(app, meshtastic_PortNum_NODEINFO_APP, true, handle_nodeinfo);
+    port_register(app, meshtastic_PortNum_ROUTING_APP, true, handle_routing);
+}
+
 int32_t rx_thread_fn(void* ctx) {
     ZeroMeshApp* app = (ZeroMeshApp*)ctx;
-    framing_reset(app);
-    uint8_t b;
+    framing_init(&app->framing);
+    app->rx_stack_free_min = RX_THREAD_STACK_SIZE;
+    app->rx_port_current = PORT_SLOT_NONE;
+    bool seen = false;
     while(!app->stop_thread) {
-        if(furi_stream_buffer_receive(app->rx_stream, &b, 1, 100) > 0) {
-            if(framing_feed(app, b)) {
-                decode_fromradio(app, app->frame_buf, app->frame_len);
-                framing_reset(app);
+        size_t pending = furi_stream_buffer_bytes_available(app->rx_stream);
+        if(pending > app->rx_stream_hwm) app->rx_stream_hwm = pending;
+        size_t n = furi_stream_buffer_receive(app->rx_stream, app->rx_span, sizeof(app->rx_span), 100);
+        if(n > 0) {
+            redraw_mark(app, seen ? REDRAW_PAGE(PAGE_STATS) : REDRAW_ALL);
+            seen = true;
+            capture_tee(app, app->rx_span, n);
+        }
+        size_t off = 0;
+        while(off < n || app->framing.replay_len > 0) {
+            const uint8_t* frame;
+            uint32_t bad_len = app->framing.bad_len;
+            off += framing_scan(&app->framing, app->rx_span + off, n - off, &frame);
+            if(app->framing.bad_len != bad_len) rx_post_log(app, "Bad Len: %u", app->framing.last_bad_len);
+            if(frame) {
+                uint32_t start = DWT->CYCCNT;
+                uint32_t ok = app->rx_frames_ok;
+                decode_fromradio(app, frame, app->framing.frame_len);
+                uint32_t cycles = DWT->CYCCNT - start;
+                if(app->rx_frames_ok != ok) app->link_rx_tick = furi_get_tick();
+                if(cycles / furi_hal_cortex_instructions_per_microsecond() > RX_STALL_MS * 1000) app->rx_stalls++;
+                rx_frame_hook(app, app->framing.frame_len, cycles);
+                framing_reset(&app->framing);
+                rx_stack_sample(app);
             }
         }
+        rx_merge_flush(app);
     }
     return 0;
 }
@@ -4,4 +4,13 @@
 
 void send_text_message(ZeroMeshApp* app, const char* text, uint32_t to_node);
 void request_info(ZeroMeshApp* app);
-int32_t rx_thread_fn(void* ctx);
\ No newline at end of file
+void send_heartbeat(ZeroMeshApp* app);
+void protocol_init(ZeroMeshApp* app);
+int32_t rx_thread_fn(void* ctx);
+
+#ifdef ZEROMESH_HOST
+/* Called after every decoded frame; defined by the host benchmark in bench/ */
+void rx_frame_hook(ZeroMeshApp* app, size_t len, uint32_t cycles);
+#else
+#define rx_frame_hook(app, len, cycles)
+#endif
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "zeromesh_redraw.h"
+
+static const uint32_t redraw_frame_delays[] = {1000, 500, 333, 250, 200, 166, 142, 125, 111, 100};
+
+void redraw_init(ZeroMeshApp* app) {
+    app->redraw_queue = furi_message_queue_alloc(REDRAW_QUEUE_SIZE, sizeof(uint8_t));
+    app->redraw_dirty = REDRAW_ALL;
+    app->redraw_window_start = furi_get_tick();
+}
+
+void redraw_free(ZeroMeshApp* app) {
+    furi_message_queue_free(app->redraw_queue);
+    app->redraw_queue = NULL;
+}
+
+void redraw_wake(ZeroMeshApp* app) {
+    if(!app->redraw_queue) return;
+    uint8_t evt = 0;
+    furi_message_queue_put(app->redraw_queue, &evt, 0);
+}
+
+void redraw_mark(ZeroMeshApp* app, uint32_t mask) {
+    uint32_t prev = __atomic_fetch_or(&app->redraw_dirty, mask, __ATOMIC_RELAXED);
+    app->redraw_window_busy = true;
+    if((prev & mask) != mask) redraw_wake(app);
+}
+
+void redraw_frame(ZeroMeshApp* app) {
+    app->redraw_count++;
+    app->redraw_animating = false;
+}
+
+static void redraw_account(ZeroMeshApp* app, uint32_t now) {
+    if(now - app->redraw_window_start < 60000) return;
+    uint32_t count = app->redraw_count - app->redraw_window_base;
+    if(app->redraw_window_busy) {
+        app->redraws_busy_min = count;
+    } else {
+        app->redraws_idle_min = count;
+    }
+    app->redraw_window_start = now;
+    app->redraw_window_base = app->redraw_count;
+    app->redraw_window_busy = false;
+}
+
+void redraw_wait(ZeroMeshApp* app) {
+    uint32_t now = furi_get_tick();
+    uint32_t since = now - app->redraw_last_tick;
+    uint32_t visible = REDRAW_PAGE(app->ui_mode);
+    uint32_t dirty = __atomic_exchange_n(&app->redraw_dirty, 0, __ATOMIC_RELAXED) & visible;
+    uint32_t timeout = REDRAW_IDLE_MS;
+    bool due = false;
+
+    redraw_account(app, now);
+
+    if(dirty) {
+        if(since >= REDRAW_MIN_MS) {
+            due = true;
+        } else {
+            __atomic_fetch_or(&app->redraw_dirty, dirty, __ATOMIC_RELAXED);
+            timeout = REDRAW_MIN_MS - since;
+        }
+    }
+
+    if(!due && app->redraw_animating) {
+        uint32_t frame_delay = redraw_frame_delays[app->scroll_framerate - 1];
+        if(since >= frame_delay) {
+            due = true;
+        } else if(frame_delay - since < timeout) {
+            timeout = frame_delay - since;
+        }
+    }
+
+    if(!due && app->ui_mode == PAGE_ROSTER && since >= REDRAW_IDLE_MS) due = true;
+
+    if(due) {
+        app->redraw_last_tick = now;
+        view_port_update(app->vp);
+        return;
+    }
+
+    uint8_t evt;
+    furi_message_queue_get(app->redraw_queue, &evt, timeout);
+}
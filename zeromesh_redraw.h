@@ -0,0 +1,10 @@
+#pragma once
+
+#include "zeromesh_serial.h"
+
+void redraw_init(ZeroMeshApp* app);
+void redraw_free(ZeroMeshApp* app);
+void redraw_mark(ZeroMeshApp* app, uint32_t mask);
+void redraw_wake(ZeroMeshApp* app);
+void redraw_frame(ZeroMeshApp* app);
+void redraw_wait(ZeroMeshApp* app);
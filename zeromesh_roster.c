@@ -1,112 +1,159 @@
 #include "zeromesh_roster.h"
 #include "zeromesh_gui.h"
+#include "zeromesh_history.h"
+#include "zeromesh_layout.h"
+#include "zeromesh_redraw.h"
+#include "zeromesh_names.h"
 
 #include <furi.h>
 #include <gui/canvas.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-static int calculate_wrapped_lines(Canvas* canvas, const char* text, int max_w) {
-    if(!text || !text[0]) return 1;
-    
-    char line_buf[64];
-    size_t text_len = strlen(text);
-    size_t pos = 0;
-    int lines = 0;
-    
-    while(pos < text_len) {
-        size_t line_len = 0;
-        size_t last_space = 0;
-        
-        while(pos + line_len < text_len) {
-            line_buf[line_len] = text[pos + line_len];
-            line_buf[line_len + 1] = '\0';
-            
-            if(text[pos + line_len] == ' ') {
-                last_space = line_len;
-            }
-            
-            if(canvas_string_width(canvas, line_buf) > max_w) {
-                if(last_space > 0) {
-                    line_len = last_space;
-                } else {
-                    if(line_len > 0) line_len--;
-                }
-                break;
-            }
-            
-            line_len++;
-            if(line_len >= sizeof(line_buf) - 1) break;
-        }
-        
-        if(line_len == 0 && pos < text_len) {
-            line_len = 1;
+void roster_init(ZeroMeshApp* app) {
+    NodeRoster* r = &app->roster;
+    size_t budget = memmgr_get_free_heap() / ROSTER_HEAP_SHARE;
+    size_t per_node = sizeof(NodeEntry) + 2 * sizeof(uint16_t) + sizeof(NodeName) + NAME_POOL_PER_NODE;
+    size_t capacity = budget / per_node;
+    if(capacity > ROSTER_MAX_NODES) capacity = ROSTER_MAX_NODES;
+    if(capacity < ROSTER_MIN_NODES) capacity = ROSTER_MIN_NODES;
+
+    size_t hash_size = 1;
+    while(hash_size < capacity * 2) hash_size <<= 1;
+
+    r->nodes = malloc(capacity * sizeof(NodeEntry));
+    r->hash = malloc(hash_size * sizeof(uint16_t));
+    memset(r->hash, 0xFF, hash_size * sizeof(uint16_t));
+    r->capacity = capacity;
+    r->hash_mask = hash_size - 1;
+    r->count = 0;
+    r->lru_head = ROSTER_SLOT_NONE;
+    r->lru_tail = ROSTER_SLOT_NONE;
+    names_init(app, r->capacity);
+
+    if(r->capacity < ROSTER_TARGET_NODES) {
+        FURI_LOG_W("zeromesh_serial", "roster_init: %u nodes, heap too low for %u", r->capacity, ROSTER_TARGET_NODES);
+    } else {
+        FURI_LOG_I("zeromesh_serial", "roster_init: %u nodes", r->capacity);
+    }
+}
+
+void roster_free(ZeroMeshApp* app) {
+    names_free(app);
+    free(app->roster.nodes);
+    free(app->roster.hash);
+    app->roster.nodes = NULL;
+    app->roster.hash = NULL;
+}
+
+static uint16_t roster_bucket(const NodeRoster* r, uint32_t node_id) {
+    return (uint16_t)((node_id * 2654435761UL) >> 16) & r->hash_mask;
+}
+
+static uint16_t roster_find(NodeRoster* r, uint32_t node_id) {
+    r->lookups++;
+    for(uint16_t b = roster_bucket(r, node_id);; b = (b + 1) & r->hash_mask) {
+        uint16_t idx = r->hash[b];
+        if(idx == ROSTER_SLOT_NONE) return ROSTER_SLOT_NONE;
+        if(r->nodes[idx].node_id == node_id) return idx;
+    }
+}
+
+static void roster_hash_insert(NodeRoster* r, uint16_t idx) {
+    uint16_t b = roster_bucket(r, r->nodes[idx].node_id);
+    while(r->hash[b] != ROSTER_SLOT_NONE) b = (b + 1) & r->hash_mask;
+    r->hash[b] = idx;
+}
+
+static void roster_hash_remove(NodeRoster* r, uint16_t idx) {
+    uint16_t b = roster_bucket(r, r->nodes[idx].node_id);
+    while(r->hash[b] != idx) b = (b + 1) & r->hash_mask;
+
+    uint16_t hole = b;
+    for(b = (b + 1) & r->hash_mask; r->hash[b] != ROSTER_SLOT_NONE; b = (b + 1) & r->hash_mask) {
+        uint16_t home = roster_bucket(r, r->nodes[r->hash[b]].node_id);
+        if(((b - home) & r->hash_mask) >= ((b - hole) & r->hash_mask)) {
+            r->hash[hole] = r->hash[b];
+            hole = b;
         }
-        
-        pos += line_len;
-        while(pos < text_len && text[pos] == ' ') pos++;
-        lines++;
     }
-    
-    return lines > 0 ? lines : 1;
+    r->hash[hole] = ROSTER_SLOT_NONE;
 }
 
-static void draw_wrapped_text_in_bubble(
-    Canvas* canvas,
-    int x,
-    int y,
-    int max_w,
-    const char* text,
-    Color text_col) {
-    if(!text || !text[0]) return;
-    
-    canvas_set_color(canvas, text_col);
-    
-    char line_buf[64];
-    size_t text_len = strlen(text);
-    size_t pos = 0;
-    int current_y = y;
-    
-    while(pos < text_len && current_y < 64) {
-        size_t line_len = 0;
-        size_t last_space = 0;
-        
-        while(pos + line_len < text_len) {
-            line_buf[line_len] = text[pos + line_len];
-            line_buf[line_len + 1] = '\0';
-            
-            if(text[pos + line_len] == ' ') {
-                last_space = line_len;
-            }
-            
-            if(canvas_string_width(canvas, line_buf) > max_w) {
-                if(last_space > 0) {
-                    line_len = last_space;
-                    line_buf[line_len] = '\0';
-                } else {
-                    if(line_len > 0) line_len--;
-                    line_buf[line_len] = '\0';
-                }
-                break;
+static void roster_lru_unlink(NodeRoster* r, uint16_t idx) {
+    NodeEntry* n = &r->nodes[idx];
+    if(n->lru_prev != ROSTER_SLOT_NONE) {
+        r->nodes[n->lru_prev].lru_next = n->lru_next;
+    } else {
+        r->lru_head = n->lru_next;
+    }
+    if(n->lru_next != ROSTER_SLOT_NONE) {
+        r->nodes[n->lru_next].lru_prev = n->lru_prev;
+    } else {
+        r->lru_tail = n->lru_prev;
+    }
+}
+
+static void roster_lru_push(NodeRoster* r, uint16_t idx) {
+    NodeEntry* n = &r->nodes[idx];
+    n->lru_prev = ROSTER_SLOT_NONE;
+    n->lru_next = r->lru_head;
+    if(r->lru_head != ROSTER_SLOT_NONE) r->nodes[r->lru_head].lru_prev = idx;
+    r->lru_head = idx;
+    if(r->lru_tail == ROSTER_SLOT_NONE) r->lru_tail = idx;
+}
+
+uint16_t roster_lookup(ZeroMeshApp* app, uint32_t node_id) {
+    if(!app->roster.nodes) return ROSTER_SLOT_NONE;
+    return roster_find(&app->roster, node_id);
+}
+
+/* Slot of the selected node, falling back to the first slot when nothing
+ * is selected yet. Caller holds app->lock. */
+static uint16_t roster_selected(ZeroMeshApp* app) {
+    NodeRoster* r = &app->roster;
+    uint16_t idx = r->selected_id ? roster_find(r, r->selected_id) : ROSTER_SLOT_NONE;
+    if(idx == ROSTER_SLOT_NONE) {
+        idx = 0;
+        r->selected_id = r->nodes[0].node_id;
+    }
+    return idx;
+}
+
+static uint16_t roster_touch(ZeroMeshApp* app, uint32_t node_id) {
+    NodeRoster* r = &app->roster;
+    uint16_t target_idx = roster_find(r, node_id);
+
+    if(target_idx == ROSTER_SLOT_NONE) {
+        if(r->count < r->capacity) {
+            target_idx = r->count;
+            r->count++;
+        } else {
+            /* The selected node stays put so an open chat keeps its peer */
+            target_idx = r->lru_tail;
+            if(r->nodes[target_idx].node_id == r->selected_id && r->nodes[target_idx].lru_prev != ROSTER_SLOT_NONE) {
+                target_idx = r->nodes[target_idx].lru_prev;
             }
-            
-            line_len++;
-            if(line_len >= sizeof(line_buf) - 1) break;
-        }
-        
-        if(line_len == 0 && pos < text_len) {
-            line_buf[0] = text[pos];
-            line_buf[1] = '\0';
-            line_len = 1;
+            roster_lru_unlink(r, target_idx);
+            roster_hash_remove(r, target_idx);
+            r->evictions++;
         }
-        
-        canvas_draw_str(canvas, x, current_y, line_buf);
-        pos += line_len;
-        
-        while(pos < text_len && text[pos] == ' ') pos++;
-        
-        current_y += 9;
+        memset(&r->nodes[target_idx], 0, sizeof(NodeEntry));
+        r->nodes[target_idx].node_id = node_id;
+        roster_hash_insert(r, target_idx);
+        names_reset(app, target_idx, node_id);
+    } else {
+        roster_lru_unlink(r, target_idx);
     }
+    roster_lru_push(r, target_idx);
+    return target_idx;
+}
+
+static void roster_apply_user(ZeroMeshApp* app, uint16_t idx, uint32_t node_id, const NodeInfoView* info) {
+    if(info->short_name_len == 0 && info->long_name_len == 0) return;
+    names_set(
+        app, idx, node_id, info->short_name, info->short_name_len, info->long_name, info->long_name_len);
 }
 
 void roster_add_node(ZeroMeshApp* app, uint32_t node_id, int8_t snr, int16_t rssi) {
@@ -114,72 +161,112 @@ void roster_add_node(ZeroMeshApp* app, uint32_t node_id, int8_t snr, int16_t rss
 
     furi_mutex_acquire(app->lock, FuriWaitForever);
 
-    uint8_t target_idx = 255;
-    uint32_t oldest_time = 0xFFFFFFFF;
-    uint8_t oldest_idx = 0;
+    NodeEntry* node = &app->roster.nodes[roster_touch(app, node_id)];
+    node->last_seen = furi_get_tick() / 1000;
+    node->last_snr = snr;
+    node->last_rssi = rssi;
+    redraw_mark(app, REDRAW_PAGE(PAGE_ROSTER));
 
-    for(uint8_t i = 0; i < app->roster.count; i++) {
-        if(app->roster.nodes[i].node_id == node_id) {
-            target_idx = i;
-            break;
-        }
-        if(app->roster.nodes[i].last_seen < oldest_time) {
-            oldest_time = app->roster.nodes[i].last_seen;
-            oldest_idx = i;
-        }
+    furi_mutex_release(app->lock);
+}
+
+void roster_ingest_node(ZeroMeshApp* app, const NodeInfoView* info) {
+    if(!app || info->num == 0 || info->num == 0xFFFFFFFF) return;
+
+    uint32_t now = furi_get_tick() / 1000;
+    uint32_t rtc_now = furi_hal_rtc_get_timestamp();
+    uint32_t age = (info->last_heard && rtc_now > info->last_heard) ? rtc_now - info->last_heard : 0;
+
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+
+    if(info->num == app->my_node_num) {
+        roster_apply_user(app, app->names.self, info->num, info);
+        furi_mutex_release(app->lock);
+        return;
     }
 
-    if(target_idx == 255) {
-        if(app->roster.count < ROSTER_MAX_NODES) {
-            target_idx = app->roster.count;
-            app->roster.count++;
-        } else {
-            target_idx = oldest_idx;
-        }
-        app->roster.nodes[target_idx].node_id = node_id;
-        app->roster.nodes[target_idx].has_telemetry = false;
-        app->roster.nodes[target_idx].has_new_dm = false;
+    uint16_t idx = roster_touch(app, info->num);
+    NodeEntry* node = &app->roster.nodes[idx];
+    node->last_seen = (age < now) ? now - age : 0;
+    node->last_snr = (int8_t)info->snr;
+    node->hw_model = info->hw_model;
+    roster_apply_user(app, idx, info->num, info);
+    if(info->has_metrics) {
+        node->battery_level = info->battery_level;
+        node->voltage = info->voltage;
+        node->has_telemetry = true;
     }
+    redraw_mark(app, REDRAW_PAGE(PAGE_ROSTER));
 
-    app->roster.nodes[target_idx].last_seen = furi_get_tick() / 1000;
-    app->roster.nodes[target_idx].last_snr = snr;
-    app->roster.nodes[target_idx].last_rssi = rssi;
+    furi_mutex_release(app->lock);
+}
+
+void roster_set_user(ZeroMeshApp* app, const NodeInfoView* info) {
+    if(!app || info->num == 0) return;
+
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+
+    uint16_t idx = (info->num == app->my_node_num) ? app->names.self : roster_find(&app->roster, info->num);
+    if(idx != ROSTER_SLOT_NONE) {
+        if(idx != app->names.self && info->hw_model) app->roster.nodes[idx].hw_model = info->hw_model;
+        roster_apply_user(app, idx, info->num, info);
+        redraw_mark(app, REDRAW_ALL);
+    }
 
     furi_mutex_release(app->lock);
 }
 
+void roster_set_self(ZeroMeshApp* app, uint32_t node_id) {
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+    app->my_node_num = node_id;
+    names_reset(app, app->names.self, node_id);
+    furi_mutex_release(app->lock);
+}
+
 void roster_update_telemetry(ZeroMeshApp* app, uint32_t node_id, uint8_t battery_level, float voltage) {
     if(!app || node_id == 0) return;
 
     furi_mutex_acquire(app->lock, FuriWaitForever);
 
-    for(uint8_t i = 0; i < app->roster.count; i++) {
-        if(app->roster.nodes[i].node_id == node_id) {
-            app->roster.nodes[i].battery_level = battery_level;
-            app->roster.nodes[i].voltage = voltage;
-            app->roster.nodes[i].has_telemetry = true;
-            break;
-        }
+    uint16_t idx = roster_find(&app->roster, node_id);
+    if(idx != ROSTER_SLOT_NONE) {
+        NodeEntry* node = &app->roster.nodes[idx];
+        node->battery_level = battery_level;
+        node->voltage = voltage;
+        node->has_telemetry = true;
+        redraw_mark(app, REDRAW_PAGE(PAGE_ROSTER));
     }
 
     furi_mutex_release(app->lock);
 }
 
-static void draw_roster_bubble(Canvas* canvas, int x, int y, int max_w, const char* text, bool is_tx, uint32_t phase_seed, ZeroMeshApp* app) {
+void roster_note_ack(ZeroMeshApp* app, uint32_t node_id, uint32_t rtt_ms) {
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+    uint16_t idx = roster_find(&app->roster, node_id);
+    if(idx != ROSTER_SLOT_NONE) {
+        app->roster.nodes[idx].ack_rtt_ms = rtt_ms;
+        redraw_mark(app, REDRAW_PAGE(PAGE_ROSTER));
+    }
+    furi_mutex_release(app->lock);
+}
+
+static void draw_roster_bubble(Canvas* canvas, int x, int y, int max_w, const Message* msg, ZeroMeshApp* app) {
     canvas_set_font(canvas, FontSecondary);
 
-    const char* s = text ? text : "";
-    uint16_t text_w = canvas_string_width(canvas, s);
-    
+    bool is_tx = msg->is_tx;
+    uint32_t phase_seed = msg->seq * 977u;
+    const char* s = msg->text;
     int pad = 4;
     int inner_w = max_w - (pad * 2);
+
+    const TextLayout* layout = layout_get(canvas, app, msg, FontSecondary, inner_w);
+    uint16_t text_w = layout->text_w;
     
     int bubble_h = 12;
     int bubble_w = text_w + (pad * 2);
     
     if(app->lmh_mode == LMH_Wrap && text_w > inner_w) {
-        int lines = calculate_wrapped_lines(canvas, s, inner_w);
-        bubble_h = 2 + (lines * 9) + 2;
+        bubble_h = 2 + (layout->lines * 9) + 2;
         bubble_w = max_w;
     } else if(bubble_w > max_w) {
         bubble_w = max_w;
@@ -209,7 +296,8 @@ static void draw_roster_bubble(Canvas* canvas, int x, int y, int max_w, const ch
         canvas_set_color(canvas, text_col);
         canvas_draw_str(canvas, inner_x, baseline, s);
     } else if(app->lmh_mode == LMH_Wrap) {
-        draw_wrapped_text_in_bubble(canvas, inner_x, baseline, inner_w, s, text_col);
+        canvas_set_color(canvas, text_col);
+        layout_draw_lines(canvas, layout, s, inner_x, baseline);
     } else {
         uint32_t t = furi_get_tick() + phase_seed;
         uint32_t speed_delay = 24 * (11 - app->scroll_speed);
@@ -221,6 +309,7 @@ static void draw_roster_bubble(Canvas* canvas, int x, int y, int max_w, const ch
         int32_t x1 = (int32_t)inner_x - (int32_t)off;
         int32_t x2 = x1 + (int32_t)cycle;
         
+        app->redraw_animating = true;
         canvas_set_color(canvas, text_col);
         canvas_draw_str(canvas, (int)x1, baseline, s);
         canvas_draw_str(canvas, (int)x2, baseline, s);
@@ -241,6 +330,18 @@ static void draw_roster_bubble(Canvas* canvas, int x, int y, int max_w, const ch
         }
     }
     
+    if(is_tx && msg->ack != MsgAckNone) {
+        if(bx - x >= 7) {
+            canvas_set_color(canvas, ColorBlack);
+            draw_ack_glyph(canvas, bx - 7, y + 4, msg->ack);
+        } else {
+            canvas_set_color(canvas, bubble_bg);
+            canvas_draw_box(canvas, bx + bubble_w - 10, y + 2, 7, 8);
+            canvas_set_color(canvas, text_col);
+            draw_ack_glyph(canvas, bx + bubble_w - 9, y + 3, msg->ack);
+        }
+    }
+    
     canvas_set_color(canvas, ColorBlack);
 }
 
@@ -253,8 +354,8 @@ void render_roster(Canvas* canvas, ZeroMeshApp* app) {
         return;
     }
 
-    NodeEntry* selected = &app->roster.nodes[app->roster.selected_idx];
-    char title_buf[32];
+    uint16_t selected_idx = roster_selected(app);
+    NodeEntry* selected = &app->roster.nodes[selected_idx];
 
     if(app->roster.state == RosterStateList) {
         draw_header(canvas, app, "Node Roster");
@@ -262,11 +363,11 @@ void render_roster(Canvas* canvas, ZeroMeshApp* app) {
         canvas_set_font(canvas, FontSecondary);
 
         int y = 24;
-        for(uint8_t i = 0; i < 4 && i < app->roster.count; i++) {
-            uint8_t idx = (app->roster.selected_idx / 4) * 4 + i;
+        for(uint16_t i = 0; i < 4 && i < app->roster.count; i++) {
+            uint16_t idx = (selected_idx / 4) * 4 + i;
             if(idx >= app->roster.count) break;
 
-            if(idx == app->roster.selected_idx) {
+            if(idx == selected_idx) {
                 canvas_set_color(canvas, ColorBlack);
                 canvas_draw_box(canvas, 0, y - 8, 128, 11);
                 canvas_set_color(canvas, ColorWhite);
@@ -274,18 +375,21 @@ void render_roster(Canvas* canvas, ZeroMeshApp* app) {
                 canvas_set_color(canvas, ColorBlack);
             }
 
-            char line_buf[64];
+            char age_buf[16];
             uint32_t now = furi_get_tick() / 1000;
             uint32_t diff = now - app->roster.nodes[idx].last_seen;
-            const char* alert = app->roster.nodes[idx].has_new_dm ? "(!)" : " ";
-            snprintf(
-                line_buf,
-                sizeof(line_buf),
-                "%s %08lX %lus ago",
-                alert,
-                (unsigned long)app->roster.nodes[idx].node_id,
-                (unsigned long)diff);
-            canvas_draw_str(canvas, 4, y, line_buf);
+            snprintf(age_buf, sizeof(age_buf), "%lus ago", (unsigned long)diff);
+            int age_w = canvas_string_width(canvas, age_buf);
+            canvas_draw_str(canvas, 126 - age_w, y, age_buf);
+
+            int name_x = 4;
+            if(history_conv_unread(app, app->roster.nodes[idx].node_id)) {
+                canvas_draw_str(canvas, name_x, y, "(!)");
+                name_x += canvas_string_width(canvas, "(!) ");
+            }
+            NameKind kind = NameLong;
+            if(name_x + names_width(canvas, app, idx, NameLong, FontSecondary) > 122 - age_w) kind = NameShort;
+            canvas_draw_str(canvas, name_x, y, names_label(app, idx, kind));
             y += 12;
         }
 
@@ -296,84 +400,24 @@ void render_roster(Canvas* canvas, ZeroMeshApp* app) {
     }
 
     if(app->roster.state == RosterStateChat) {
-        snprintf(title_buf, sizeof(title_buf), "Chat: %08lX", (unsigned long)selected->node_id);
-        draw_header(canvas, app, title_buf);
+        draw_header(canvas, app, names_label(app, selected_idx, NameLong));
         canvas_set_color(canvas, ColorBlack);
 
-        uint8_t chat_msgs[MSG_HISTORY];
-        uint8_t chat_count = 0;
-
-        for(uint8_t i = 0; i < app->history.count; i++) {
-            uint8_t idx = (app->history.head + MSG_HISTORY - app->history.count + i) % MSG_HISTORY;
-            Message* m = &app->history.msgs[idx];
+        MessageWindow win;
+        message_window(canvas, app, selected->node_id, &app->roster.chat_scroll, 14, 4, &win);
 
-            bool is_dm_from_them = (m->from == selected->node_id && m->to == app->my_node_num);
-            bool is_dm_from_us = (m->from == app->my_node_num && m->to == selected->node_id);
-
-            if(is_dm_from_them || is_dm_from_us) {
-                chat_msgs[chat_count++] = idx;
-            }
-        }
-
-        if(chat_count == 0) {
+        if(win.count == 0 && !win.more) {
             canvas_set_font(canvas, FontSecondary);
             canvas_draw_str(canvas, 20, 34, "No direct messages");
+        } else if(win.visible == 0) {
+            canvas_set_font(canvas, FontSecondary);
+            canvas_draw_str(canvas, 40, 40, "Loading...");
         } else {
-            int available_height = 46;
             int y = 18;
-            int visible_count = 0;
-            
-            for(int i = chat_count - 1; i >= 0; i--) {
-                uint8_t idx = chat_msgs[i];
-                Message* msg = &app->history.msgs[idx];
-                
-                int msg_height = 14;
-                if(app->lmh_mode == LMH_Wrap) {
-                    int text_w = canvas_string_width(canvas, msg->text);
-                    int inner_w = 116;
-                    if(text_w > inner_w) {
-                        int lines = calculate_wrapped_lines(canvas, msg->text, inner_w);
-                        msg_height = 4 + (lines * 9) + 2;
-                    }
-                }
-                
-                if(y + msg_height <= available_height + 18) {
-                    visible_count++;
-                    y += msg_height;
-                } else {
-                    break;
-                }
-            }
-            
-            if(visible_count == 0) visible_count = 1;
-            
-            if(chat_count <= visible_count) {
-                app->roster.chat_scroll = 0;
-            } else if(app->roster.chat_scroll > chat_count - visible_count) {
-                app->roster.chat_scroll = chat_count - visible_count;
-            }
-
-            uint8_t start_idx = chat_count - visible_count - app->roster.chat_scroll;
-            if(start_idx > chat_count) start_idx = 0;
-
-            y = 18;
-            for(int i = 0; i < visible_count && (start_idx + i) < chat_count; i++) {
-                uint8_t idx = chat_msgs[start_idx + i];
-                Message* msg = &app->history.msgs[idx];
-                draw_roster_bubble(canvas, 2, y, 124, msg->text, msg->is_tx, (uint32_t)idx * 977u, app);
-                
-                if(app->lmh_mode == LMH_Wrap) {
-                    int text_w = canvas_string_width(canvas, msg->text);
-                    int inner_w = 116;
-                    if(text_w > inner_w) {
-                        int lines = calculate_wrapped_lines(canvas, msg->text, inner_w);
-                        y += 4 + (lines * 9) + 2;
-                    } else {
-                        y += 14;
-                    }
-                } else {
-                    y += 14;
-                }
+            for(int i = win.visible - 1; i >= 0; i--) {
+                const Message* msg = win.msgs[i];
+                draw_roster_bubble(canvas, 2, y, 124, msg, app);
+                y += win.heights[i];
             }
         }
 
@@ -384,8 +428,7 @@ void render_roster(Canvas* canvas, ZeroMeshApp* app) {
     }
 
     if(app->roster.state == RosterStateDetails) {
-        snprintf(title_buf, sizeof(title_buf), "Node: %08lX", (unsigned long)selected->node_id);
-        draw_header(canvas, app, title_buf);
+        draw_header(canvas, app, names_label(app, selected_idx, NameLong));
 
         canvas_set_color(canvas, ColorBlack);
         canvas_set_font(canvas, FontSecondary);
@@ -394,7 +437,17 @@ void render_roster(Canvas* canvas, ZeroMeshApp* app) {
         uint32_t now = furi_get_tick() / 1000;
         uint32_t diff = now - selected->last_seen;
 
-        snprintf(buf, sizeof(buf), "Last Seen: %lus ago", (unsigned long)diff);
+        if(selected->ack_rtt_ms) {
+            snprintf(
+                buf,
+                sizeof(buf),
+                "Seen %lus ago  ACK %lu.%lus",
+                (unsigned long)diff,
+                (unsigned long)(selected->ack_rtt_ms / 1000),
+                (unsigned long)(selected->ack_rtt_ms % 1000 / 100));
+        } else {
+            snprintf(buf, sizeof(buf), "Last Seen: %lus ago", (unsigned long)diff);
+        }
         canvas_draw_str(canvas, 4, 24, buf);
 
         snprintf(buf, sizeof(buf), "Signal: SNR %d / RSSI %d", selected->last_snr, selected->last_rssi);
@@ -415,31 +468,37 @@ void render_roster(Canvas* canvas, ZeroMeshApp* app) {
     }
 }
 
+static void roster_select_step(ZeroMeshApp* app, bool up) {
+    NodeRoster* r = &app->roster;
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+    uint16_t idx = roster_selected(app);
+    if(up) {
+        idx = (idx > 0) ? idx - 1 : r->count - 1;
+    } else {
+        idx = (idx < r->count - 1) ? idx + 1 : 0;
+    }
+    r->selected_id = r->nodes[idx].node_id;
+    furi_mutex_release(app->lock);
+}
+
 void input_roster(InputEvent* e, ZeroMeshApp* app) {
     if(!app || app->roster.count == 0) return;
 
     if(app->roster.state == RosterStateList) {
         if(e->key == InputKeyUp && (e->type == InputTypeShort || e->type == InputTypeRepeat)) {
-            if(app->roster.selected_idx > 0)
-                app->roster.selected_idx--;
-            else
-                app->roster.selected_idx = app->roster.count - 1;
-            view_port_update(app->vp);
+            roster_select_step(app, true);
+            redraw_mark(app, REDRAW_ALL);
         } else if(e->key == InputKeyDown && (e->type == InputTypeShort || e->type == InputTypeRepeat)) {
-            if(app->roster.selected_idx < app->roster.count - 1)
-                app->roster.selected_idx++;
-            else
-                app->roster.selected_idx = 0;
-            view_port_update(app->vp);
+            roster_select_step(app, false);
+            redraw_mark(app, REDRAW_ALL);
         } else if(e->key == InputKeyOk) {
             if(e->type == InputTypeShort) {
-                app->roster.nodes[app->roster.selected_idx].has_new_dm = false;
                 app->roster.state = RosterStateChat;
                 app->roster.chat_scroll = 0;
-                view_port_update(app->vp);
+                redraw_mark(app, REDRAW_ALL);
             } else if(e->type == InputTypeLong) {
                 app->roster.state = RosterStateDetails;
-                view_port_update(app->vp);
+                redraw_mark(app, REDRAW_ALL);
             }
         }
         return;
@@ -447,16 +506,19 @@ void input_roster(InputEvent* e, ZeroMeshApp* app) {
 
     if(app->roster.state == RosterStateChat) {
         if(e->key == InputKeyUp && (e->type == InputTypeShort || e->type == InputTypeRepeat)) {
-            app->roster.chat_scroll++;
-            view_port_update(app->vp);
+            bool more = false;
+            uint16_t count = history_conv_count(app, app->roster.selected_id, &more);
+            if(more || app->roster.chat_scroll + 1 < count) app->roster.chat_scroll++;
+            redraw_mark(app, REDRAW_ALL);
         } else if(e->key == InputKeyDown && (e->type == InputTypeShort || e->type == InputTypeRepeat)) {
             if(app->roster.chat_scroll > 0) app->roster.chat_scroll--;
-            view_port_update(app->vp);
+            redraw_mark(app, REDRAW_ALL);
         } else if(e->key == InputKeyOk && e->type == InputTypeShort) {
             app->show_keyboard = true;
+            redraw_wake(app);
         } else if(e->key == InputKeyBack && e->type == InputTypeShort) {
             app->roster.state = RosterStateList;
-            view_port_update(app->vp);
+            redraw_mark(app, REDRAW_ALL);
         }
         return;
     }
@@ -464,7 +526,7 @@ void input_roster(InputEvent* e, ZeroMeshApp* app) {
     if(app->roster.state == RosterStateDetails) {
         if(e->key == InputKeyBack && e->type == InputTypeShort) {
             app->roster.state = RosterStateList;
-            view_port_update(app->vp);
+            redraw_mark(app, REDRAW_ALL);
         }
         return;
     }
@@ -2,7 +2,14 @@
 
 #include "zeromesh_serial.h"
 
+void roster_init(ZeroMeshApp* app);
+void roster_free(ZeroMeshApp* app);
 void roster_add_node(ZeroMeshApp* app, uint32_t node_id, int8_t snr, int16_t rssi);
+uint16_t roster_lookup(ZeroMeshApp* app, uint32_t node_id);
+void roster_ingest_node(ZeroMeshApp* app, const NodeInfoView* info);
+void roster_set_user(ZeroMeshApp* app, const NodeInfoView* info);
+void roster_note_ack(ZeroMeshApp* app, uint32_t node_id, uint32_t rtt_ms);
+void roster_set_self(ZeroMeshApp* app, uint32_t node_id);
 void roster_update_telemetry(ZeroMeshApp* app, uint32_t node_id, uint8_t battery_level, float voltage);
 void render_roster(Canvas* canvas, ZeroMeshApp* app);
 void input_roster(InputEvent* e, ZeroMeshApp* app);
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "zeromesh_rtttl.h"
+
+#include <string.h>
+
+static const float rtttl_octave4_hz[12] = {
+    261.63f, 277.18f, 293.66f, 311.13f, 329.63f, 349.23f,
+    369.99f, 392.00f, 415.30f, 440.00f, 466.16f, 493.88f,
+};
+
+static const int8_t rtttl_letter_semitone[7] = {9, 11, 0, 2, 4, 5, 7};
+
+static const char* skip_space(const char* p) {
+    while(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    return p;
+}
+
+static const char* parse_uint(const char* p, uint32_t* out) {
+    uint32_t v = 0;
+    bool any = false;
+    while(*p >= '0' && *p <= '9') {
+        v = v * 10 + (uint32_t)(*p - '0');
+        any = true;
+        p++;
+    }
+    *out = any ? v : 0;
+    return p;
+}
+
+static bool is_valid_duration(uint32_t d) {
+    return d == 1 || d == 2 || d == 4 || d == 8 || d == 16 || d == 32 || d == 64;
+}
+
+static uint16_t note_freq(int semitone, uint32_t octave) {
+    float hz = rtttl_octave4_hz[semitone];
+    if(octave > 4) {
+        hz *= (float)(1u << (octave - 4));
+    } else if(octave < 4) {
+        hz /= (float)(1u << (4 - octave));
+    }
+    return (uint16_t)(hz + 0.5f);
+}
+
+static bool push_note(RtttlTune* tune, uint16_t freq, uint32_t ms) {
+    if(ms > UINT16_MAX) ms = UINT16_MAX;
+    if(freq > 0 && ms >= RTTTL_GAP_MS * 4) {
+        if(tune->count + 2 > RTTTL_MAX_NOTES) return false;
+        tune->notes[tune->count++] = (RtttlNote){.freq = freq, .ms = (uint16_t)(ms - RTTTL_GAP_MS)};
+        tune->notes[tune->count++] = (RtttlNote){.freq = 0, .ms = RTTTL_GAP_MS};
+    } else {
+        if(tune->count + 1 > RTTTL_MAX_NOTES) return false;
+        tune->notes[tune->count++] = (RtttlNote){.freq = freq, .ms = (uint16_t)ms};
+    }
+    return true;
+}
+
+bool rtttl_compile(const char* src, RtttlTune* tune) {
+    if(!src || !tune) return false;
+    memset(tune, 0, sizeof(*tune));
+
+    const char* p = skip_space(src);
+    const char* colon = strchr(p, ':');
+    if(!colon) return false;
+    size_t name_len = (size_t)(colon - p);
+    if(name_len >= sizeof(tune->name)) name_len = sizeof(tune->name) - 1;
+    memcpy(tune->name, p, name_len);
+    tune->name[name_len] = '\0';
+    p = colon + 1;
+
+    uint32_t def_dur = 4;
+    uint32_t def_oct = 6;
+    uint32_t bpm = 63;
+
+    while(*p && *p != ':') {
+        p = skip_space(p);
+        char key = *p;
+        if(key >= 'A' && key <= 'Z') key = (char)(key - 'A' + 'a');
+        if(!key || key == ':') break;
+        p = skip_space(p + 1);
+        if(*p != '=') return false;
+        uint32_t v;
+        p = parse_uint(skip_space(p + 1), &v);
+        if(key == 'd' && is_valid_duration(v)) {
+            def_dur = v;
+        } else if(key == 'o' && v >= 3 && v <= 8) {
+            def_oct = v;
+        } else if(key == 'b' && v > 0) {
+            bpm = v;
+        }
+        p = skip_space(p);
+        if(*p == ',') p++;
+    }
+    if(*p != ':') return false;
+    p++;
+
+    uint32_t whole_ms = (60000u * 4u) / bpm;
+
+    while(*p) {
+        p = skip_space(p);
+        if(!*p) break;
+
+        uint32_t dur;
+        p = parse_uint(p, &dur);
+        if(!is_valid_duration(dur)) dur = def_dur;
+
+        char letter = *p;
+        if(letter >= 'A' && letter <= 'Z') letter = (char)(letter - 'A' + 'a');
+        int semitone = -1;
+        if(letter >= 'a' && letter <= 'g') {
+            semitone = rtttl_letter_semitone[letter - 'a'];
+        } else if(letter == 'h') {
+            semitone = 11;
+        } else if(letter != 'p') {
+            return false;
+        }
+        p++;
+
+        if(*p == '#' && semitone >= 0) {
+            semitone = (semitone + 1) % 12;
+            p++;
+        }
+
+        bool dotted = false;
+        if(*p == '.') {
+            dotted = true;
+            p++;
+        }
+
+        uint32_t octave;
+        p = parse_uint(p, &octave);
+        if(octave < 3 || octave > 8) octave = def_oct;
+
+        if(*p == '.') {
+            dotted = true;
+            p++;
+        }
+
+        uint32_t ms = whole_ms / dur;
+        if(dotted) ms += ms / 2;
+
+        uint16_t freq = (semitone >= 0) ? note_freq(semitone, octave) : 0;
+        if(!push_note(tune, freq, ms)) break;
+
+        p = skip_space(p);
+        if(*p == ',') {
+            p++;
+        } else if(*p) {
+            return false;
+        }
+    }
+
+    return tune->count > 0;
+}
+
+size_t rtttl_clip(const char* src, size_t len, size_t max) {
+    if(len < max) return len;
+    while(len > 0 && src[len - 1] != ',') len--;
+    return (len > 0) ? len - 1 : 0;
+}
+
+uint32_t rtttl_duration_ms(const RtttlTune* tune) {
+    uint32_t total = 0;
+    for(uint16_t i = 0; i < tune->count; i++) total += tune->notes[i].ms;
+    return total;
+}
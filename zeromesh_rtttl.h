@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define RTTTL_MAX_NOTES 96
+#define RTTTL_NAME_LEN  16
+#define RTTTL_GAP_MS    15
+
+typedef struct {
+    uint16_t freq;
+    uint16_t ms;
+} RtttlNote;
+
+typedef struct {
+    char name[RTTTL_NAME_LEN];
+    uint16_t count;
+    RtttlNote notes[RTTTL_MAX_NOTES];
+} RtttlTune;
+
+bool rtttl_compile(const char* src, RtttlTune* tune);
+/* src holds len bytes read into a buffer of max. A full buffer means the
+ * file was cut short, so the partial note after the last ',' is dropped.
+ * Returns the length to keep. */
+size_t rtttl_clip(const char* src, size_t len, size_t max);
+uint32_t rtttl_duration_ms(const RtttlTune* tune);
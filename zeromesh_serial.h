@@ -12,21 +12,28 @@
 
 #include "lib/meshtastic_api/meshtastic/mesh.pb.h"
 #include "lib/meshtastic_api/meshtastic/portnums.pb.h"
+#include "lib/meshtastic_api/meshtastic/telemetry.pb.h"
 
 #include <gui/modules/text_input.h>
 #include <gui/view_dispatcher.h>
 
-#define ZEROMESH_MAGIC0 0x94
-#define ZEROMESH_MAGIC1 0xC3
+#include "zeromesh_rtttl.h"
+#include "zeromesh_wire.h"
 
 #define RX_STREAM_SIZE 4096
-#define MAX_FRAME_SIZE 512
+#define RX_CHUNK_SIZE  64
+#define RX_SPAN_SIZE   256
+
+#define RX_THREAD_STACK_SIZE 4096
+
+#define TX_QUEUE_SIZE 8
+#define TX_STATUS_MS  2000
+#define TX_RETRY_MS   500
+#define TX_RETRY_MAX  3
 
 #define LOG_LINES 18
 #define LOG_COLS  64
 
-#define PAYLOAD_CAPTURE_MAX 256
-
 #define PAGE_MESSAGES  0
 #define PAGE_ROSTER    1
 #define PAGE_STATS     2
@@ -35,14 +42,96 @@
 #define PAGE_SETTINGS  5
 #define PAGE_COUNT     6
 
-#define MSG_HISTORY 8
-
-#define ROSTER_MAX_NODES 16
+#define REDRAW_PAGE(p)    (1UL << (p))
+#define REDRAW_ALL        0xFFFFFFFFUL
+#define REDRAW_QUEUE_SIZE 8
+#define REDRAW_MIN_MS     40
+#define REDRAW_IDLE_MS    1000
+
+#define MSG_HISTORY   16
+#define MSG_TEXT_LEN  128
+#define MSG_PAGE_SIZE 16
+
+#define HISTORY_CONV_MAX  (MSG_HISTORY + MAX_CHANNELS)
+#define HISTORY_SLOT_NONE 0xFF
+
+#define LAYOUT_CACHE_SIZE (MSG_HISTORY + MSG_PAGE_SIZE)
+#define LAYOUT_MAX_LINES  10
+
+#define STORE_LOG_PATH    "/ext/zeromesh/messages.log"
+#define STORE_IDX_PATH    "/ext/zeromesh/messages.idx"
+#define STORE_LOG_OLD     "/ext/zeromesh/messages.log.old"
+#define STORE_IDX_OLD     "/ext/zeromesh/messages.idx.old"
+#define STORE_MAX_RECORDS 4096
+#define STORE_HEADS       32
+#define STORE_FLUSH_BATCH 8
+#define STORE_FLUSH_MS    10000
+
+#ifndef ROSTER_MAX_NODES
+#define ROSTER_MAX_NODES 512
+#endif
+#define ROSTER_MIN_NODES    16
+#define ROSTER_TARGET_NODES 256
+#define ROSTER_HEAP_SHARE   4
+#define ROSTER_SLOT_NONE  0xFFFF
+
+#define NAME_SHORT_MAX     4
+#define NAME_LONG_MAX      39
+#define NAME_POOL_PER_NODE 36
+#define NAME_OFF_NONE      0xFFFF
+
+#define CONFIG_NONCE 12345
+
+#define CAPTURE_DIR         "/ext/zeromesh/captures"
+#define CAPTURE_STREAM_SIZE 4096
+#define CAPTURE_BATCH       1024
+#define CAPTURE_FLUSH_MS    2000
+#define REPLAY_SPEED_MAX    0xFF
+
+#define LINK_SAMPLE_MS 1000
+#define LINK_SETTLE_MS 200
+#define LINK_PROBE_MS  2000
+#define LINK_HEARTBEAT_MS 15000
+#define LINK_HB_REPLY_MS  5000
+#define LINK_HB_MISSES    2
+#define LINK_RETRY_MS     45000
 
 #define SETTINGS_PATH "/ext/zeromesh/settings.cfg"
 #define MAX_CHANNELS 8
 
 #define MAX_RINGTONE_PATH 128
+#define RINGTONE_USER_DIR "/ext/zeromesh/ringtones"
+#define RINGTONE_USER_MAX 12
+#define RINGTONE_USER_NAME_LEN 24
+#define RINGTONE_SRC_MAX 512
+#define RINGTONE_VOLUME 0.6f
+
+#define NOTIFY_QUEUE_SIZE  8
+#define NOTIFY_COALESCE_MS 1000
+
+#define RX_STALL_MS 20
+#define RX_EVENT_RING 24
+#define RX_EVENT_RESERVE 8
+#define RX_EVENT_WAIT_MS 250
+#define RX_MERGE_SLOTS   32
+#define RX_FLAG_EVENT_SPACE (1UL << 0)
+#define RX_DRAIN_TICK_MS 50
+
+#define PORT_SLOT_COUNT   (meshtastic_PortNum_CAYENNE_APP + 2)
+#define PORT_SLOT_OTHER   (PORT_SLOT_COUNT - 1)
+#define PORT_SLOT_NONE    0xFFFF
+#define PORT_HIST_BUCKETS 6
+
+#define ACK_PENDING_MAX  16
+#define ACK_TIMEOUT_MS   90000
+#define ACK_HIST_BUCKETS 6
+
+#define DEDUP_BITS      7
+#define DEDUP_SLOTS     (1 << DEDUP_BITS)
+#define DEDUP_PROBE     4
+#define DEDUP_WINDOW_MS 600000
+/* Own TX ids are keyed by this instead of my_node_num, which may not be known yet */
+#define DEDUP_FROM_SELF 0
 
 typedef enum {
     RosterStateList = 0,
@@ -53,36 +142,135 @@ typedef enum {
 typedef struct {
     uint32_t node_id;
     uint32_t last_seen;
-    int8_t last_snr;
+    uint32_t ack_rtt_ms;
+    float voltage;
     int16_t last_rssi;
+    uint16_t hw_model;
+    uint16_t lru_prev;
+    uint16_t lru_next;
+    int8_t last_snr;
     uint8_t battery_level;
-    float voltage;
     bool has_telemetry;
-	bool has_new_dm;
 } NodeEntry;
 
 typedef struct {
-    NodeEntry nodes[ROSTER_MAX_NODES];
-    uint8_t count;
-    uint8_t selected_idx;
+    NodeEntry* nodes;
+    uint16_t* hash;
+    uint16_t capacity;
+    uint16_t hash_mask;
+    uint16_t count;
+    uint32_t selected_id;
+    uint16_t lru_head;
+    uint16_t lru_tail;
+    uint32_t lookups;
+    uint32_t evictions;
     RosterState state;
-    uint8_t chat_scroll;
+    uint16_t chat_scroll;
 } NodeRoster;
 
+typedef enum {
+    MsgAckNone = 0,
+    MsgAckPending,
+    MsgAckDelivered,
+    MsgAckFailed
+} MsgAck;
+
 typedef struct {
-    char text[128];
+    char text[MSG_TEXT_LEN];
     uint32_t from;
     uint32_t to;
     bool is_tx;
     uint32_t timestamp;
+    uint32_t seq;
+    uint8_t channel;
+    uint8_t ack;
+    uint8_t conv_idx;
+    uint8_t conv_prev;
 } Message;
 
+typedef struct {
+    uint32_t conv;
+    uint32_t last_seq;
+    uint16_t unread;
+    uint8_t newest;
+    uint8_t count;
+    bool used;
+} ConvIndex;
+
 typedef struct {
     Message msgs[MSG_HISTORY];
+    ConvIndex convs[HISTORY_CONV_MAX];
     uint8_t head;
     uint8_t count;
 } MessageHistory;
 
+typedef struct {
+    Message msgs[MSG_PAGE_SIZE];
+    uint32_t conv;
+    uint16_t shift;
+    uint16_t base;
+    uint8_t count;
+    bool valid;
+    bool exhausted;
+} MessagePage;
+
+typedef enum {
+    NameShort,
+    NameLong,
+    NameKindCount,
+} NameKind;
+
+typedef struct {
+    uint16_t off[NameKindCount];
+    uint8_t len[NameKindCount];
+    uint8_t width[NameKindCount];
+    uint8_t font[NameKindCount];
+} NodeName;
+
+typedef struct {
+    NodeName* entries;
+    char* pool;
+    uint16_t count;
+    uint16_t self;
+    uint16_t pool_size;
+    uint16_t pool_used;
+    uint16_t pool_live;
+    uint32_t compactions;
+} NameTable;
+
+typedef struct {
+    uint32_t seq;
+    uint16_t text_w;
+    uint8_t font;
+    uint8_t width;
+    uint8_t lines;
+    bool valid;
+    uint8_t starts[LAYOUT_MAX_LINES];
+    uint8_t lens[LAYOUT_MAX_LINES];
+} TextLayout;
+
+/* Newest flushed seq + 1 of a conversation, 0 = free slot */
+typedef struct {
+    uint32_t conv;
+    uint32_t next;
+} StoreHead;
+
+typedef struct {
+    bool enabled;
+    bool heads_complete;
+    uint32_t base;
+    uint32_t old_count;
+    StoreHead heads[STORE_HEADS];
+    uint32_t rotations;
+    uint32_t total;
+    uint32_t flushed;
+    uint32_t pending_tick;
+    uint32_t dropped;
+    uint32_t flush_batches;
+    uint32_t page_loads;
+    uint32_t page_last_ms;
+} MessageStore;
+
 typedef enum {
     RingtoneNone = 0,
     RingtoneShort,
@@ -106,6 +294,12 @@ typedef enum {
     RINGTONE_COUNT
 } RingtoneType;
 
+typedef enum {
+    NotifyEventMessage = 0,
+    NotifyEventPreview,
+    NotifyEventStop
+} NotifyEvent;
+
 typedef enum {
     LMH_Scroll = 0,
     LMH_Wrap,
@@ -115,16 +309,129 @@ typedef enum {
 typedef enum {
     SettingUart = 0,
     SettingBaud,
+    SettingAutoBaud,
     SettingVibro,
     SettingLed,
     SettingRingtone,
     SettingScrollSpeed,
     SettingScrollFramerate,
     SettingLMH,
+    SettingCapture,
+    SettingReplay,
     SETTING_COUNT
 } SettingItem;
 
+typedef struct ZeroMeshApp ZeroMeshApp;
+
+typedef void (*PortHandlerFn)(ZeroMeshApp* app, const PacketView* pkt);
+
+typedef struct {
+    PortHandlerFn fn;
+    bool needs_payload;
+} PortHandler;
+
+typedef struct {
+    uint32_t rx_count;
+    uint16_t decode_hist[PORT_HIST_BUCKETS];
+} PortStats;
+
+typedef struct {
+    uint32_t packet_id;
+    uint32_t queued_tick;
+    uint16_t len;
+    uint8_t frame[MAX_FRAME_SIZE + 4];
+} TxFrame;
+
+typedef struct {
+    uint32_t packet_id;
+    uint32_t to;
+    uint32_t seq;
+    uint32_t sent_tick;
+} PendingAck;
+
+typedef struct {
+    uint32_t from;
+    uint32_t id;
+    uint32_t tick;
+} DedupEntry;
+
+typedef enum {
+    RxEventLog = 0,
+    RxEventStatus,
+    RxEventMessage,
+    RxEventNode,
+    RxEventNodeInfo,
+    RxEventUser,
+    RxEventMyInfo,
+    RxEventTelemetry,
+    RxEventAck,
+    RxEventRebooted,
+    RxEventConfigDone
+} RxEventType;
+
 typedef struct {
+    uint8_t type;
+    uint16_t port;
+    union {
+        char text[LOG_COLS];
+        struct {
+            uint32_t from;
+            uint32_t to;
+            uint8_t channel;
+            char text[MSG_TEXT_LEN];
+        } msg;
+        struct {
+            uint32_t node_id;
+            uint32_t to;
+            uint32_t id;
+            int8_t snr;
+            int16_t rssi;
+        } node;
+        struct {
+            NodeInfoView view;
+            uint8_t short_name[NAME_SHORT_MAX];
+            uint8_t long_name[NAME_LONG_MAX];
+        } info;
+        struct {
+            uint32_t node_id;
+            uint8_t battery_level;
+            float voltage;
+        } telemetry;
+        struct {
+            uint32_t request_id;
+            uint32_t from;
+            uint32_t error;
+        } ack;
+        struct {
+            uint32_t nonce;
+            uint32_t tick;
+            uint16_t nodes;
+            uint8_t channels;
+        } config;
+    };
+} RxEvent;
+
+#define RX_MERGE_NODE      (1 << 0)
+#define RX_MERGE_TELEMETRY (1 << 1)
+
+/* Latest signal/telemetry per node, held by the RX thread while the ring is full */
+typedef struct {
+    uint32_t node_id;
+    uint32_t to;
+    uint32_t id;
+    int8_t snr;
+    int16_t rssi;
+    uint8_t battery_level;
+    float voltage;
+    uint8_t flags;
+} RxMerge;
+
+typedef union {
+    meshtastic_MyNodeInfo my_info;
+    meshtastic_Telemetry telemetry;
+} DecodeScratch;
+
+struct ZeroMeshApp {
     Gui* gui;
     ViewPort* vp;
     FuriMutex* lock;
@@ -137,21 +444,96 @@ typedef struct {
     FuriThread* rx_thread;
     volatile bool stop_thread;
 
-    uint8_t hdr[4];
-    uint8_t hdr_pos;
-
-    uint16_t frame_len;
-    uint16_t frame_pos;
-    uint8_t frame_buf[MAX_FRAME_SIZE];
+    FrameState framing;
+    uint8_t rx_span[RX_SPAN_SIZE];
+    DecodeScratch decode_scratch;
+    uint32_t rx_stack_free_min;
+    RxEvent rx_events[RX_EVENT_RING];
+    volatile uint32_t rx_event_head;
+    volatile uint32_t rx_event_tail;
+    uint32_t rx_event_dropped;
+    uint32_t rx_event_lost;
+    volatile bool rx_event_waiting;
+    uint32_t rx_event_waits;
+    RxMerge rx_merge[RX_MERGE_SLOTS];
+    uint8_t rx_merge_count;
+    uint32_t rx_event_merged;
+    uint16_t rx_port_current;
+    uint32_t rx_wait_us;
+    uint32_t rx_wait_max_us;
+    uint32_t rx_stalls;
+    uint32_t rx_stream_hwm;
 
     uint32_t rx_bytes;
+    uint32_t rx_overflow;
+    uint32_t rx_uart_overrun;
     uint32_t rx_frames_ok;
-    uint32_t rx_bad_magic;
-    uint32_t rx_bad_len;
     uint32_t rx_decode_fail;
 
+    uint32_t link_tick;
+    uint32_t link_bytes;
+    uint32_t link_ok;
+    uint32_t link_err;
+    uint32_t link_bps;
+    uint8_t link_err_pct;
+    volatile uint32_t link_rx_tick;
+    uint32_t link_hb_tick;
+    uint32_t link_probe_tick;
+    uint32_t link_down_tick;
+    uint32_t link_reconnect_ms;
+    uint32_t link_heartbeats;
+    uint32_t link_losses;
+    uint32_t link_reboots;
+    bool link_up;
+    bool link_hb_pending;
+    bool link_hb_answered;
+    uint8_t link_hb_misses;
+    volatile bool info_want;
+    bool autobaud_want;
+    bool autobaud_active;
+    bool autobaud_probing;
+    uint8_t autobaud_idx;
+    uint32_t autobaud_prev;
+    uint32_t autobaud_tick;
+    uint32_t autobaud_ok;
+    uint32_t autobaud_err;
+
+    FuriStreamBuffer* capture_stream;
+    char capture_path[40];
+    volatile bool capture_active;
+    bool capture_want;
+    uint32_t capture_start_tick;
+    uint32_t capture_flush_tick;
+    uint32_t capture_bytes;
+    uint32_t capture_dropped;
+
+    FuriThread* replay_thread;
+    volatile uint8_t replay_speed;
+    volatile bool replay_active;
+    volatile bool replay_stop;
+    volatile bool replay_done;
+    uint32_t replay_bytes;
+
     uint32_t tx_frames;
     uint32_t tx_encode_fail;
+    uint32_t tx_encode_us;
+    uint32_t tx_encode_max_us;
+
+    FuriThread* tx_thread;
+    FuriMutex* tx_lock;
+    FuriMessageQueue* tx_free;
+    FuriMessageQueue* tx_ready;
+    TxFrame* tx_pool;
+    volatile int32_t tx_status_res;
+    volatile uint32_t tx_status_id;
+    volatile uint8_t tx_radio_free;
+    uint8_t tx_radio_maxlen;
+    uint8_t tx_depth_max;
+    uint32_t tx_latency_ms;
+    uint32_t tx_latency_max_ms;
+    uint32_t tx_drops;
+    uint32_t tx_retries;
+    uint32_t tx_failed;
 
     char lines[LOG_LINES][LOG_COLS];
     uint8_t line_head;
@@ -159,15 +541,19 @@ typedef struct {
     char status[LOG_COLS];
     
     MessageHistory history;
+    MessageStore store;
+    MessagePage page;
+    uint32_t page_want_conv;
+    uint16_t page_want_k;
+    volatile bool page_want;
     
     uint8_t ui_mode;
     
-    uint8_t msg_scroll_offset;
+    uint16_t msg_scroll_offset;
     
     bool log_paused;
     uint8_t log_scroll_offset;
     
-    char last_rx_text[128];
     uint32_t last_rx_from;
     uint32_t last_rx_to;
     uint32_t last_rx_id;
@@ -176,16 +562,42 @@ typedef struct {
     bool has_rx_signal_data;
     
     uint32_t my_node_num;
+
+    uint32_t boot_tick;
+    uint32_t config_nonce;
+    uint32_t config_done_ms;
+    uint16_t config_nodes;
+    bool config_complete;
+    uint32_t rx_my_node_num;
+    uint16_t rx_config_nodes;
+    uint8_t rx_config_channels;
     
-    uint32_t sent_msg_ids[8];
-    uint8_t sent_msg_head;
+    FuriMutex* dedup_lock;
+    DedupEntry dedup[DEDUP_SLOTS];
+    uint32_t dedup_lookups;
+    uint32_t dedup_echoes;
+    uint32_t dedup_dups;
+    uint32_t dedup_evictions;
+
+    PendingAck ack_pending[ACK_PENDING_MAX];
+    uint32_t acks_ok;
+    uint32_t acks_failed;
+    uint32_t acks_expired;
+    uint32_t ack_rtt_last_ms;
+    uint16_t ack_hist[ACK_HIST_BUCKETS];
     
     uint8_t settings_cursor;
     bool settings_editing;
     
     bool notify_vibro;
     bool notify_led;
-    RingtoneType notify_ringtone;
+    uint8_t notify_ringtone;
+    uint8_t ringtone_user_count;
+    char ringtone_user_names[RINGTONE_USER_MAX][RINGTONE_USER_NAME_LEN];
+    RtttlTune* ringtone_cache[RINGTONE_COUNT + RINGTONE_USER_MAX];
+    const RtttlTune* player_tune;
+    uint16_t player_pos;
+    uint32_t player_next_tick;
     
     uint8_t scroll_speed;
     uint8_t scroll_framerate;
@@ -194,8 +606,11 @@ typedef struct {
     uint8_t current_channel;
     uint8_t num_channels;
     
-    volatile bool notify_active;
-    uint32_t notify_start_tick;
+    FuriThread* notify_thread;
+    FuriMessageQueue* notify_queue;
+    uint32_t notify_last_tick;
+    uint32_t notify_alerts;
+    uint32_t notify_coalesced;
     
     bool show_keyboard;
     char text_buffer[64];
@@ -203,6 +618,26 @@ typedef struct {
     TextInput* text_input;
 
     NodeRoster roster;
-} ZeroMeshApp;
+    NameTable names;
+
+    PortHandler port_handlers[PORT_SLOT_COUNT];
+    PortStats port_stats[PORT_SLOT_COUNT];
+
+    TextLayout layout_cache[LAYOUT_CACHE_SIZE];
+    uint32_t layout_hits;
+    uint32_t layout_misses;
+
+    FuriMessageQueue* redraw_queue;
+    uint32_t redraw_dirty;
+    bool redraw_animating;
+    volatile bool redraw_window_busy;
+    uint32_t redraw_last_tick;
+    uint32_t redraw_count;
+    uint32_t redraw_window_start;
+    uint32_t redraw_window_base;
+    uint32_t redraws_idle_min;
+    uint32_t redraws_busy_min;
+    uint8_t stats_scroll;
+};
 
 int32_t zeromesh_serial_app(void* p);
\ No newline at end of file
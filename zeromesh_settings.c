@@ -91,8 +91,8 @@ void settings_load(ZeroMeshApp* app) {
                     } else if(strcmp(key, "led") == 0) {
                         app->notify_led = (value != 0);
                     } else if(strcmp(key, "ringtone") == 0) {
-                        if(value >= 0 && value < RINGTONE_COUNT) {
-                            app->notify_ringtone = (RingtoneType)value;
+                        if(value >= 0 && value < RINGTONE_COUNT + RINGTONE_USER_MAX) {
+                            app->notify_ringtone = (uint8_t)value;
                         }
                     } else if(strcmp(key, "scroll_speed") == 0) {
                         if(value >= 1 && value <= 10) {
@@ -0,0 +1,427 @@
+#include "zeromesh_store.h"
+#include "zeromesh_history.h"
+
+#include <storage/storage.h>
+#include <stddef.h>
+#include <string.h>
+
+#define TAG "zeromesh_serial"
+
+#define STORE_SCAN_CHUNK 64
+
+#define STORE_FLAG_TX    0x01
+#define STORE_FLAG_VALID 0x80
+
+/* One per record in messages.idx. back is the distance to the previous
+ * record of the same conversation (0 = none), so it stays valid when the
+ * files rotate and seqs are renumbered on the next open. */
+typedef struct {
+    uint32_t conv;
+    uint32_t back;
+} StoreIndex;
+
+/* [0] is the live generation, [1] the rotated one (NULL when absent) */
+typedef struct {
+    File* log[2];
+    File* idx[2];
+} StoreFiles;
+
+typedef struct {
+    uint32_t from;
+    uint32_t to;
+    uint32_t timestamp;
+    uint8_t flags;
+    uint8_t channel;
+    uint8_t ack;
+    uint8_t reserved;
+    char text[MSG_TEXT_LEN];
+} StoreRecord;
+
+static void record_from_message(StoreRecord* rec, const Message* msg) {
+    memset(rec, 0, sizeof(*rec));
+    rec->from = msg->from;
+    rec->to = msg->to;
+    rec->timestamp = msg->timestamp;
+    rec->flags = STORE_FLAG_VALID | (msg->is_tx ? STORE_FLAG_TX : 0);
+    rec->channel = msg->channel;
+    rec->ack = msg->ack;
+    memcpy(rec->text, msg->text, sizeof(rec->text));
+    rec->text[sizeof(rec->text) - 1] = '\0';
+}
+
+static void record_to_message(Message* msg, const StoreRecord* rec, uint32_t seq) {
+    memcpy(msg->text, rec->text, sizeof(msg->text));
+    msg->text[sizeof(msg->text) - 1] = '\0';
+    msg->from = rec->from;
+    msg->to = rec->to;
+    msg->is_tx = (rec->flags & STORE_FLAG_TX) != 0;
+    msg->channel = (rec->channel < MAX_CHANNELS) ? rec->channel : 0;
+    msg->ack = (rec->ack == MsgAckDelivered || rec->ack == MsgAckFailed) ? rec->ack : MsgAckNone;
+    msg->timestamp = rec->timestamp;
+    msg->seq = seq;
+}
+
+static uint32_t store_oldest(const MessageStore* st) {
+    return st->base - st->old_count;
+}
+
+static int store_locate(const MessageStore* st, uint32_t seq, uint32_t* pos) {
+    if(seq >= st->base) {
+        *pos = seq - st->base;
+        return 0;
+    }
+    if(seq < store_oldest(st)) return -1;
+    *pos = seq - store_oldest(st);
+    return 1;
+}
+
+static bool read_at(File* file, uint32_t offset, void* buf, size_t size) {
+    if(!file || !storage_file_seek(file, offset, true)) return false;
+    return storage_file_read(file, buf, size) == size;
+}
+
+static bool read_record(const MessageStore* st, StoreFiles* sf, uint32_t seq, StoreRecord* rec) {
+    uint32_t pos;
+    int gen = store_locate(st, seq, &pos);
+    return gen >= 0 && read_at(sf->log[gen], pos * sizeof(StoreRecord), rec, sizeof(*rec));
+}
+
+static bool read_index(const MessageStore* st, StoreFiles* sf, uint32_t seq, StoreIndex* ix) {
+    uint32_t pos;
+    int gen = store_locate(st, seq, &pos);
+    return gen >= 0 && read_at(sf->idx[gen], pos * sizeof(StoreIndex), ix, sizeof(*ix));
+}
+
+static bool store_files_open(Storage* storage, StoreFiles* sf, const MessageStore* st, FS_AccessMode mode) {
+    memset(sf, 0, sizeof(*sf));
+    sf->log[0] = storage_file_alloc(storage);
+    sf->idx[0] = storage_file_alloc(storage);
+    if(!storage_file_open(sf->log[0], STORE_LOG_PATH, mode, FSOM_OPEN_ALWAYS) ||
+       !storage_file_open(sf->idx[0], STORE_IDX_PATH, mode, FSOM_OPEN_ALWAYS)) {
+        return false;
+    }
+    if(st->old_count == 0) return true;
+    sf->log[1] = storage_file_alloc(storage);
+    sf->idx[1] = storage_file_alloc(storage);
+    if(!storage_file_open(sf->log[1], STORE_LOG_OLD, FSAM_READ, FSOM_OPEN_EXISTING) ||
+       !storage_file_open(sf->idx[1], STORE_IDX_OLD, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        storage_file_free(sf->log[1]);
+        storage_file_free(sf->idx[1]);
+        sf->log[1] = NULL;
+        sf->idx[1] = NULL;
+    }
+    return true;
+}
+
+static void store_files_close(StoreFiles* sf) {
+    for(uint8_t gen = 0; gen < 2; gen++) {
+        if(sf->idx[gen]) storage_file_free(sf->idx[gen]);
+        if(sf->log[gen]) storage_file_free(sf->log[gen]);
+        sf->idx[gen] = NULL;
+        sf->log[gen] = NULL;
+    }
+}
+
+static StoreHead* store_head_find(MessageStore* st, uint32_t conv) {
+    for(uint8_t i = 0; i < STORE_HEADS; i++) {
+        if(st->heads[i].next && st->heads[i].conv == conv) return &st->heads[i];
+    }
+    return NULL;
+}
+
+static void store_head_set(MessageStore* st, uint32_t conv, uint32_t seq) {
+    StoreHead* head = store_head_find(st, conv);
+    if(!head) {
+        head = &st->heads[0];
+        for(uint8_t i = 1; i < STORE_HEADS && head->next; i++) {
+            if(st->heads[i].next < head->next) head = &st->heads[i];
+        }
+        if(head->next) st->heads_complete = false;
+        head->conv = conv;
+    }
+    head->next = seq + 1;
+}
+
+/* Newest record of conv below seq `below`, as seq + 1 (0 = none). Only
+ * used when conv has fallen out of st->heads. */
+static uint32_t store_find_last(const MessageStore* st, StoreFiles* sf, uint32_t conv, uint32_t below) {
+    StoreIndex chunk[STORE_SCAN_CHUNK];
+    uint32_t pos = below;
+    uint32_t oldest = store_oldest(st);
+    while(pos > oldest) {
+        uint32_t floor = (pos > st->base) ? st->base : oldest;
+        uint32_t n = (pos - floor > STORE_SCAN_CHUNK) ? STORE_SCAN_CHUNK : pos - floor;
+        uint32_t at = 0;
+        int gen = store_locate(st, pos - n, &at);
+        if(gen < 0 || !read_at(sf->idx[gen], at * sizeof(StoreIndex), chunk, n * sizeof(StoreIndex))) break;
+        for(uint32_t i = n; i > 0; i--) {
+            if(chunk[i - 1].conv == conv) return pos - n + i;
+        }
+        pos -= n;
+    }
+    return 0;
+}
+
+static uint32_t store_head_next(MessageStore* st, StoreFiles* sf, uint32_t conv) {
+    StoreHead* head = store_head_find(st, conv);
+    if(head) return head->next;
+    if(st->heads_complete) return 0;
+    uint32_t next = store_find_last(st, sf, conv, st->flushed);
+    if(next) store_head_set(st, conv, next - 1);
+    return next;
+}
+
+/* Fills st->heads walking back from the newest record, stopping once the
+ * table is full */
+static void store_heads_build(MessageStore* st, StoreFiles* sf) {
+    StoreIndex chunk[STORE_SCAN_CHUNK];
+    uint8_t used = 0;
+    uint32_t pos = st->flushed;
+    uint32_t oldest = store_oldest(st);
+    while(pos > oldest && used < STORE_HEADS) {
+        uint32_t floor = (pos > st->base) ? st->base : oldest;
+        uint32_t n = (pos - floor > STORE_SCAN_CHUNK) ? STORE_SCAN_CHUNK : pos - floor;
+        uint32_t at = 0;
+        int gen = store_locate(st, pos - n, &at);
+        if(gen < 0 || !read_at(sf->idx[gen], at * sizeof(StoreIndex), chunk, n * sizeof(StoreIndex))) break;
+        for(uint32_t i = n; i > 0 && used < STORE_HEADS; i--) {
+            if(store_head_find(st, chunk[i - 1].conv)) continue;
+            st->heads[used].conv = chunk[i - 1].conv;
+            st->heads[used].next = pos - n + i;
+            used++;
+        }
+        pos -= n;
+    }
+    st->heads_complete = pos <= oldest;
+}
+
+static uint32_t store_count(File* log_file, File* idx_file) {
+    uint32_t log_count = (uint32_t)(storage_file_size(log_file) / sizeof(StoreRecord));
+    uint32_t idx_count = (uint32_t)(storage_file_size(idx_file) / sizeof(StoreIndex));
+    return (log_count < idx_count) ? log_count : idx_count;
+}
+
+void store_open(ZeroMeshApp* app) {
+    MessageStore* st = &app->store;
+    memset(st, 0, sizeof(*st));
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    storage_common_mkdir(storage, "/ext/zeromesh");
+
+    File* log_old = storage_file_alloc(storage);
+    File* idx_old = storage_file_alloc(storage);
+    if(storage_file_open(log_old, STORE_LOG_OLD, FSAM_READ, FSOM_OPEN_EXISTING) &&
+       storage_file_open(idx_old, STORE_IDX_OLD, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        st->old_count = store_count(log_old, idx_old);
+    }
+    storage_file_free(idx_old);
+    storage_file_free(log_old);
+    st->base = st->old_count;
+
+    StoreFiles sf;
+    if(store_files_open(storage, &sf, st, FSAM_READ_WRITE)) {
+        File* log_file = sf.log[0];
+        File* idx_file = sf.idx[0];
+        uint32_t count = store_count(log_file, idx_file);
+
+        if(storage_file_size(log_file) != count * sizeof(StoreRecord)) {
+            storage_file_seek(log_file, count * sizeof(StoreRecord), true);
+            storage_file_truncate(log_file);
+        }
+        if(storage_file_size(idx_file) != count * sizeof(StoreIndex)) {
+            storage_file_seek(idx_file, count * sizeof(StoreIndex), true);
+            storage_file_truncate(idx_file);
+        }
+        if(!sf.idx[1]) st->old_count = 0;
+
+        st->enabled = true;
+        st->total = st->base + count;
+        st->flushed = st->total;
+        store_heads_build(st, &sf);
+
+        uint32_t first = (st->total - store_oldest(st) > MSG_HISTORY) ? st->total - MSG_HISTORY :
+                                                                         store_oldest(st);
+        StoreRecord rec;
+        Message msg;
+        for(uint32_t seq = first; seq < st->total; seq++) {
+            if(!read_record(st, &sf, seq, &rec)) break;
+            if(!(rec.flags & STORE_FLAG_VALID)) continue;
+            record_to_message(&msg, &rec, seq);
+            history_restore(app, &msg);
+        }
+
+        FURI_LOG_I(
+            TAG,
+            "store_open: %lu + %lu records",
+            (unsigned long)st->old_count,
+            (unsigned long)count);
+    } else {
+        FURI_LOG_W(TAG, "store_open: message store unavailable");
+    }
+
+    store_files_close(&sf);
+    furi_record_close(RECORD_STORAGE);
+}
+
+/* The live files become the .old generation and a fresh pair starts at seq */
+static bool store_rotate(Storage* storage, StoreFiles* sf, MessageStore* st, uint32_t seq) {
+    store_files_close(sf);
+    storage_common_remove(storage, STORE_LOG_OLD);
+    storage_common_remove(storage, STORE_IDX_OLD);
+    if(storage_common_rename(storage, STORE_LOG_PATH, STORE_LOG_OLD) != FSE_OK ||
+       storage_common_rename(storage, STORE_IDX_PATH, STORE_IDX_OLD) != FSE_OK) {
+        return false;
+    }
+    st->old_count = seq - st->base;
+    st->base = seq;
+    st->rotations++;
+    return store_files_open(storage, sf, st, FSAM_READ_WRITE);
+}
+
+void store_flush(ZeroMeshApp* app, bool force) {
+    MessageStore* st = &app->store;
+    if(!st->enabled) return;
+
+    furi_mutex_acquire(app->lock, FuriWaitForever);
+    uint32_t pending = st->total - st->flushed;
+    bool due = force || pending >= STORE_FLUSH_BATCH ||
+               (pending > 0 && furi_get_tick() - st->pending_tick >= STORE_FLUSH_MS);
+    furi_mutex_release(app->lock);
+    if(!due || pending == 0) return;
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    StoreFiles sf;
+
+    if(store_files_open(storage, &sf, st, FSAM_READ_WRITE)) {
+        uint32_t written = 0;
+        StoreRecord rec;
+        StoreIndex ix;
+        for(uint32_t seq = st->flushed; seq < st->flushed + pending; seq++) {
+            if(seq - st->base >= STORE_MAX_RECORDS && !store_rotate(storage, &sf, st, seq)) {
+                st->enabled = false;
+                FURI_LOG_W(TAG, "store_flush: rotate failed, disabling store");
+                break;
+            }
+
+            ix.conv = 0;
+            furi_mutex_acquire(app->lock, FuriWaitForever);
+            const Message* msg = history_find_seq(app, seq);
+            if(msg) {
+                record_from_message(&rec, msg);
+                ix.conv = history_conv_of(msg);
+            } else {
+                memset(&rec, 0, sizeof(rec));
+            }
+            furi_mutex_release(app->lock);
+
+            uint32_t prev = store_head_next(st, &sf, ix.conv);
+            ix.back = prev ? seq + 1 - prev : 0;
+
+            uint32_t pos = seq - st->base;
+            if(!storage_file_seek(sf.log[0], pos * sizeof(rec), true) ||
+               storage_file_write(sf.log[0], &rec, sizeof(rec)) != sizeof(rec)) {
+                break;
+            }
+            if(!storage_file_seek(sf.idx[0], pos * sizeof(ix), true) ||
+               storage_file_write(sf.idx[0], &ix, sizeof(ix)) != sizeof(ix)) {
+                break;
+            }
+            store_head_set(st, ix.conv, seq);
+            written++;
+        }
+
+        furi_mutex_acquire(app->lock, FuriWaitForever);
+        st->flushed += written;
+        st->flush_batches++;
+        st->pending_tick = furi_get_tick();
+        furi_mutex_release(app->lock);
+    } else {
+        st->enabled = false;
+        FURI_LOG_W(TAG, "store_flush: open failed, disabling store");
+    }
+
+    store_files_close(&sf);
+    furi_record_close(RECORD_STORAGE);
+}
+
+void store_set_ack(ZeroMeshApp* app, uint32_t seq, uint8_t ack) {
+    MessageStore* st = &app->store;
+    uint32_t pos;
+    if(!st->enabled || seq >= st->flushed) return;
+    int gen = store_locate(st, seq, &pos);
+    if(gen < 0) return;
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* log_file = storage_file_alloc(storage);
+
+    if(storage_file_open(log_file, gen ? STORE_LOG_OLD : STORE_LOG_PATH, FSAM_WRITE, FSOM_OPEN_EXISTING) &&
+       storage_file_seek(log_file, pos * sizeof(StoreRecord) + offsetof(StoreRecord, ack), true)) {
+        storage_file_write(log_file, &ack, sizeof(ack));
+    }
+
+    storage_file_close(log_file);
+    storage_file_free(log_file);
+    furi_record_close(RECORD_STORAGE);
+}
+
+/* Follows conv's back-pointers, starting at top_seq when that record is in
+ * conv and at the conversation's newest record otherwise, so a page costs
+ * the records skipped and returned rather than the size of the log */
+bool store_scan(
+    ZeroMeshApp* app,
+    uint32_t conv,
+    uint32_t top_seq,
+    uint16_t skip,
+    Message* out,
+    uint16_t max,
+    uint16_t* got,
+    bool* exhausted) {
+    MessageStore* st = &app->store;
+    *got = 0;
+    *exhausted = true;
+    if(!st->enabled) return false;
+
+    uint32_t below = (top_seq < st->flushed) ? top_seq : st->flushed;
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    StoreFiles sf;
+    bool ok = false;
+
+    if(store_files_open(storage, &sf, st, FSAM_READ)) {
+        StoreIndex ix;
+        StoreRecord rec;
+        uint32_t next;
+        if(below < st->flushed && read_index(st, &sf, below, &ix) && ix.conv == conv) {
+            next = (ix.back && ix.back <= below) ? below + 1 - ix.back : 0;
+        } else {
+            next = store_head_next(st, &sf, conv);
+        }
+        ok = true;
+
+        while(next > store_oldest(st) && *got < max) {
+            uint32_t seq = next - 1;
+            if(!read_index(st, &sf, seq, &ix)) {
+                ok = false;
+                break;
+            }
+            next = (ix.back && ix.back <= seq) ? seq + 1 - ix.back : 0;
+            if(seq >= below) continue;
+            if(skip > 0) {
+                skip--;
+                continue;
+            }
+            if(!read_record(st, &sf, seq, &rec)) {
+                ok = false;
+                break;
+            }
+            record_to_message(&out[*got], &rec, seq);
+            (*got)++;
+        }
+
+        *exhausted = next <= store_oldest(st);
+    }
+
+    store_files_close(&sf);
+    furi_record_close(RECORD_STORAGE);
+    return ok;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "zeromesh_serial.h"
+
+void store_open(ZeroMeshApp* app);
+void store_flush(ZeroMeshApp* app, bool force);
+void store_set_ack(ZeroMeshApp* app, uint32_t seq, uint8_t ack);
+bool store_scan(
+    ZeroMeshApp* app,
+    uint32_t conv,
+    uint32_t top_seq,
+    uint16_t skip,
+    Message* out,
+    uint16_t max,
+    uint16_t* got,
+    bool* exhausted);
@@ -0,0 +1,172 @@
+#include "zeromesh_tx.h"
+#include "zeromesh_history.h"
+#include "zeromesh_redraw.h"
+
+#include <stdlib.h>
+
+#define TX_FLAG_STATUS (1UL << 0)
+#define TX_FLAG_STOP   (1UL << 1)
+#define TX_SLOT_STOP   0xFF
+
+static uint32_t tx_wait(uint32_t timeout) {
+    uint32_t flags = furi_thread_flags_wait(TX_FLAG_STATUS | TX_FLAG_STOP, FuriFlagWaitAny, timeout);
+    return (flags & FuriFlagError) ? 0 : flags;
+}
+
+static void tx_wire(ZeroMeshApp* app, TxFrame* f, bool first) {
+    furi_mutex_acquire(app->tx_lock, FuriWaitForever);
+    if(app->serial) furi_hal_serial_tx(app->serial, f->frame, f->len);
+    furi_mutex_release(app->tx_lock);
+
+    app->tx_frames++;
+    if(first) {
+        app->tx_latency_ms = furi_get_tick() - f->queued_tick;
+        if(app->tx_latency_ms > app->tx_latency_max_ms) app->tx_latency_max_ms = app->tx_latency_ms;
+    }
+    redraw_mark(app, REDRAW_PAGE(PAGE_STATS));
+}
+
+static bool tx_pace(ZeroMeshApp* app) {
+    uint32_t start = furi_get_tick();
+    while(app->tx_radio_free == 0) {
+        int32_t left = (int32_t)(start + TX_STATUS_MS - furi_get_tick());
+        if(left <= 0) break;
+        uint32_t flags = tx_wait(left);
+        if(flags & TX_FLAG_STOP) return false;
+        if(flags == 0) break;
+    }
+    return true;
+}
+
+static bool tx_send_packet(ZeroMeshApp* app, TxFrame* f) {
+    for(uint8_t attempt = 0; attempt <= TX_RETRY_MAX; attempt++) {
+        if(attempt > 0) {
+            app->tx_retries++;
+            if(tx_wait(TX_RETRY_MS) & TX_FLAG_STOP) return false;
+        }
+        if(!tx_pace(app)) return false;
+
+        furi_thread_flags_clear(TX_FLAG_STATUS);
+        tx_wire(app, f, attempt == 0);
+
+        uint32_t start = furi_get_tick();
+        while(true) {
+            int32_t left = (int32_t)(start + TX_STATUS_MS - furi_get_tick());
+            if(left <= 0) return true;
+            uint32_t flags = tx_wait(left);
+            if(flags & TX_FLAG_STOP) return false;
+            if(flags == 0) return true;
+            if(app->tx_status_id != f->packet_id) continue;
+            if(app->tx_status_res == 0) return true;
+            break;
+        }
+    }
+
+    app->tx_failed++;
+    log_line(app, "TX: radio busy, dropped");
+    return true;
+}
+
+static int32_t tx_thread_fn(void* ctx) {
+    ZeroMeshApp* app = (ZeroMeshApp*)ctx;
+    uint8_t slot;
+
+    while(furi_message_queue_get(app->tx_ready, &slot, FuriWaitForever) == FuriStatusOk) {
+        if(slot == TX_SLOT_STOP) break;
+
+        TxFrame* f = &app->tx_pool[slot];
+        bool running = true;
+        if(f->packet_id) {
+            running = tx_send_packet(app, f);
+        } else {
+            tx_wire(app, f, true);
+        }
+        furi_message_queue_put(app->tx_free, &slot, 0);
+        if(!running) break;
+    }
+
+    return 0;
+}
+
+TxResult tx_encode(ZeroMeshApp* app, const pb_msgdesc_t* fields, const void* msg, uint32_t packet_id) {
+    if(!app || !app->tx_pool) return TxQueueFull;
+
+    uint8_t slot;
+    if(furi_message_queue_get(app->tx_free, &slot, 0) != FuriStatusOk) {
+        app->tx_drops++;
+        redraw_mark(app, REDRAW_PAGE(PAGE_STATS));
+        return TxQueueFull;
+    }
+
+    uint32_t start = DWT->CYCCNT;
+    TxFrame* f = &app->tx_pool[slot];
+    pb_ostream_t os = pb_ostream_from_buffer(f->frame + 4, MAX_FRAME_SIZE);
+    if(!pb_encode(&os, fields, msg)) {
+        furi_message_queue_put(app->tx_free, &slot, 0);
+        app->tx_encode_fail++;
+        return TxEncodeFail;
+    }
+
+    size_t len = os.bytes_written;
+    f->frame[0] = ZEROMESH_MAGIC0;
+    f->frame[1] = ZEROMESH_MAGIC1;
+    f->frame[2] = (uint8_t)((len >> 8) & 0xFF);
+    f->frame[3] = (uint8_t)(len & 0xFF);
+    f->len = len + 4;
+    f->packet_id = packet_id;
+    f->queued_tick = furi_get_tick();
+
+    app->tx_encode_us = (DWT->CYCCNT - start) / furi_hal_cortex_instructions_per_microsecond();
+    if(app->tx_encode_us > app->tx_encode_max_us) app->tx_encode_max_us = app->tx_encode_us;
+
+    furi_message_queue_put(app->tx_ready, &slot, FuriWaitForever);
+
+    uint8_t depth = TX_QUEUE_SIZE - furi_message_queue_get_count(app->tx_free);
+    if(depth > app->tx_depth_max) app->tx_depth_max = depth;
+    redraw_mark(app, REDRAW_PAGE(PAGE_STATS));
+    return TxOk;
+}
+
+void tx_queue_status(ZeroMeshApp* app, int32_t res, uint32_t free_slots, uint32_t maxlen, uint32_t packet_id) {
+    app->tx_status_res = res;
+    app->tx_status_id = packet_id;
+    app->tx_radio_free = (free_slots > 0xFF) ? 0xFF : (uint8_t)free_slots;
+    app->tx_radio_maxlen = (maxlen > 0xFF) ? 0xFF : (uint8_t)maxlen;
+    if(app->tx_thread) furi_thread_flags_set(furi_thread_get_id(app->tx_thread), TX_FLAG_STATUS);
+}
+
+void tx_start(ZeroMeshApp* app) {
+    app->tx_pool = malloc(TX_QUEUE_SIZE * sizeof(TxFrame));
+    app->tx_free = furi_message_queue_alloc(TX_QUEUE_SIZE, sizeof(uint8_t));
+    app->tx_ready = furi_message_queue_alloc(TX_QUEUE_SIZE + 1, sizeof(uint8_t));
+    app->tx_lock = furi_mutex_alloc(FuriMutexTypeNormal);
+    app->tx_radio_free = 1;
+
+    for(uint8_t i = 0; i < TX_QUEUE_SIZE; i++) {
+        furi_message_queue_put(app->tx_free, &i, 0);
+    }
+
+    app->tx_thread = furi_thread_alloc_ex("mt_tx", 2048, tx_thread_fn, app);
+    furi_thread_start(app->tx_thread);
+}
+
+void tx_stop(ZeroMeshApp* app) {
+    if(!app->tx_thread) return;
+
+    uint8_t slot = TX_SLOT_STOP;
+    furi_message_queue_reset(app->tx_ready);
+    furi_message_queue_put(app->tx_ready, &slot, FuriWaitForever);
+    furi_thread_flags_set(furi_thread_get_id(app->tx_thread), TX_FLAG_STOP);
+    furi_thread_join(app->tx_thread);
+    furi_thread_free(app->tx_thread);
+    app->tx_thread = NULL;
+
+    furi_message_queue_free(app->tx_ready);
+    furi_message_queue_free(app->tx_free);
+    furi_mutex_free(app->tx_lock);
+    free(app->tx_pool);
+    app->tx_ready = NULL;
+    app->tx_free = NULL;
+    app->tx_lock = NULL;
+    app->tx_pool = NULL;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "zeromesh_serial.h"
+
+void tx_start(ZeroMeshApp* app);
+void tx_stop(ZeroMeshApp* app);
+typedef enum {
+    TxOk,
+    TxQueueFull,
+    TxEncodeFail,
+} TxResult;
+
+TxResult tx_encode(ZeroMeshApp* app, const pb_msgdesc_t* fields, const void* msg, uint32_t packet_id);
+void tx_queue_status(ZeroMeshApp* app, int32_t res, uint32_t free_slots, uint32_t maxlen, uint32_t packet_id);
@@ -3,26 +3,34 @@
 
 #define TAG "zeromesh_serial"
 
-static void rx_cb(FuriHalSerialHandle* handle, FuriHalSerialRxEvent event, void* ctx) {
+static void rx_cb(FuriHalSerialHandle* handle, FuriHalSerialRxEvent event, size_t data_len, void* ctx) {
     ZeroMeshApp* app = (ZeroMeshApp*)ctx;
     if(!app) return;
 
-    if(event == FuriHalSerialRxEventData) {
-        uint8_t b = furi_hal_serial_async_rx(handle);
-        app->rx_bytes++;
-        furi_stream_buffer_send(app->rx_stream, &b, 1, 0);
-
-        if(app->rx_bytes < 20) {
-            FURI_LOG_I(TAG, "RX byte %lu: 0x%02X", (unsigned long)app->rx_bytes, b);
+    if(event & (FuriHalSerialRxEventData | FuriHalSerialRxEventIdle)) {
+        uint8_t chunk[RX_CHUNK_SIZE];
+        while(data_len > 0) {
+            size_t want = (data_len > sizeof(chunk)) ? sizeof(chunk) : data_len;
+            size_t n = furi_hal_serial_dma_rx(handle, chunk, want);
+            if(n == 0) break;
+            data_len -= n;
+            app->rx_bytes += n;
+            if(app->replay_active) continue;
+            size_t sent = furi_stream_buffer_send(app->rx_stream, chunk, n, 0);
+            if(sent < n) app->rx_overflow += n - sent;
         }
     }
+
+    if(event & FuriHalSerialRxEventOverrunError) {
+        app->rx_uart_overrun++;
+    }
 }
 
 void uart_close(ZeroMeshApp* app) {
     if(!app) return;
 
     if(app->serial) {
-        furi_hal_serial_async_rx_stop(app->serial);
+        furi_hal_serial_dma_rx_stop(app->serial);
         furi_hal_serial_deinit(app->serial);
         furi_hal_serial_control_release(app->serial);
         app->serial = NULL;
@@ -36,7 +44,7 @@ void uart_open(ZeroMeshApp* app) {
 
     app->serial = furi_hal_serial_control_acquire(app->uart_id);
     furi_hal_serial_init(app->serial, app->baud);
-    furi_hal_serial_async_rx_start(app->serial, rx_cb, app, false);
+    furi_hal_serial_dma_rx_start(app->serial, rx_cb, app, true);
 
     log_line(app, "UART: %s @ %lu",
              (app->uart_id == FuriHalSerialIdUsart) ? "USART" : "LPUART",
@@ -51,7 +59,9 @@ void uart_open(ZeroMeshApp* app) {
 
 void uart_reopen(ZeroMeshApp* app, FuriHalSerialId new_id, uint32_t new_baud) {
     if(!app) return;
+    if(app->tx_lock) furi_mutex_acquire(app->tx_lock, FuriWaitForever);
     app->uart_id = new_id;
     app->baud = new_baud;
     uart_open(app);
+    if(app->tx_lock) furi_mutex_release(app->tx_lock);
 }
\ No newline at end of file
@@ -0,0 +1,430 @@
+#include "zeromesh_wire.h"
+
+#include <string.h>
+
+#define WIRE_TYPE_ANY 0xFF
+
+void framing_reset(FrameState* fs) {
+    fs->hdr_pos = 0;
+    fs->frame_len = 0;
+    fs->frame_pos = 0;
+}
+
+void framing_init(FrameState* fs) {
+    fs->replay = NULL;
+    fs->replay_len = 0;
+    framing_reset(fs);
+}
+
+static bool check_varint32(const uint8_t** p, const uint8_t* end, uint32_t* out) {
+    uint32_t v = 0;
+    for(uint8_t shift = 0; shift < 35 && *p < end; shift += 7) {
+        uint8_t b = *(*p)++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if(!(b & 0x80)) {
+            *out = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool check_skip_varint(const uint8_t** p, const uint8_t* end) {
+    for(uint8_t i = 0; i < 10 && *p < end; i++) {
+        if(!(*(*p)++ & 0x80)) return true;
+    }
+    return false;
+}
+
+static uint8_t fromradio_wire_type(uint32_t tag) {
+    switch(tag) {
+    case meshtastic_FromRadio_id_tag:
+    case meshtastic_FromRadio_config_complete_id_tag:
+    case meshtastic_FromRadio_rebooted_tag:
+        return PB_WT_VARINT;
+    default:
+        return (tag <= meshtastic_FromRadio_deviceuiConfig_tag) ? PB_WT_STRING : WIRE_TYPE_ANY;
+    }
+}
+
+bool frame_check(const uint8_t* frame, size_t len) {
+    const uint8_t* p = frame;
+    const uint8_t* end = frame + len;
+    bool has_variant = false;
+
+    while(p < end) {
+        uint32_t key;
+        if(!check_varint32(&p, end, &key)) return false;
+        uint32_t tag = key >> 3;
+        uint8_t wt = key & 0x07;
+        if(tag == 0) return false;
+
+        uint8_t want = fromradio_wire_type(tag);
+        if(want != WIRE_TYPE_ANY && wt != want) return false;
+
+        uint32_t n;
+        switch(wt) {
+        case PB_WT_VARINT:
+            if(!check_skip_varint(&p, end)) return false;
+            break;
+        case PB_WT_64BIT:
+            if(end - p < 8) return false;
+            p += 8;
+            break;
+        case PB_WT_STRING:
+            if(!check_varint32(&p, end, &n) || n > (size_t)(end - p)) return false;
+            p += n;
+            break;
+        case PB_WT_32BIT:
+            if(end - p < 4) return false;
+            p += 4;
+            break;
+        default:
+            return false;
+        }
+        if(tag != meshtastic_FromRadio_id_tag) has_variant = true;
+    }
+    return has_variant;
+}
+
+static size_t framing_reject(FrameState* fs, const uint8_t* body, size_t len) {
+    fs->rejected++;
+    framing_reset(fs);
+
+    const uint8_t* p = body;
+    const uint8_t* end = body + len;
+    while((p = memchr(p, ZEROMESH_MAGIC0, (size_t)(end - p))) != NULL) {
+        if(p + 1 == end || p[1] == ZEROMESH_MAGIC1) {
+            fs->resyncs++;
+            return (size_t)(p - body);
+        }
+        p++;
+    }
+    return len;
+}
+
+static void framing_resync_header(FrameState* fs) {
+    if(fs->hdr[2] == ZEROMESH_MAGIC0 && fs->hdr[3] == ZEROMESH_MAGIC1) {
+        fs->hdr[0] = ZEROMESH_MAGIC0;
+        fs->hdr[1] = ZEROMESH_MAGIC1;
+        fs->hdr_pos = 2;
+    } else if(fs->hdr[3] == ZEROMESH_MAGIC0) {
+        fs->hdr[0] = ZEROMESH_MAGIC0;
+        fs->hdr_pos = 1;
+    } else {
+        fs->hdr_pos = 0;
+    }
+    fs->frame_len = 0;
+    fs->frame_pos = 0;
+}
+
+static size_t framing_feed(FrameState* fs, const uint8_t* data, size_t len, const uint8_t** frame) {
+    size_t pos = 0;
+
+    while(pos < len) {
+        if(fs->hdr_pos == 0) {
+            const uint8_t* magic = memchr(data + pos, ZEROMESH_MAGIC0, len - pos);
+            if(!magic) {
+                fs->bad_magic += len - pos;
+                return len;
+            }
+            size_t skipped = (size_t)(magic - (data + pos));
+            fs->bad_magic += skipped;
+            fs->hdr[0] = ZEROMESH_MAGIC0;
+            fs->hdr_pos = 1;
+            pos += skipped + 1;
+            continue;
+        }
+
+        if(fs->hdr_pos < 4) {
+            uint8_t b = data[pos++];
+            if(fs->hdr_pos == 1 && b != ZEROMESH_MAGIC1) {
+                fs->bad_magic++;
+                if(b != ZEROMESH_MAGIC0) fs->hdr_pos = 0;
+                continue;
+            }
+            fs->hdr[fs->hdr_pos++] = b;
+            if(fs->hdr_pos == 4) {
+                fs->frame_len = ((uint16_t)fs->hdr[2] << 8) | (uint16_t)fs->hdr[3];
+                fs->frame_pos = 0;
+                if(fs->frame_len == 0 || fs->frame_len > MAX_FRAME_SIZE) {
+                    fs->bad_len++;
+                    fs->last_bad_len = fs->frame_len;
+                    framing_resync_header(fs);
+                } else if(len - pos >= fs->frame_len) {
+                    if(frame_check(data + pos, fs->frame_len)) {
+                        *frame = data + pos;
+                        fs->frame_pos = fs->frame_len;
+                        return pos + fs->frame_len;
+                    }
+                    pos += framing_reject(fs, data + pos, fs->frame_len);
+                }
+            }
+            continue;
+        }
+
+        size_t take = fs->frame_len - fs->frame_pos;
+        if(take > len - pos) take = len - pos;
+        memmove(fs->frame_buf + fs->frame_pos, data + pos, take);
+        fs->frame_pos += take;
+        pos += take;
+        if(fs->frame_pos == fs->frame_len) {
+            if(frame_check(fs->frame_buf, fs->frame_len)) {
+                *frame = fs->frame_buf;
+                return pos;
+            }
+            size_t frame_len = fs->frame_len;
+            size_t off = framing_reject(fs, fs->frame_buf, frame_len);
+            fs->replay = fs->frame_buf + off;
+            fs->replay_len = (uint16_t)(frame_len - off);
+            return pos;
+        }
+    }
+    return pos;
+}
+
+static bool framing_replay(FrameState* fs, const uint8_t** frame) {
+    while(fs->replay_len > 0) {
+        size_t used = framing_feed(fs, fs->replay, fs->replay_len, frame);
+        fs->replay += used;
+        fs->replay_len -= (uint16_t)used;
+        if(*frame) return true;
+    }
+    return false;
+}
+
+size_t framing_scan(FrameState* fs, const uint8_t* data, size_t len, const uint8_t** frame) {
+    *frame = NULL;
+    if(framing_replay(fs, frame)) return 0;
+
+    size_t used = framing_feed(fs, data, len, frame);
+    if(!*frame) framing_replay(fs, frame);
+    return used;
+}
+
+static bool walk_bytes(pb_istream_t* stream, const uint8_t** buf, size_t* len) {
+    uint32_t n;
+    if(!pb_decode_varint32(stream, &n)) return false;
+    if(n > stream->bytes_left) return false;
+    *buf = (const uint8_t*)stream->state;
+    *len = n;
+    return pb_read(stream, NULL, n);
+}
+
+bool walk_data(const uint8_t* data, size_t len, PacketView* pkt, WirePortFilter wants_payload, void* ctx) {
+    pb_istream_t stream = pb_istream_from_buffer(data, len);
+    while(stream.bytes_left > 0) {
+        pb_wire_type_t wt;
+        uint32_t tag;
+        bool eof;
+        if(!pb_decode_tag(&stream, &wt, &tag, &eof)) return eof;
+        if(tag == meshtastic_Data_portnum_tag && wt == PB_WT_VARINT) {
+            uint32_t port;
+            if(!pb_decode_varint32(&stream, &port)) return false;
+            pkt->portnum = (meshtastic_PortNum)port;
+            if(wants_payload && !wants_payload(ctx, pkt->portnum)) return true;
+        } else if(tag == meshtastic_Data_payload_tag && wt == PB_WT_STRING) {
+            if(!walk_bytes(&stream, &pkt->payload, &pkt->payload_len)) return false;
+        } else if(tag == meshtastic_Data_request_id_tag && wt == PB_WT_32BIT) {
+            if(!pb_decode_fixed32(&stream, &pkt->request_id)) return false;
+        } else {
+            if(!pb_skip_field(&stream, wt)) return false;
+        }
+    }
+    return true;
+}
+
+bool walk_packet(const uint8_t* body, size_t len, PacketView* pkt, const uint8_t** data, size_t* data_len) {
+    pb_istream_t stream = pb_istream_from_buffer(body, len);
+    while(stream.bytes_left > 0) {
+        pb_wire_type_t wt;
+        uint32_t tag;
+        bool eof;
+        if(!pb_decode_tag(&stream, &wt, &tag, &eof)) return eof;
+        if(tag == meshtastic_MeshPacket_from_tag && wt == PB_WT_32BIT) {
+            if(!pb_decode_fixed32(&stream, &pkt->from)) return false;
+        } else if(tag == meshtastic_MeshPacket_to_tag && wt == PB_WT_32BIT) {
+            if(!pb_decode_fixed32(&stream, &pkt->to)) return false;
+        } else if(tag == meshtastic_MeshPacket_channel_tag && wt == PB_WT_VARINT) {
+            uint32_t channel;
+            if(!pb_decode_varint32(&stream, &channel)) return false;
+            pkt->channel = (channel > 0xFF) ? 0xFF : (uint8_t)channel;
+        } else if(tag == meshtastic_MeshPacket_id_tag && wt == PB_WT_32BIT) {
+            if(!pb_decode_fixed32(&stream, &pkt->id)) return false;
+        } else if(tag == meshtastic_MeshPacket_rx_snr_tag && wt == PB_WT_32BIT) {
+            if(!pb_decode_fixed32(&stream, &pkt->rx_snr)) return false;
+        } else if(tag == meshtastic_MeshPacket_rx_rssi_tag && wt == PB_WT_VARINT) {
+            uint64_t rssi;
+            if(!pb_decode_varint(&stream, &rssi)) return false;
+            pkt->rx_rssi = (int32_t)rssi;
+        } else if(tag == meshtastic_MeshPacket_decoded_tag && wt == PB_WT_STRING) {
+            if(!walk_bytes(&stream, data, data_len)) return false;
+            pkt->has_decoded = true;
+        } else {
+            if(!pb_skip_field(&stream, wt)) return false;
+        }
+    }
+    return true;
+}
+
+static bool walk_user(pb_istream_t* stream, NodeInfoView* info) {
+    while(stream->bytes_left > 0) {
+        pb_wire_type_t wt;
+        uint32_t tag;
+        bool eof;
+        if(!pb_decode_tag(stream, &wt, &tag, &eof)) return eof;
+        if(tag == meshtastic_User_long_name_tag && wt == PB_WT_STRING) {
+            if(!walk_bytes(stream, &info->long_name, &info->long_name_len)) return false;
+        } else if(tag == meshtastic_User_short_name_tag && wt == PB_WT_STRING) {
+            if(!walk_bytes(stream, &info->short_name, &info->short_name_len)) return false;
+        } else if(tag == meshtastic_User_hw_model_tag && wt == PB_WT_VARINT) {
+            uint32_t hw;
+            if(!pb_decode_varint32(stream, &hw)) return false;
+            info->hw_model = (uint16_t)hw;
+        } else {
+            if(!pb_skip_field(stream, wt)) return false;
+        }
+    }
+    return true;
+}
+
+bool walk_user_payload(const uint8_t* data, size_t len, NodeInfoView* info) {
+    pb_istream_t stream = pb_istream_from_buffer(data, len);
+    return walk_user(&stream, info);
+}
+
+static bool walk_metrics(pb_istream_t* stream, NodeInfoView* info) {
+    while(stream->bytes_left > 0) {
+        pb_wire_type_t wt;
+        uint32_t tag;
+        bool eof;
+        if(!pb_decode_tag(stream, &wt, &tag, &eof)) return eof;
+        if(tag == meshtastic_DeviceMetrics_battery_level_tag && wt == PB_WT_VARINT) {
+            uint32_t level;
+            if(!pb_decode_varint32(stream, &level)) return false;
+            info->battery_level = (level > 255) ? 255 : (uint8_t)level;
+            info->has_metrics = true;
+        } else if(tag == meshtastic_DeviceMetrics_voltage_tag && wt == PB_WT_32BIT) {
+            if(!pb_decode_fixed32(stream, &info->voltage)) return false;
+            info->has_metrics = true;
+        } else {
+            if(!pb_skip_field(stream, wt)) return false;
+        }
+    }
+    return true;
+}
+
+bool walk_nodeinfo(const uint8_t* body, size_t len, NodeInfoView* info) {
+    pb_istream_t stream = pb_istream_from_buffer(body, len);
+    while(stream.bytes_left > 0) {
+        pb_wire_type_t wt;
+        uint32_t tag;
+        bool eof;
+        if(!pb_decode_tag(&stream, &wt, &tag, &eof)) return eof;
+        if(tag == meshtastic_NodeInfo_num_tag && wt == PB_WT_VARINT) {
+            if(!pb_decode_varint32(&stream, &info->num)) return false;
+        } else if(tag == meshtastic_NodeInfo_snr_tag && wt == PB_WT_32BIT) {
+            if(!pb_decode_fixed32(&stream, &info->snr)) return false;
+        } else if(tag == meshtastic_NodeInfo_last_heard_tag && wt == PB_WT_32BIT) {
+            if(!pb_decode_fixed32(&stream, &info->last_heard)) return false;
+        } else if(
+            (tag == meshtastic_NodeInfo_user_tag || tag == meshtastic_NodeInfo_device_metrics_tag) &&
+            wt == PB_WT_STRING) {
+            pb_istream_t sub;
+            if(!pb_make_string_substream(&stream, &sub)) return false;
+            bool ok = (tag == meshtastic_NodeInfo_user_tag) ? walk_user(&sub, info) :
+                                                              walk_metrics(&sub, info);
+            if(!pb_close_string_substream(&stream, &sub) || !ok) return false;
+        } else {
+            if(!pb_skip_field(&stream, wt)) return false;
+        }
+    }
+    return true;
+}
+
+bool walk_queue_status(const uint8_t* body, size_t len, meshtastic_QueueStatus* qs) {
+    pb_istream_t stream = pb_istream_from_buffer(body, len);
+    *qs = (meshtastic_QueueStatus)meshtastic_QueueStatus_init_zero;
+    while(stream.bytes_left > 0) {
+        pb_wire_type_t wt;
+        uint32_t tag;
+        bool eof;
+        if(!pb_decode_tag(&stream, &wt, &tag, &eof)) return eof;
+        uint64_t value;
+        if(wt != PB_WT_VARINT) {
+            if(!pb_skip_field(&stream, wt)) return false;
+            continue;
+        }
+        if(!pb_decode_varint(&stream, &value)) return false;
+        if(tag == meshtastic_QueueStatus_res_tag) {
+            qs->res = (int32_t)value;
+        } else if(tag == meshtastic_QueueStatus_free_tag) {
+            qs->free = (uint32_t)value;
+        } else if(tag == meshtastic_QueueStatus_maxlen_tag) {
+            qs->maxlen = (uint32_t)value;
+        } else if(tag == meshtastic_QueueStatus_mesh_packet_id_tag) {
+            qs->mesh_packet_id = (uint32_t)value;
+        }
+    }
+    return true;
+}
+
+bool walk_channel(const uint8_t* body, size_t len, uint32_t* index, uint32_t* role) {
+    pb_istream_t stream = pb_istream_from_buffer(body, len);
+    *index = 0;
+    *role = 0;
+    while(stream.bytes_left > 0) {
+        pb_wire_type_t wt;
+        uint32_t tag;
+        bool eof;
+        if(!pb_decode_tag(&stream, &wt, &tag, &eof)) return eof;
+        if(tag == meshtastic_Channel_index_tag && wt == PB_WT_VARINT) {
+            if(!pb_decode_varint32(&stream, index)) return false;
+        } else if(tag == meshtastic_Channel_role_tag && wt == PB_WT_VARINT) {
+            if(!pb_decode_varint32(&stream, role)) return false;
+        } else {
+            if(!pb_skip_field(&stream, wt)) return false;
+        }
+    }
+    return true;
+}
+
+bool walk_fromradio(const uint8_t* frame, size_t len, FromRadioView* view) {
+    pb_istream_t stream = pb_istream_from_buffer(frame, len);
+    view->variant = 0;
+    while(stream.bytes_left > 0) {
+        pb_wire_type_t wt;
+        uint32_t tag;
+        bool eof;
+        if(!pb_decode_tag(&stream, &wt, &tag, &eof)) return eof;
+        if(tag == meshtastic_FromRadio_id_tag) {
+            if(!pb_skip_field(&stream, wt)) return false;
+        } else if(wt == PB_WT_STRING) {
+            if(!walk_bytes(&stream, &view->body, &view->body_len)) return false;
+            view->variant = (pb_size_t)tag;
+        } else if(wt == PB_WT_VARINT) {
+            if(!pb_decode_varint32(&stream, &view->value)) return false;
+            view->variant = (pb_size_t)tag;
+        } else {
+            if(!pb_skip_field(&stream, wt)) return false;
+        }
+    }
+    return true;
+}
+
+bool walk_routing(const uint8_t* data, size_t len, uint32_t* error) {
+    pb_istream_t stream = pb_istream_from_buffer(data, len);
+    *error = 0;
+    while(stream.bytes_left > 0) {
+        pb_wire_type_t wt;
+        uint32_t tag;
+        bool eof;
+        if(!pb_decode_tag(&stream, &wt, &tag, &eof)) return eof;
+        if(tag == meshtastic_Routing_error_reason_tag && wt == PB_WT_VARINT) {
+            if(!pb_decode_varint32(&stream, error)) return false;
+        } else {
+            if(!pb_skip_field(&stream, wt)) return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lib/nanopb/pb.h"
+#include "lib/nanopb/pb_decode.h"
+
+#include "lib/meshtastic_api/meshtastic/mesh.pb.h"
+#include "lib/meshtastic_api/meshtastic/portnums.pb.h"
+
+#define ZEROMESH_MAGIC0 0x94
+#define ZEROMESH_MAGIC1 0xC3
+
+#define MAX_FRAME_SIZE 512
+
+typedef struct {
+    uint8_t hdr[4];
+    uint8_t hdr_pos;
+    uint16_t frame_len;
+    uint16_t frame_pos;
+    uint16_t last_bad_len;
+    uint32_t bad_magic;
+    uint32_t bad_len;
+    uint32_t rejected;
+    uint32_t resyncs;
+    const uint8_t* replay;
+    uint16_t replay_len;
+    uint8_t frame_buf[MAX_FRAME_SIZE];
+} FrameState;
+
+typedef struct {
+    uint32_t from;
+    uint32_t to;
+    uint32_t id;
+    uint32_t request_id;
+    uint8_t channel;
+    float rx_snr;
+    int32_t rx_rssi;
+    bool has_decoded;
+    meshtastic_PortNum portnum;
+    const uint8_t* payload;
+    size_t payload_len;
+} PacketView;
+
+typedef struct {
+    uint32_t num;
+    uint32_t last_heard;
+    float snr;
+    uint16_t hw_model;
+    bool has_metrics;
+    uint8_t battery_level;
+    float voltage;
+    const uint8_t* long_name;
+    size_t long_name_len;
+    const uint8_t* short_name;
+    size_t short_name_len;
+} NodeInfoView;
+
+typedef struct {
+    pb_size_t variant;
+    const uint8_t* body;
+    size_t body_len;
+    uint32_t value;
+} FromRadioView;
+
+typedef bool (*WirePortFilter)(void* ctx, meshtastic_PortNum port);
+
+void framing_init(FrameState* fs);
+void framing_reset(FrameState* fs);
+bool frame_check(const uint8_t* frame, size_t len);
+size_t framing_scan(FrameState* fs, const uint8_t* data, size_t len, const uint8_t** frame);
+
+bool walk_fromradio(const uint8_t* frame, size_t len, FromRadioView* view);
+bool walk_packet(const uint8_t* body, size_t len, PacketView* pkt, const uint8_t** data, size_t* data_len);
+bool walk_data(const uint8_t* data, size_t len, PacketView* pkt, WirePortFilter wants_payload, void* ctx);
+bool walk_nodeinfo(const uint8_t* body, size_t len, NodeInfoView* info);
+bool walk_user_payload(const uint8_t* data, size_t len, NodeInfoView* info);
+bool walk_channel(const uint8_t* body, size_t len, uint32_t* index, uint32_t* role);
+bool walk_queue_status(const uint8_t* body, size_t len, meshtastic_QueueStatus* qs);
+bool walk_routing(const uint8_t* data, size_t len, uint32_t* error);